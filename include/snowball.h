@@ -137,9 +137,9 @@ SZ_DEF_END
 
 // Version numbers
 //! @brief Major version number of libsnowball.
-#define SZ_VERSION_MAJOR      1
+#define SZ_VERSION_MAJOR      2
 //! @brief Minor version number of libsnowball.
-#define SZ_VERSION_MINOR      2
+#define SZ_VERSION_MINOR      0
 //! @brief Reivsion number of libsnowball.
 #define SZ_VERSION_REVISION   0
 
@@ -147,43 +147,9 @@ SZ_DEF_END
 SZ_DEF_BEGIN
 
 
-#define SZ_BIG_ENDIAN    1
-#define SZ_LITTLE_ENDIAN 0
-// The endianness used by snowball files. By default, uses little endian,
-// because that's the usual endianness client-side.
-#ifndef SZ_BASE_ENDIANNESS
-# define SZ_BASE_ENDIANNESS SZ_LITTLE_ENDIAN
-#endif
-// mixed/pdp endianness not supported and probably never will be
-
-// Host endianness.
-// Little endian by default, as big endian isn't used anywhere I use snowball.
-// It might be worthwhile to later replace this with something inserted at
-// compile time or a configuration stage.
-#ifndef SZ_ENDIANNESS
-# define SZ_ENDIANNESS SZ_LITTLE_ENDIAN
-#endif
-
-#if SZ_ENDIANNESS != SZ_BASE_ENDIANNESS
-
-SZ_EXPORT
-uint32_t
-sz_ntohl(uint32_t i);
-
-SZ_EXPORT
-uint16_t
-sz_ntohs(uint16_t i);
-
-# define sz_htonl(i) sz_ntohl((i))
-# define sz_htons(i) sz_ntohs((i))
-
-#else
-// Base endianness is host endianness
-# define sz_ntohl(i) (i)
-# define sz_ntohs(i) (i)
-# define sz_htonl(i) (i)
-# define sz_htons(i) (i)
-#endif
+// Snowballs are written in the writer's byte order, which is recorded in the
+// snowball, and readers swap bytes only when their own byte order differs, so
+// there's no endianness to configure. Mixed/pdp endianness isn't supported.
 
 
 //! @brief Magic number type. Intended for use as a uint32_t.
@@ -195,8 +161,11 @@ typedef enum e_sz_magic SZ_TYPE_ENUM(uint32_t)
     Magic number placed at the head of every serialized stream as part of the
     file root. First two bytes are always SZ, last two bytes are an ASCII
     format version number.
+
+    Format version 03 uses 64-bit chunk sizes and compound offsets, so a
+    snowball may exceed 4 GB. Readers also accept version 02 snowballs.
   */
-  SZ_MAGIC = 0x32305A53
+  SZ_MAGIC = 0x33305A53
 } sz_magic_t;
 
 
@@ -244,10 +213,18 @@ typedef enum e_sz_chunk_id SZ_TYPE_ENUM(uint32_t)
     whose pointer is NULL or length is 0.
   */
   SZ_NULL_POINTER_CHUNK = 8,
-  //! @brief 64-bit float chunk -- currently unused.
+  //! @brief 64-bit float chunk.
   SZ_DOUBLE_CHUNK = 9,
   //! @brief Main data chunk.
   SZ_DATA_CHUNK = 10,
+  //! @brief Signed 64-bit int chunk.
+  SZ_SINT64_CHUNK = 11,
+  //! @brief Unsigned 64-bit int chunk.
+  SZ_UINT64_CHUNK = 12,
+  //! @brief Signed 16-bit int chunk.
+  SZ_SINT16_CHUNK = 13,
+  //! @brief Signed 8-bit int chunk.
+  SZ_SINT8_CHUNK = 14,
 } sz_chunk_id_t;
 
 
@@ -316,6 +293,161 @@ typedef enum e_sz_response SZ_TYPE_ENUM(int)
 } sz_response_t;
 
 
+//! @brief Largest payload alignment that may be passed to sz_set_alignment().
+#define SZ_MAX_ALIGNMENT (4096)
+
+
+/*!
+  @brief Context flags.
+
+  Flags that change how a context reads or writes a snowball. Set them with
+  sz_set_flags() before opening the context. Flags that don't apply to a
+  context's mode are ignored.
+
+  @ingroup contexts
+*/
+typedef enum e_sz_flag
+{
+  /*!
+    @brief Writers: write compounds to the stream as they're completed.
+
+    By default, a writer holds the whole snowball in memory until it's closed,
+    since the root must precede everything else. With this flag set, the writer
+    instead writes a placeholder root when opened, writes each compound to the
+    stream once its writer function returns, and writes the root over the
+    placeholder when closed. Only the main data and compounds still being
+    written are held in memory.
+
+    The stream must support seeking back to where the root was written.
+  */
+  SZ_STREAMING_WRITES = 1 << 0,
+
+  /*!
+    @brief Writers: use compact chunk headers.
+
+    Encodes each chunk header as a kind byte, an index into a table of the
+    snowball's chunk names, and a variable-length payload size, rather than as
+    a fixed 16 bytes. This usually shrinks snowballs made up of many small
+    fields considerably. Readers detect compact headers on their own, so this
+    flag is only needed when writing.
+  */
+  SZ_COMPACT_HEADERS = 1 << 1,
+
+  /*!
+    @brief Writers: write a name index for the data chunk and each compound.
+
+    Each index maps the names of a compound's fields to where they are in the
+    compound. When reading a snowball with name indices, fields may be read in
+    any order: if the next field doesn't have the requested name, the reader
+    looks the name up in the index and seeks to it. Fields sharing a name are
+    found in the order they were written. Readers detect name indices on
+    their own, so this flag is only needed when writing.
+  */
+  SZ_NAME_INDEX = 1 << 2,
+
+  /*!
+    @brief Readers: read the whole snowball into memory when opened.
+
+    By default, a reader reads its stream a few kilobytes at a time as fields
+    are read, seeking as needed to follow compounds. With this flag set, the
+    reader instead reads the entire snowball with a single read once it knows
+    its size, and every later read is served from memory. This suits small
+    snowballs that are read in full, where it replaces many reads and seeks
+    with one. View ops (e.g., sz_read_floats_view()) on a preloaded context
+    return pointers into the context's memory, which remain valid until the
+    context is next opened, reset, or destroyed. Memory-backed streams (see
+    sz_stream_memopen()) are always read in place, so the flag has no effect
+    on them.
+  */
+  SZ_PRELOAD = 1 << 3
+} sz_flag_t;
+
+
+/*!
+  @brief Array encodings.
+
+  Encodings that arrays can be written with (e.g., by sz_write_encoded_ints())
+  to store their elements in less space than as-is. Each encoding only
+  applies to some element types. If an encoding wouldn't make an array any
+  smaller, the array is stored as-is instead. Encodings are lossless unless
+  noted as lossy, in which case the values read back are approximations of
+  the values written.
+
+  Readers decode encoded arrays transparently, so they're read with the usual
+  read ops (e.g., sz_read_ints()). Encoded arrays can't be viewed (see
+  sz_read_floats_view()) or read in windows (see sz_begin_array()).
+*/
+typedef enum e_sz_array_encoding SZ_TYPE_ENUM(uint32_t)
+{
+  //! @brief Elements are stored as-is.
+  SZ_ENCODING_NONE = 0,
+  /*!
+    @brief Variable-length integers, for 32-bit int arrays.
+
+    Each value takes 1 to 4 bytes depending on its magnitude, laid out as in
+    Stream VByte so they decode quickly with SIMD. Signed values are zigzag
+    encoded first, so small negative values take little space too. Suits
+    arrays of mostly small values, such as indices and counts.
+  */
+  SZ_ENCODING_VARINT = 1,
+  /*!
+    @brief Bit-packed deltas, for 32- and 64-bit int arrays.
+
+    Each value is stored as its difference from the previous value. Deltas
+    are grouped in blocks of 128, each packed at the fewest bits needed to
+    hold its range of deltas. Suits sorted or clustered arrays, such as IDs
+    and timestamps, which often pack to a few bits per value.
+  */
+  SZ_ENCODING_PACKED_DELTAS = 2,
+  /*!
+    @brief Byte-shuffled and compressed, for float and double arrays.
+
+    The bytes of each value are regrouped so that like bytes (e.g., the
+    exponents) of all values are stored together, then compressed. Lossless.
+    Suits arrays of values of similar magnitude, such as vertex positions,
+    normals and texture coordinates.
+  */
+  SZ_ENCODING_SHUFFLE = 3,
+  /*!
+    @brief As SZ_ENCODING_SHUFFLE, but stores each value XORed with the one
+    before it.
+
+    Suits arrays where each value is close to the previous one, such as
+    time series and animation curves, as the bits neighbouring values share
+    become zeroes that compress well.
+  */
+  SZ_ENCODING_XOR_SHUFFLE = 4,
+  /*!
+    @brief IEEE half-precision floats, for float arrays. Lossy.
+
+    Each float is rounded to the nearest half-precision float, which keeps
+    about 3 significant decimal digits and a range of up to 65504. Values
+    outside that range become infinities. Suits normals, colors and other
+    values of modest range and precision.
+  */
+  SZ_ENCODING_HALF = 5,
+  /*!
+    @brief bfloat16 floats, for float arrays. Lossy.
+
+    Each float is rounded to its upper 16 bits, which keeps the full range of
+    a float but only about 2 significant decimal digits. Suits values of wide
+    range where precision matters little, such as weights.
+  */
+  SZ_ENCODING_BFLOAT16 = 6,
+  /*!
+    @brief 16-bit levels between the array's smallest and largest value, for
+    float arrays. Lossy.
+
+    Each float is rounded to the nearest of 65536 evenly spaced levels
+    between the smallest and largest finite values in the array. NaNs are
+    read back as the smallest value and infinities as the nearest end of the
+    range. Suits values of known range, such as texture coordinates and
+    blend weights.
+  */
+  SZ_ENCODING_QUANTIZED16 = 7
+} sz_array_encoding_t;
+
+
 /*!
   @brief Context and stream modes.
 
@@ -535,6 +667,23 @@ struct s_sz_allocator
 
 typedef struct s_sz_stream sz_stream_t;
 
+
+/*!
+  @brief A buffer to write as part of a vectored write.
+
+  Describes one of several buffers passed to a stream's writev function. Mirrors
+  POSIX's struct iovec.
+
+  @ingroup streams
+*/
+typedef struct s_sz_iovec
+{
+  //! @brief Address of the buffer.
+  const void *base;
+  //! @brief Number of bytes in the buffer.
+  size_t length;
+} sz_iovec_t;
+
 /*!
   @defgroup streams Streams
   @brief Streams and stream functions.
@@ -555,7 +704,7 @@ typedef struct s_sz_stream sz_stream_t;
   functionality so as to avoid getting bogged down with things like formatting
   and so on.
 
-  As a result, only five operations are supported:
+  As a result, only five operations are required:
 
   - Read
   - Write
@@ -565,6 +714,22 @@ typedef struct s_sz_stream sz_stream_t;
 
   The last is special in that it requires both that the stream be closed and
   all memory associated with the stream be freed (including the stream itself).
+
+  Streams may additionally provide a view operation for reading data in place
+  and a vectored write operation for writing several buffers at once. Both are
+  optional and may be NULL. Without a view operation, anything depending on it
+  (e.g., sz_read_floats_view()) fails. Without a vectored write operation,
+  sz_stream_writev() falls back to writing each buffer in turn.
+
+  Any operation that isn't NULL is called, so a stream must be
+  zero-initialized (e.g., allocated with calloc() or declared with
+  `sz_stream_t ops = { 0 };`) before its operations are set. This matters
+  for custom streams written against libsnowball 1.x, which had only the
+  five required operations: such a stream left uninitialized has garbage in
+  place of the optional operations and must be updated to zero the struct.
+  The struct only ever grows at its end, with optional operations, and
+  growing it bumps the major version (see SZ_VERSION_MAJOR).
+
   There is no tell operation, as seek must return the resulting offset into the
   stream, therefore making any seek to an offset of 0 from the current position
   the same as a tell. Streams should optimize for that case when used for
@@ -600,6 +765,9 @@ struct s_sz_stream
 
     Seeks to the given offset (only SEEK_CUR and SEEK_SET need to be
     supported). Returns the resulting offset into the stream.
+
+    libsnowball is built with a 64-bit off_t (_FILE_OFFSET_BITS=64), so code
+    implementing or calling this on 32-bit systems must be as well.
   */
   off_t (*seek)(off_t off, int whence, sz_stream_t *stream);
 
@@ -621,6 +789,28 @@ struct s_sz_stream
     accessed again.
   */
   void (*close)(sz_stream_t *stream);
+
+  /*!
+    @brief Returns a pointer to the next length bytes of a stream in place.
+
+    Optional, must be NULL if not implemented. Returns a pointer to the next
+    length bytes of the stream without copying them and advances the stream
+    past them, as a read would. If the bytes can't be provided in place,
+    returns NULL and leaves the stream's position unchanged. Memory returned
+    by a view must remain valid and unmodified until the stream is closed.
+    Added in libsnowball 2.0.
+  */
+  const void *(*view)(size_t length, sz_stream_t *stream);
+
+  /*!
+    @brief Writes count buffers to a stream in order.
+
+    Optional, must be NULL if not implemented. Writes each of the count
+    buffers in iov to the stream, one after another, and returns the total
+    number of bytes written. As with write, anything other than the combined
+    length of the buffers is treated as an error. Added in libsnowball 2.0.
+  */
+  size_t (*writev)(const sz_iovec_t *iov, size_t count, sz_stream_t *stream);
 };
 
 
@@ -646,6 +836,83 @@ SZ_EXPORT
 sz_stream_t *
 sz_stream_fopen(const char *filename, sz_mode_t mode, sz_allocator_t *alloc);
 
+/*!
+  @brief Opens a stream over a file descriptor using positional I/O.
+
+  Returns an sz_stream_t that reads and writes fd with pread and pwrite at a
+  position held by the stream itself, starting from the descriptor's current
+  offset (or 0 if it has none). Seeking only moves the stream's position, so
+  it's cheap, and since the descriptor's own offset is never used, several
+  streams may share one descriptor.
+
+  The stream does not take ownership of fd: closing the stream leaves the
+  descriptor open, and it must remain open until the stream is closed.
+
+  If alloc is null, the function uses the default allocator.
+
+  @param fd
+    An open file descriptor. Must be readable if mode is SZ_READER and
+    writable if mode is SZ_WRITER.
+  @param mode
+    The mode to open in: either read or write.
+  @param alloc
+    The allocator to use when allocating the stream object.
+  @return
+    A stream object for the descriptor, or NULL if fd is invalid.
+*/
+SZ_EXPORT
+sz_stream_t *
+sz_stream_fdopen(int fd, sz_mode_t mode, sz_allocator_t *alloc);
+
+/*!
+  @brief Opens a read-only, memory-mapped file stream.
+
+  Maps the given file into memory and returns a read-only stream over it. Reads
+  from the stream are copies out of the mapping, and the stream supports views,
+  so it can be used with sz_read_floats_view() and related functions to access
+  arrays in place. Reader contexts recognize the stream and read the mapping
+  directly instead of through the stream's ops. The mapping is released when
+  the stream is closed.
+
+  If alloc is null, the function uses the default allocator.
+
+  @param filename
+    The path of the file to map.
+  @param alloc
+    The allocator to use when allocating the stream object.
+  @return
+    A stream object for the mapped file, or NULL if the file could not be
+    opened or mapped.
+*/
+SZ_EXPORT
+sz_stream_t *
+sz_stream_mmap(const char *filename, sz_allocator_t *alloc);
+
+/*!
+  @brief Opens a read-only stream over a block of memory.
+
+  Returns a read-only stream over the length bytes at data, which behaves like
+  a stream from sz_stream_mmap() -- it supports views, and readers use the
+  memory in place rather than copying it. The memory is not copied and
+  belongs to the caller. It must remain valid and unmodified until the stream
+  is closed, and closing the stream doesn't free it.
+
+  If alloc is null, the function uses the default allocator.
+
+  @param data
+    The memory to read from. May only be NULL if length is 0.
+  @param length
+    The size of the memory in bytes.
+  @param alloc
+    The allocator to use when allocating the stream object.
+  @return
+    A stream object over the memory, or NULL if data is NULL with a nonzero
+    length or the stream couldn't be allocated.
+*/
+SZ_EXPORT
+sz_stream_t *
+sz_stream_memopen(const void *data, size_t length, sz_allocator_t *alloc);
+
 /*!
   @brief Returns a stream that is functionally equivalent to `/dev/null`.
 
@@ -702,6 +969,27 @@ SZ_EXPORT
 size_t
 sz_stream_write(const void *in, size_t length, sz_stream_t *stream);
 
+/*!
+  @brief Writes several buffers to a stream in order.
+
+  Writes count buffers to a stream as if by consecutive calls to
+  sz_stream_write(), returning the total number of bytes written. If the
+  stream's writev function isn't NULL, the buffers are passed to it in one
+  call, so streams without one must be zero-initialized (see sz_stream_t).
+
+  @param iov
+    The buffers to write.
+  @param count
+    The number of buffers in iov.
+  @param stream
+    A stream to write to.
+  @return
+    The number of bytes written.
+*/
+SZ_EXPORT
+size_t
+sz_stream_writev(const sz_iovec_t *iov, size_t count, sz_stream_t *stream);
+
 /*!
   @brief Seeks from a point to an offset in a stream.
 
@@ -735,6 +1023,25 @@ SZ_EXPORT
 off_t
 sz_stream_tell(sz_stream_t *stream);
 
+/*!
+  @brief Returns a pointer to the next length bytes of a stream in place.
+
+  Calls the stream's view function, if it has one, returning a pointer to the
+  next length bytes of the stream and advancing the stream past them. The
+  memory belongs to the stream and is valid until the stream is closed.
+
+  @param length
+    The number of bytes to view.
+  @param stream
+    A stream to view bytes from.
+  @return
+    A pointer to the bytes, or NULL if the stream doesn't support views or
+    can't provide length bytes in place.
+*/
+SZ_EXPORT
+const void *
+sz_stream_view(size_t length, sz_stream_t *stream);
+
 /*!
   @brief Returns whether a stream is at its EOF (or something equivalent).
 
@@ -886,6 +1193,58 @@ SZ_EXPORT
 void *
 sz_malloc(size_t size, sz_allocator_t *allocator);
 
+//! @brief Block size used by sz_arena_new() when given a block size of 0.
+#define SZ_DEFAULT_ARENA_BLOCK_SIZE (65536)
+
+/*!
+  @brief Creates an arena allocator.
+
+  Returns an allocator that hands out memory from large blocks, one after
+  another, and whose free function does nothing. Everything allocated from it
+  is released at once by sz_arena_reset() or sz_arena_destroy(). This makes it
+  a cheap place to read a snowball's arrays and bytes into -- see
+  sz_set_buffer_allocator() -- since they can all be discarded together
+  instead of freed one by one.
+
+  Allocations are aligned to 16 bytes. Allocations larger than a quarter of
+  the block size get blocks of their own. Arenas are not thread-safe.
+
+  @param block_size
+    The size in bytes of the blocks the arena allocates. If 0, uses
+    SZ_DEFAULT_ARENA_BLOCK_SIZE.
+  @param alloc
+    The allocator to allocate the arena and its blocks with. If NULL, uses the
+    default allocator.
+  @return
+    The arena, or NULL if it could not be allocated.
+*/
+SZ_EXPORT
+sz_allocator_t *
+sz_arena_new(size_t block_size, sz_allocator_t *alloc);
+
+/*!
+  @brief Releases everything allocated from an arena.
+
+  All memory previously returned by the arena becomes invalid. The arena keeps
+  one of its blocks for reuse and can be allocated from again.
+
+  @param arena
+    An arena returned by sz_arena_new(). Anything else is ignored.
+*/
+SZ_EXPORT
+void
+sz_arena_reset(sz_allocator_t *arena);
+
+/*!
+  @brief Destroys an arena, releasing everything allocated from it.
+
+  @param arena
+    An arena returned by sz_arena_new(). Anything else is ignored.
+*/
+SZ_EXPORT
+void
+sz_arena_destroy(sz_allocator_t *arena);
+
 //! @}
 
 
@@ -980,6 +1339,32 @@ SZ_EXPORT
 sz_response_t
 sz_close(sz_context_t *ctx);
 
+/*!
+  @brief Resets a context so it can be used for another snowball.
+
+  Returns a context to the state it was in when created, except that it keeps
+  its flags and alignment along with the memory it has allocated -- buffers,
+  tables, and so on -- so that reading or writing the next snowball allocates
+  little or nothing once the context has seen a snowball of similar size. If
+  the context is open, it's closed without finishing de/serialization, so an
+  open writer's data is discarded rather than written. The context's stream is
+  unset and must be set again with sz_set_stream() before reopening it.
+
+  Contexts keep their memory after sz_close() as well, so reusing a context
+  without resetting it also avoids reallocation. Memory is only released by
+  sz_destroy_context().
+
+  @param ctx
+    The context to reset.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_reset_context(sz_context_t *ctx);
+
 /////////// Attributes (use before sz_open)
 
 // Input / output file
@@ -1002,6 +1387,83 @@ SZ_EXPORT
 sz_response_t
 sz_set_stream(sz_context_t *ctx, sz_stream_t *stream);
 
+/*!
+  @brief Sets a context's flags.
+
+  Sets flags, a combination of sz_flag_t values, that change how the context
+  reads or writes. This must be called before opening a context and may not be
+  called again until the context has been closed. Contexts have no flags set
+  by default.
+
+  @param ctx
+    A context to set flags for.
+  @param flags
+    A bitwise OR of sz_flag_t values, or 0 for none.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_set_flags(sz_context_t *ctx, uint32_t flags);
+
+/*!
+  @brief Sets the alignment of a writer's array and bytes payloads.
+
+  Pads a writer's snowball so that the data of every array and bytes chunk is
+  aligned to the given number of bytes from the start of the snowball. If the
+  snowball starts at an aligned offset in its file, as it does when it's at
+  the start of the file, in-place views of the snowball's arrays (e.g., from
+  sz_read_floats_view() on a memory-mapped stream) are aligned as well, which
+  allows aligned SIMD loads from them. Readers detect the alignment on their
+  own, so this has no effect on them. The default alignment is 1 (no padding).
+
+  This must be called before opening a context.
+
+  @param ctx
+    A context to set the alignment for.
+  @param alignment
+    The alignment in bytes. Must be a power of two no greater than
+    SZ_MAX_ALIGNMENT. Typical values are 16 for SSE, 32 for AVX, and 64 for
+    cache lines or AVX-512.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_set_alignment(sz_context_t *ctx, uint32_t alignment);
+
+/*!
+  @brief Sets the allocator a reader uses for the buffers it returns.
+
+  Read ops that return newly allocated memory -- arrays, bytes, and arrays of
+  compounds (e.g., sz_read_floats(), sz_read_bytes(), sz_read_compounds()) --
+  take an allocator for it, and use the default allocator if that's NULL. With
+  this set, they use alloc instead whenever they're passed NULL. Pairing this
+  with an arena (see sz_arena_new()) lets everything a snowball's reads
+  allocate be released with a single sz_arena_reset().
+
+  Writers don't return buffers, so this has no effect on them. The allocator
+  is kept when the context is reset.
+
+  This must be called before opening a context.
+
+  @param ctx
+    A context to set the buffer allocator for.
+  @param alloc
+    The allocator to use, or NULL to use the default allocator again.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_set_buffer_allocator(sz_context_t *ctx, sz_allocator_t *alloc);
+
 /*!
   @brief Get an error string describing the most recent error in a context.
 
@@ -1026,6 +1488,26 @@ sz_get_error(sz_context_t *ctx);
 /*! @name Write Ops */
 //! @{
 
+/*!
+  @brief Reserves space for a number of compounds in a writer.
+
+  Preallocates a writer's bookkeeping for the given number of distinct
+  compounds, so writing that many doesn't have to grow it along the way. This
+  is only an optimization -- writers grow as needed either way.
+
+  @param ctx
+    A writer context.
+  @param count
+    The total number of distinct compounds expected to be written.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_reserve_compounds(sz_context_t *ctx, size_t count);
+
 /*!
   @brief Writes a compound to a context.
 
@@ -1091,18 +1573,41 @@ sz_write_compounds(
   );
 
 /*!
-  @brief Writes an array of bytes to a context.
+  @brief Writes an array of compounds to a context using multiple threads.
 
-  Writes an array of bytes with the given length to a context.
+  Writes an array of compound objects like sz_write_compounds(), but calls the
+  compound writer for the array's compounds on up to num_threads threads at
+  once, the calling thread included. Each call to the writer gets its own
+  context to write the compound to, which may be used with any `sz_write_`
+  function (including nested compounds) but may not be closed or reset.
+
+  Compound indices and, with SZ_COMPACT_HEADERS, name table entries are
+  assigned in the same order regardless of the number of threads, so the
+  snowball written is the same whether it's written with one thread or many.
+
+  If a call to the writer fails to write to its context, the array isn't
+  written and this fails with that call's error, taking the first failed
+  compound in array order if there are several.
 
+  @remarks The compound writer must be safe to call from multiple threads at
+  once, as must the context's allocator. Compounds referred to by more than one
+  of the array's compounds, and not in the array themselves, may be written
+  more than once, though only one copy ends up in the snowball.
+
+  @param compounds_in
+    An array of compounds to write.
+  @param length
+    The number of compounds to write.
   @param ctx
     A context to write to.
   @param name
     The name of the chunk to write.
-  @param values
-    An array of bytes to write.
-  @param length
-    The number of bytes to write.
+  @param writer
+    The compound writer function. May not be NULL.
+  @param writer_ctx
+    Opaque pointer passed to the compound writer. May be NULL.
+  @param num_threads
+    The greatest number of threads to use, or 0 to use one per processor.
   @return
     A response code. SZ_SUCCESS on success, otherwise an error.
 
@@ -1110,19 +1615,49 @@ sz_write_compounds(
 */
 SZ_EXPORT
 sz_response_t
-sz_write_bytes(
-  const void *values,
+sz_write_compounds_parallel(
+  void **compounds_in,
   size_t length,
   sz_context_t *ctx,
-  uint32_t name
+  uint32_t name,
+  sz_compound_writer_fn_t *writer,
+  void *writer_ctx,
+  size_t num_threads
   );
 
 /*!
-  @brief Writes a float to a context.
+  @brief Writes an array of bytes to a context.
 
-  Writes a single float to the context with the given name.
+  Writes an array of bytes with the given length to a context.
 
-  @param value
+  @param ctx
+    A context to write to.
+  @param name
+    The name of the chunk to write.
+  @param values
+    An array of bytes to write.
+  @param length
+    The number of bytes to write.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_write_bytes(
+  const void *values,
+  size_t length,
+  sz_context_t *ctx,
+  uint32_t name
+  );
+
+/*!
+  @brief Writes a float to a context.
+
+  Writes a single float to the context with the given name.
+
+  @param value
     The float to write.
   @param ctx
     A context to read from.
@@ -1259,32 +1794,39 @@ sz_write_unsigned_ints(
   uint32_t name
   );
 
-//! @}
+/*!
+  @brief Writes a double to a context.
 
+  Writes a single double to the context with the given name.
 
-/*! @name Read Ops */
-//! @{
+  @param value
+    The double to write.
+  @param ctx
+    A context to write to.
+  @param name
+    The name of the chunk to write.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
 
-/*!
-  @brief Reads a compound from a context.
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_write_double(double value, sz_context_t *ctx, uint32_t name);
 
-  @brief Reads a serialized compound object.
+/*!
+  @brief Writes an array of doubles to a context.
 
-  Reads a compound object from a reader context with the given name using a
-  compound reader function.
+  Writes an array of doubles to the context with the given name.
 
-  @param compound_out
-    A pointer to write the compound pointer to. There are more confusing ways
-    to word this parameter's description.
+  @param values
+    An array of doubles to write.
+  @param length
+    The number of doubles to write.
   @param ctx
-    A context to read from.
+    A context to write to.
   @param name
-    The name of the chunk to read.
-  @param reader
-    The function used to read the compound. May not be null. If the compound
-    was previously deserialized, this function will not be called.
-  @param reader_ctx
-    Opaque data pointer passed to the reader function as context. May be null.
+    The name of the chunk to write.
   @return
     A response code. SZ_SUCCESS on success, otherwise an error.
 
@@ -1292,47 +1834,24 @@ sz_write_unsigned_ints(
 */
 SZ_EXPORT
 sz_response_t
-sz_read_compound(
-  void **compound_out,
+sz_write_doubles(
+  double *values,
+  size_t length,
   sz_context_t *ctx,
-  uint32_t name,
-  sz_compound_reader_fn_t *reader,
-  void *reader_ctx
+  uint32_t name
   );
 
 /*!
-  @brief Reads an array of compounds from a context.
+  @brief Writes a 64-bit signed int to a context.
 
-  Reads an array of compound objects with the given name using a compound
-  reader function. The returned array of objects must be freed by the caller
-  using the allocator provided by the caller. The returned array is an array
-  of pointers, so your output argument is a pointer to an array of pointer.
-  I only feel the need to mention this because `void ***` is a scary type
-  for obvious reasons.
+  Writes a single 64-bit signed int to the context with the given name.
 
-  @param compounds_out
-    A pointer to a pointer that will receive the array. May be null, in which
-    case no array is allocated and the chunk is effectively skipped
-    if it matches. If *compounds_out is null, a buffer is allocated using the
-    provided allocator and returned via *compounds_out. Otherwise, it is
-    assumed that you have passed a pre-allocated buffer of the correct or
-    greater size and want the compound pointers written to it.
-  @param length
-    A pointer to a size_t that will receive the length of the array.
-    May be null.
+  @param value
+    The 64-bit signed int to write.
   @param ctx
-    The context to read from.
+    A context to write to.
   @param name
-    The name of the chunk to read. Must be the next chunk name in the context.
-  @param reader
-    The function used to read the compounds in the array. May not be null. If
-    a compound was previously deserialized, this function will not be called
-    for that compound.
-  @param reader_ctx
-    Opaque data pointer passed to the reader function as context. May be null.
-  @param buf_alloc
-    The allocator to use to allocate the array. If null, uses the default
-    allocator.
+    The name of the chunk to write.
   @return
     A response code. SZ_SUCCESS on success, otherwise an error.
 
@@ -1340,38 +1859,21 @@ sz_read_compound(
 */
 SZ_EXPORT
 sz_response_t
-sz_read_compounds(
-  void ***compounds_out,
-  size_t *length,
-  sz_context_t *ctx,
-  uint32_t name,
-  sz_compound_reader_fn_t *reader,
-  void *reader_ctx,
-  sz_allocator_t *buf_alloc
-  );
+sz_write_int64(int64_t value, sz_context_t *ctx, uint32_t name);
 
 /*!
-  @brief Reads an array of bytes from a context.
+  @brief Writes an array of 64-bit signed ints to a context.
 
-  Reads an array of bytes from a context and returns it via `out`.
-  The memory must be freed by the caller using the allocator provided.
+  Writes an array of 64-bit signed ints to the context with the given name.
 
-  @param out
-    A pointer to a pointer that will receive the array. May be null, in which
-    case no array is allocated and the chunk is effectively skipped
-    if it matches. If *out is non-null, it's assumed the block receiving the
-    values is preallocated and can hold at least as many bytes as held by the
-    chunk.
+  @param values
+    An array of 64-bit signed ints to write.
   @param length
-    A pointer to a size_t that will receive the length of the array.
-    May be null.
+    The number of 64-bit signed ints to write.
   @param ctx
-    The context to read from.
+    A context to write to.
   @param name
-    The name of the chunk to read. Must be the next chunk name in the context.
-  @param buf_alloc
-    The allocator to use to allocate the array. If null, uses the default
-    allocator.
+    The name of the chunk to write.
   @return
     A response code. SZ_SUCCESS on success, otherwise an error.
 
@@ -1379,25 +1881,24 @@ sz_read_compounds(
 */
 SZ_EXPORT
 sz_response_t
-sz_read_bytes(
-  void **out,
-  size_t *length,
+sz_write_int64s(
+  int64_t *values,
+  size_t length,
   sz_context_t *ctx,
-  uint32_t name,
-  sz_allocator_t *buf_alloc
+  uint32_t name
   );
 
 /*!
-  @brief Reads a float from a context.
+  @brief Writes a 64-bit unsigned int to a context.
 
-  Reads a single float and writes it to `out`.
+  Writes a single 64-bit unsigned int to the context with the given name.
 
-  @param out
-    A pointer to a float to store the read value in. May be null.
+  @param value
+    The 64-bit unsigned int to write.
   @param ctx
-    A context to read from.
+    A context to write to.
   @param name
-    The name of the chunk to read.
+    The name of the chunk to write.
   @return
     A response code. SZ_SUCCESS on success, otherwise an error.
 
@@ -1405,32 +1906,21 @@ sz_read_bytes(
 */
 SZ_EXPORT
 sz_response_t
-sz_read_float(float *out, sz_context_t *ctx, uint32_t name);
+sz_write_uint64(uint64_t value, sz_context_t *ctx, uint32_t name);
 
 /*!
-  @brief Reads an array of floats from a context.
-
-  Reads an array of floats and returns it via `out`.
+  @brief Writes an array of 64-bit unsigned ints to a context.
 
-  The array returned via `out` must be freed by the caller using the alloactor
-  provided by the caller.
+  Writes an array of 64-bit unsigned ints to the context with the given name.
 
-  @param out
-    A pointer to a pointer that will receive the array. May be null, in which
-    case no array is allocated and the chunk is effectively skipped
-    if it matches. If *out is non-null, it's assumed the block receiving the
-    values is preallocated and can hold at least as many values as held by the
-    chunk.
+  @param values
+    An array of 64-bit unsigned ints to write.
   @param length
-    A pointer to a size_t that will receive the length of the array.
-    May be null.
+    The number of 64-bit unsigned ints to write.
   @param ctx
-    The context to read from.
+    A context to write to.
   @param name
-    The name of the chunk to read. Must be the next chunk name in the context.
-  @param buf_alloc
-    The allocator to use to allocate the array. If null, uses the default
-    allocator.
+    The name of the chunk to write.
   @return
     A response code. SZ_SUCCESS on success, otherwise an error.
 
@@ -1438,25 +1928,24 @@ sz_read_float(float *out, sz_context_t *ctx, uint32_t name);
 */
 SZ_EXPORT
 sz_response_t
-sz_read_floats(
-  float **out,
-  size_t *length,
+sz_write_uint64s(
+  uint64_t *values,
+  size_t length,
   sz_context_t *ctx,
-  uint32_t name,
-  sz_allocator_t *buf_alloc
+  uint32_t name
   );
 
 /*!
-  @brief Reads an int from a context.
+  @brief Writes a 16-bit signed int to a context.
 
-  Reads a single int32_t and writes it to `out`.
+  Writes a single 16-bit signed int to the context with the given name.
 
-  @param out
-    A pointer to an int to store the read value in. May be null.
+  @param value
+    The 16-bit signed int to write.
   @param ctx
-    A context to read from.
+    A context to write to.
   @param name
-    The name of the chunk to read.
+    The name of the chunk to write.
   @return
     A response code. SZ_SUCCESS on success, otherwise an error.
 
@@ -1464,32 +1953,21 @@ sz_read_floats(
 */
 SZ_EXPORT
 sz_response_t
-sz_read_int(int32_t *out, sz_context_t *ctx, uint32_t name);
+sz_write_int16(int16_t value, sz_context_t *ctx, uint32_t name);
 
 /*!
-  @brief Reads an array of int32_t values from a context.
-
-  Reads an array of int32_t values and returns it via `out`.
+  @brief Writes an array of 16-bit signed ints to a context.
 
-  The array returned via `out` must be freed by the caller using the alloactor
-  provided by the caller.
+  Writes an array of 16-bit signed ints to the context with the given name.
 
-  @param out
-    A pointer to a pointer that will receive the array. May be null, in which
-    case no array is allocated and the chunk is effectively skipped
-    if it matches. If *out is non-null, it's assumed the block receiving the
-    values is preallocated and can hold at least as many values as held by the
-    chunk.
+  @param values
+    An array of 16-bit signed ints to write.
   @param length
-    A pointer to a size_t that will receive the length of the array.
-    May be null.
+    The number of 16-bit signed ints to write.
   @param ctx
-    The context to read from.
+    A context to write to.
   @param name
-    The name of the chunk to read. Must be the next chunk name in the context.
-  @param buf_alloc
-    The allocator to use to allocate the array. If null, uses the default
-    allocator.
+    The name of the chunk to write.
   @return
     A response code. SZ_SUCCESS on success, otherwise an error.
 
@@ -1497,25 +1975,24 @@ sz_read_int(int32_t *out, sz_context_t *ctx, uint32_t name);
 */
 SZ_EXPORT
 sz_response_t
-sz_read_ints(
-  int32_t **out,
-  size_t *length,
+sz_write_int16s(
+  int16_t *values,
+  size_t length,
   sz_context_t *ctx,
-  uint32_t name,
-  sz_allocator_t *buf_alloc
+  uint32_t name
   );
 
 /*!
-  @brief Reads an unsigned int from a context.
+  @brief Writes an 8-bit signed int to a context.
 
-  Reads a single uint32_t and writes it to `out`.
+  Writes a single 8-bit signed int to the context with the given name.
 
-  @param out
-    A pointer to an unsigned int to store the read value in. May be null.
+  @param value
+    The 8-bit signed int to write.
   @param ctx
-    A context to read from.
+    A context to write to.
   @param name
-    The name of the chunk to read.
+    The name of the chunk to write.
   @return
     A response code. SZ_SUCCESS on success, otherwise an error.
 
@@ -1523,32 +2000,21 @@ sz_read_ints(
 */
 SZ_EXPORT
 sz_response_t
-sz_read_unsigned_int(uint32_t *out, sz_context_t *ctx, uint32_t name);
+sz_write_int8(int8_t value, sz_context_t *ctx, uint32_t name);
 
 /*!
-  @brief Reads an array of uint32_t values from a context.
-
-  Reads an array of uint32_t values and returns it via `out`.
+  @brief Writes an array of 8-bit signed ints to a context.
 
-  The array returned via `out` must be freed by the caller using the alloactor
-  provided by the caller.
+  Writes an array of 8-bit signed ints to the context with the given name.
 
-  @param out
-    A pointer to a pointer that will receive the array. May be null, in which
-    case no array is allocated and the chunk is effectively skipped
-    if it matches. If *out is non-null, it's assumed the block receiving the
-    values is preallocated and can hold at least as many values as held by the
-    chunk.
+  @param values
+    An array of 8-bit signed ints to write.
   @param length
-    A pointer to a size_t that will receive the length of the array.
-    May be null.
+    The number of 8-bit signed ints to write.
   @param ctx
-    The context to read from.
+    A context to write to.
   @param name
-    The name of the chunk to read. Must be the next chunk name in the context.
-  @param buf_alloc
-    The allocator to use to allocate the array. If null, uses the default
-    allocator.
+    The name of the chunk to write.
   @return
     A response code. SZ_SUCCESS on success, otherwise an error.
 
@@ -1556,14 +2022,1098 @@ sz_read_unsigned_int(uint32_t *out, sz_context_t *ctx, uint32_t name);
 */
 SZ_EXPORT
 sz_response_t
-sz_read_unsigned_ints(
-  uint32_t **out,
-  size_t *length,
+sz_write_int8s(
+  int8_t *values,
+  size_t length,
   sz_context_t *ctx,
-  uint32_t name,
-  sz_allocator_t *buf_alloc
+  uint32_t name
   );
 
+/*!
+  @brief Writes an encoded array of floats to a context.
+
+  Same as sz_write_floats(), but stores the array with the given encoding
+  (see sz_array_encoding_t). The array is read back with sz_read_floats().
+
+  @param values
+    An array of floats to write.
+  @param length
+    The number of floats to write.
+  @param encoding
+    The encoding to store the array with. Must apply to floats.
+  @param ctx
+    A context to write to.
+  @param name
+    The name of the chunk to write.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_write_encoded_floats(
+  float *values,
+  size_t length,
+  sz_array_encoding_t encoding,
+  sz_context_t *ctx,
+  uint32_t name
+  );
+
+/*!
+  @brief Writes an encoded array of doubles to a context.
+
+  Same as sz_write_doubles(), but stores the array with the given encoding
+  (see sz_array_encoding_t). The array is read back with sz_read_doubles().
+
+  @param values
+    An array of doubles to write.
+  @param length
+    The number of doubles to write.
+  @param encoding
+    The encoding to store the array with. Must apply to doubles.
+  @param ctx
+    A context to write to.
+  @param name
+    The name of the chunk to write.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_write_encoded_doubles(
+  double *values,
+  size_t length,
+  sz_array_encoding_t encoding,
+  sz_context_t *ctx,
+  uint32_t name
+  );
+
+/*!
+  @brief Writes an encoded array of 32-bit signed ints to a context.
+
+  Same as sz_write_ints(), but stores the array with the given encoding (see
+  sz_array_encoding_t). The array is read back with sz_read_ints().
+
+  @param values
+    An array of ints to write.
+  @param length
+    The number of ints to write.
+  @param encoding
+    The encoding to store the array with. Must apply to 32-bit signed ints.
+  @param ctx
+    A context to write to.
+  @param name
+    The name of the chunk to write.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_write_encoded_ints(
+  int32_t *values,
+  size_t length,
+  sz_array_encoding_t encoding,
+  sz_context_t *ctx,
+  uint32_t name
+  );
+
+/*!
+  @brief Writes an encoded array of 32-bit unsigned ints to a context.
+
+  Same as sz_write_unsigned_ints(), but stores the array with the given
+  encoding (see sz_array_encoding_t). The array is read back with
+  sz_read_unsigned_ints().
+
+  @param values
+    An array of unsigned ints to write.
+  @param length
+    The number of unsigned ints to write.
+  @param encoding
+    The encoding to store the array with. Must apply to 32-bit unsigned ints.
+  @param ctx
+    A context to write to.
+  @param name
+    The name of the chunk to write.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_write_encoded_unsigned_ints(
+  uint32_t *values,
+  size_t length,
+  sz_array_encoding_t encoding,
+  sz_context_t *ctx,
+  uint32_t name
+  );
+
+/*!
+  @brief Writes an encoded array of 64-bit signed ints to a context.
+
+  Same as sz_write_int64s(), but stores the array with the given encoding
+  (see sz_array_encoding_t). The array is read back with sz_read_int64s().
+
+  @param values
+    An array of 64-bit signed ints to write.
+  @param length
+    The number of 64-bit signed ints to write.
+  @param encoding
+    The encoding to store the array with. Must apply to 64-bit signed ints.
+  @param ctx
+    A context to write to.
+  @param name
+    The name of the chunk to write.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_write_encoded_int64s(
+  int64_t *values,
+  size_t length,
+  sz_array_encoding_t encoding,
+  sz_context_t *ctx,
+  uint32_t name
+  );
+
+/*!
+  @brief Writes an encoded array of 64-bit unsigned ints to a context.
+
+  Same as sz_write_uint64s(), but stores the array with the given encoding
+  (see sz_array_encoding_t). The array is read back with sz_read_uint64s().
+
+  @param values
+    An array of 64-bit unsigned ints to write.
+  @param length
+    The number of 64-bit unsigned ints to write.
+  @param encoding
+    The encoding to store the array with. Must apply to 64-bit unsigned ints.
+  @param ctx
+    A context to write to.
+  @param name
+    The name of the chunk to write.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_write_encoded_uint64s(
+  uint64_t *values,
+  size_t length,
+  sz_array_encoding_t encoding,
+  sz_context_t *ctx,
+  uint32_t name
+  );
+
+//! @}
+
+
+/*! @name Read Ops */
+//! @{
+
+/*!
+  @brief Reads a compound from a context.
+
+  @brief Reads a serialized compound object.
+
+  Reads a compound object from a reader context with the given name using a
+  compound reader function.
+
+  @param compound_out
+    A pointer to write the compound pointer to. There are more confusing ways
+    to word this parameter's description.
+  @param ctx
+    A context to read from.
+  @param name
+    The name of the chunk to read.
+  @param reader
+    The function used to read the compound. May not be null. If the compound
+    was previously deserialized, this function will not be called.
+  @param reader_ctx
+    Opaque data pointer passed to the reader function as context. May be null.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_compound(
+  void **compound_out,
+  sz_context_t *ctx,
+  uint32_t name,
+  sz_compound_reader_fn_t *reader,
+  void *reader_ctx
+  );
+
+/*!
+  @brief Reads an array of compounds from a context.
+
+  Reads an array of compound objects with the given name using a compound
+  reader function. The returned array of objects must be freed by the caller
+  using the allocator provided by the caller. The returned array is an array
+  of pointers, so your output argument is a pointer to an array of pointer.
+  I only feel the need to mention this because `void ***` is a scary type
+  for obvious reasons.
+
+  @param compounds_out
+    A pointer to a pointer that will receive the array. May be null, in which
+    case no array is allocated and the chunk is effectively skipped
+    if it matches. If *compounds_out is null, a buffer is allocated using the
+    provided allocator and returned via *compounds_out. Otherwise, it is
+    assumed that you have passed a pre-allocated buffer of the correct or
+    greater size and want the compound pointers written to it.
+  @param length
+    A pointer to a size_t that will receive the length of the array.
+    May be null.
+  @param ctx
+    The context to read from.
+  @param name
+    The name of the chunk to read. Must be the next chunk name in the context.
+  @param reader
+    The function used to read the compounds in the array. May not be null. If
+    a compound was previously deserialized, this function will not be called
+    for that compound.
+  @param reader_ctx
+    Opaque data pointer passed to the reader function as context. May be null.
+  @param buf_alloc
+    The allocator to use to allocate the array. If null, uses the default
+    allocator.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_compounds(
+  void ***compounds_out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name,
+  sz_compound_reader_fn_t *reader,
+  void *reader_ctx,
+  sz_allocator_t *buf_alloc
+  );
+
+/*!
+  @brief Reads an array of bytes from a context.
+
+  Reads an array of bytes from a context and returns it via `out`.
+  The memory must be freed by the caller using the allocator provided.
+
+  @param out
+    A pointer to a pointer that will receive the array. May be null, in which
+    case no array is allocated and the chunk is effectively skipped
+    if it matches. If *out is non-null, it's assumed the block receiving the
+    values is preallocated and can hold at least as many bytes as held by the
+    chunk.
+  @param length
+    A pointer to a size_t that will receive the length of the array.
+    May be null.
+  @param ctx
+    The context to read from.
+  @param name
+    The name of the chunk to read. Must be the next chunk name in the context.
+  @param buf_alloc
+    The allocator to use to allocate the array. If null, uses the default
+    allocator.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_bytes(
+  void **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name,
+  sz_allocator_t *buf_alloc
+  );
+
+/*!
+  @brief Reads a float from a context.
+
+  Reads a single float and writes it to `out`.
+
+  @param out
+    A pointer to a float to store the read value in. May be null.
+  @param ctx
+    A context to read from.
+  @param name
+    The name of the chunk to read.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_float(float *out, sz_context_t *ctx, uint32_t name);
+
+/*!
+  @brief Reads an array of floats from a context.
+
+  Reads an array of floats and returns it via `out`.
+
+  The array returned via `out` must be freed by the caller using the alloactor
+  provided by the caller.
+
+  @param out
+    A pointer to a pointer that will receive the array. May be null, in which
+    case no array is allocated and the chunk is effectively skipped
+    if it matches. If *out is non-null, it's assumed the block receiving the
+    values is preallocated and can hold at least as many values as held by the
+    chunk.
+  @param length
+    A pointer to a size_t that will receive the length of the array.
+    May be null.
+  @param ctx
+    The context to read from.
+  @param name
+    The name of the chunk to read. Must be the next chunk name in the context.
+  @param buf_alloc
+    The allocator to use to allocate the array. If null, uses the default
+    allocator.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_floats(
+  float **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name,
+  sz_allocator_t *buf_alloc
+  );
+
+/*!
+  @brief Reads an int from a context.
+
+  Reads a single int32_t and writes it to `out`.
+
+  @param out
+    A pointer to an int to store the read value in. May be null.
+  @param ctx
+    A context to read from.
+  @param name
+    The name of the chunk to read.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_int(int32_t *out, sz_context_t *ctx, uint32_t name);
+
+/*!
+  @brief Reads an array of int32_t values from a context.
+
+  Reads an array of int32_t values and returns it via `out`.
+
+  The array returned via `out` must be freed by the caller using the alloactor
+  provided by the caller.
+
+  @param out
+    A pointer to a pointer that will receive the array. May be null, in which
+    case no array is allocated and the chunk is effectively skipped
+    if it matches. If *out is non-null, it's assumed the block receiving the
+    values is preallocated and can hold at least as many values as held by the
+    chunk.
+  @param length
+    A pointer to a size_t that will receive the length of the array.
+    May be null.
+  @param ctx
+    The context to read from.
+  @param name
+    The name of the chunk to read. Must be the next chunk name in the context.
+  @param buf_alloc
+    The allocator to use to allocate the array. If null, uses the default
+    allocator.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_ints(
+  int32_t **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name,
+  sz_allocator_t *buf_alloc
+  );
+
+/*!
+  @brief Reads an unsigned int from a context.
+
+  Reads a single uint32_t and writes it to `out`.
+
+  @param out
+    A pointer to an unsigned int to store the read value in. May be null.
+  @param ctx
+    A context to read from.
+  @param name
+    The name of the chunk to read.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_unsigned_int(uint32_t *out, sz_context_t *ctx, uint32_t name);
+
+/*!
+  @brief Reads an array of uint32_t values from a context.
+
+  Reads an array of uint32_t values and returns it via `out`.
+
+  The array returned via `out` must be freed by the caller using the alloactor
+  provided by the caller.
+
+  @param out
+    A pointer to a pointer that will receive the array. May be null, in which
+    case no array is allocated and the chunk is effectively skipped
+    if it matches. If *out is non-null, it's assumed the block receiving the
+    values is preallocated and can hold at least as many values as held by the
+    chunk.
+  @param length
+    A pointer to a size_t that will receive the length of the array.
+    May be null.
+  @param ctx
+    The context to read from.
+  @param name
+    The name of the chunk to read. Must be the next chunk name in the context.
+  @param buf_alloc
+    The allocator to use to allocate the array. If null, uses the default
+    allocator.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_unsigned_ints(
+  uint32_t **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name,
+  sz_allocator_t *buf_alloc
+  );
+
+/*!
+  @brief Reads a double from a context.
+
+  Reads a single double and writes it to `out`.
+
+  @param out
+    A pointer to a double to store the read value in. May be null.
+  @param ctx
+    A context to read from.
+  @param name
+    The name of the chunk to read.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_double(double *out, sz_context_t *ctx, uint32_t name);
+
+/*!
+  @brief Reads an array of doubles from a context.
+
+  Reads an array of doubles and returns it via `out`.
+
+  The array returned via `out` must be freed by the caller using the allocator
+  provided by the caller.
+
+  @param out
+    A pointer to a pointer that will receive the array. May be null, in which
+    case no array is allocated and the chunk is effectively skipped
+    if it matches. If *out is non-null, it's assumed the block receiving the
+    values is preallocated and can hold at least as many values as held by the
+    chunk.
+  @param length
+    A pointer to a size_t that will receive the length of the array.
+    May be null.
+  @param ctx
+    The context to read from.
+  @param name
+    The name of the chunk to read. Must be the next chunk name in the context.
+  @param buf_alloc
+    The allocator to use to allocate the array. If null, uses the default
+    allocator.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_doubles(
+  double **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name,
+  sz_allocator_t *buf_alloc
+  );
+
+/*!
+  @brief Reads a 64-bit signed int from a context.
+
+  Reads a single int64_t and writes it to `out`.
+
+  @param out
+    A pointer to a 64-bit signed int to store the read value in. May be null.
+  @param ctx
+    A context to read from.
+  @param name
+    The name of the chunk to read.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_int64(int64_t *out, sz_context_t *ctx, uint32_t name);
+
+/*!
+  @brief Reads an array of int64_t values from a context.
+
+  Reads an array of int64_t values and returns it via `out`.
+
+  The array returned via `out` must be freed by the caller using the allocator
+  provided by the caller.
+
+  @param out
+    A pointer to a pointer that will receive the array. May be null, in which
+    case no array is allocated and the chunk is effectively skipped
+    if it matches. If *out is non-null, it's assumed the block receiving the
+    values is preallocated and can hold at least as many values as held by the
+    chunk.
+  @param length
+    A pointer to a size_t that will receive the length of the array.
+    May be null.
+  @param ctx
+    The context to read from.
+  @param name
+    The name of the chunk to read. Must be the next chunk name in the context.
+  @param buf_alloc
+    The allocator to use to allocate the array. If null, uses the default
+    allocator.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_int64s(
+  int64_t **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name,
+  sz_allocator_t *buf_alloc
+  );
+
+/*!
+  @brief Reads a 64-bit unsigned int from a context.
+
+  Reads a single uint64_t and writes it to `out`.
+
+  @param out
+    A pointer to a 64-bit unsigned int to store the read value in. May be null.
+  @param ctx
+    A context to read from.
+  @param name
+    The name of the chunk to read.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_uint64(uint64_t *out, sz_context_t *ctx, uint32_t name);
+
+/*!
+  @brief Reads an array of uint64_t values from a context.
+
+  Reads an array of uint64_t values and returns it via `out`.
+
+  The array returned via `out` must be freed by the caller using the allocator
+  provided by the caller.
+
+  @param out
+    A pointer to a pointer that will receive the array. May be null, in which
+    case no array is allocated and the chunk is effectively skipped
+    if it matches. If *out is non-null, it's assumed the block receiving the
+    values is preallocated and can hold at least as many values as held by the
+    chunk.
+  @param length
+    A pointer to a size_t that will receive the length of the array.
+    May be null.
+  @param ctx
+    The context to read from.
+  @param name
+    The name of the chunk to read. Must be the next chunk name in the context.
+  @param buf_alloc
+    The allocator to use to allocate the array. If null, uses the default
+    allocator.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_uint64s(
+  uint64_t **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name,
+  sz_allocator_t *buf_alloc
+  );
+
+/*!
+  @brief Reads a 16-bit signed int from a context.
+
+  Reads a single int16_t and writes it to `out`.
+
+  @param out
+    A pointer to a 16-bit signed int to store the read value in. May be null.
+  @param ctx
+    A context to read from.
+  @param name
+    The name of the chunk to read.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_int16(int16_t *out, sz_context_t *ctx, uint32_t name);
+
+/*!
+  @brief Reads an array of int16_t values from a context.
+
+  Reads an array of int16_t values and returns it via `out`.
+
+  The array returned via `out` must be freed by the caller using the allocator
+  provided by the caller.
+
+  @param out
+    A pointer to a pointer that will receive the array. May be null, in which
+    case no array is allocated and the chunk is effectively skipped
+    if it matches. If *out is non-null, it's assumed the block receiving the
+    values is preallocated and can hold at least as many values as held by the
+    chunk.
+  @param length
+    A pointer to a size_t that will receive the length of the array.
+    May be null.
+  @param ctx
+    The context to read from.
+  @param name
+    The name of the chunk to read. Must be the next chunk name in the context.
+  @param buf_alloc
+    The allocator to use to allocate the array. If null, uses the default
+    allocator.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_int16s(
+  int16_t **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name,
+  sz_allocator_t *buf_alloc
+  );
+
+/*!
+  @brief Reads an 8-bit signed int from a context.
+
+  Reads a single int8_t and writes it to `out`.
+
+  @param out
+    A pointer to an 8-bit signed int to store the read value in. May be null.
+  @param ctx
+    A context to read from.
+  @param name
+    The name of the chunk to read.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_int8(int8_t *out, sz_context_t *ctx, uint32_t name);
+
+/*!
+  @brief Reads an array of int8_t values from a context.
+
+  Reads an array of int8_t values and returns it via `out`.
+
+  The array returned via `out` must be freed by the caller using the allocator
+  provided by the caller.
+
+  @param out
+    A pointer to a pointer that will receive the array. May be null, in which
+    case no array is allocated and the chunk is effectively skipped
+    if it matches. If *out is non-null, it's assumed the block receiving the
+    values is preallocated and can hold at least as many values as held by the
+    chunk.
+  @param length
+    A pointer to a size_t that will receive the length of the array.
+    May be null.
+  @param ctx
+    The context to read from.
+  @param name
+    The name of the chunk to read. Must be the next chunk name in the context.
+  @param buf_alloc
+    The allocator to use to allocate the array. If null, uses the default
+    allocator.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_int8s(
+  int8_t **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name,
+  sz_allocator_t *buf_alloc
+  );
+
+//! @}
+
+
+/*!
+  @name View Ops
+
+  View ops read arrays and bytes in place, returning pointers into the
+  context's stream rather than allocating a buffer and copying into it. They
+  require a stream that supports views (see sz_stream_mmap() and
+  sz_stream_memopen()) or a context with the SZ_PRELOAD flag and, for anything
+  other than bytes, a host whose endianness matches the snowball's.
+
+  Returned pointers are owned by the stream and remain valid until the stream
+  is closed, or with SZ_PRELOAD on a stream without views, are owned by the
+  context (see SZ_PRELOAD). They must not be freed or written to. If an array's
+  data is not aligned for its element type, the view op fails and the array
+  must be read using its copying equivalent instead (e.g., sz_read_floats()).
+*/
+//! @{
+
+/*!
+  @brief Reads a view of an array of bytes from a context.
+
+  Reads a pointer to an array of bytes held by the context's stream and
+  returns it via `out`.
+
+  @param out
+    A pointer that will receive the address of the bytes. May be null, in
+    which case the chunk is skipped if it matches. Receives NULL for a null
+    chunk.
+  @param length
+    A pointer to a size_t that will receive the length of the array.
+    May be null.
+  @param ctx
+    The context to read from.
+  @param name
+    The name of the chunk to read. Must be the next chunk name in the context.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_bytes_view(
+  const void **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name
+  );
+
+/*!
+  @brief Reads a view of an array of floats from a context.
+
+  Reads a pointer to an array of floats held by the context's stream and
+  returns it via `out`.
+
+  @param out
+    A pointer that will receive the address of the array. May be null, in
+    which case the chunk is skipped if it matches. Receives NULL for a null
+    chunk.
+  @param length
+    A pointer to a size_t that will receive the length of the array.
+    May be null.
+  @param ctx
+    The context to read from.
+  @param name
+    The name of the chunk to read. Must be the next chunk name in the context.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_floats_view(
+  const float **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name
+  );
+
+/*!
+  @brief Reads a view of an array of int32_t values from a context.
+
+  Same as sz_read_floats_view(), but for arrays written by sz_write_ints().
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_ints_view(
+  const int32_t **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name
+  );
+
+/*!
+  @brief Reads a view of an array of uint32_t values from a context.
+
+  Same as sz_read_floats_view(), but for arrays written by
+  sz_write_unsigned_ints().
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_unsigned_ints_view(
+  const uint32_t **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name
+  );
+
+/*!
+  @brief Reads a view of an array of doubles from a context.
+
+  Same as sz_read_floats_view(), but for arrays written by sz_write_doubles().
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_doubles_view(
+  const double **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name
+  );
+
+/*!
+  @brief Reads a view of an array of int64_t values from a context.
+
+  Same as sz_read_floats_view(), but for arrays written by sz_write_int64s().
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_int64s_view(
+  const int64_t **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name
+  );
+
+/*!
+  @brief Reads a view of an array of uint64_t values from a context.
+
+  Same as sz_read_floats_view(), but for arrays written by sz_write_uint64s().
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_uint64s_view(
+  const uint64_t **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name
+  );
+
+/*!
+  @brief Reads a view of an array of int16_t values from a context.
+
+  Same as sz_read_floats_view(), but for arrays written by sz_write_int16s().
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_int16s_view(
+  const int16_t **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name
+  );
+
+/*!
+  @brief Reads a view of an array of int8_t values from a context.
+
+  Same as sz_read_floats_view(), but for arrays written by sz_write_int8s().
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_int8s_view(
+  const int8_t **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name
+  );
+
+//! @}
+
+
+
+/*!
+  @name Windowed Reads
+
+  Windowed reads deliver an array or bytes chunk a piece at a time, into
+  buffers supplied by the caller, instead of allocating and filling a buffer
+  for the whole thing. This lets very large arrays be streamed somewhere else
+  (e.g., to a staging buffer or a hash function) without holding all of them in
+  memory at once.
+
+  An array is opened with sz_begin_array(), read with any number of calls to
+  sz_read_array_window(), and closed with sz_end_array(). While an array is
+  open, no other chunks may be read from the context.
+*/
+//! @{
+
+/*!
+  @brief Opens an array chunk for reading in windows.
+
+  Reads the header of an array of numbers, as written by sz_write_floats() and
+  the like, or of an array of bytes written by sz_write_bytes(), and opens it
+  for sz_read_array_window().
+
+  Null arrays are opened as arrays of length 0.
+
+  @param length
+    A pointer to a size_t that will receive the number of elements in the
+    array. May be null.
+  @param ctx
+    The context to read from.
+  @param type
+    The type of the array's elements (e.g., SZ_FLOAT_CHUNK for arrays written
+    by sz_write_floats()), or SZ_BYTES_CHUNK for bytes. Arrays of compounds
+    can't be read in windows.
+  @param name
+    The name of the chunk to read.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error. On error, no
+    array is opened.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_begin_array(
+  size_t *length,
+  sz_context_t *ctx,
+  sz_chunk_id_t type,
+  uint32_t name
+  );
+
+/*!
+  @brief Reads the next window of elements of an open array.
+
+  Copies up to capacity elements following those already read into out,
+  converted to the host's byte order, and sets count to the number copied.
+  Fewer than capacity elements are only read once the end of the array is
+  reached, after which count is always 0.
+
+  @param out
+    A buffer to receive the elements, with room for at least capacity of them.
+    May be null, in which case up to capacity elements are skipped.
+  @param capacity
+    The maximum number of elements to read.
+  @param count
+    A pointer to a size_t that will receive the number of elements read. May
+    be null.
+  @param ctx
+    The context to read from.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_read_array_window(
+  void *out,
+  size_t capacity,
+  size_t *count,
+  sz_context_t *ctx
+  );
+
+/*!
+  @brief Closes the array opened by sz_begin_array().
+
+  Any elements that haven't been read are skipped, and the next chunk can then
+  be read as usual.
+
+  @param ctx
+    The context to close the array of.
+  @return
+    A response code. SZ_SUCCESS on success, otherwise an error.
+
+  @ingroup contexts
+*/
+SZ_EXPORT
+sz_response_t
+sz_end_array(sz_context_t *ctx);
+
 //! @}
 
 
@@ -19,10 +19,13 @@ language "C++"
   files { "src/*.cc", "src/*.hh", "include/*.h" }
 
   includedirs { "include" }
-  defines { "SZ_BUILDING" }
+  defines { "SZ_BUILDING", "_FILE_OFFSET_BITS=64" }
 
   flags { "ExtraWarnings" }
 
+  buildoptions { "-pthread" }
+  linkoptions { "-pthread" }
+
   configuration "not c++98"
     buildoptions { "-std=c++11" }
 
@@ -43,3 +46,32 @@ language "C++"
 
   configuration "*-Shared"
     kind "SharedLib"
+
+project "snowball-tests"
+language "C++"
+kind "ConsoleApp"
+
+  -- Tests build in the library's sources so they can reach its internals.
+  files { "src/*.cc", "src/*.hh", "include/*.h", "tests/*.cc", "tests/*.hh" }
+
+  includedirs { "include", "src" }
+  defines { "SZ_BUILDING", "_FILE_OFFSET_BITS=64" }
+
+  flags { "ExtraWarnings" }
+
+  buildoptions { "-pthread" }
+  linkoptions { "-pthread" }
+
+  configuration "not c++98"
+    buildoptions { "-std=c++11" }
+
+  configuration { "not c++98", "macosx" }
+    buildoptions { "-stdlib=libc++" }
+
+  configuration "Debug-*"
+    defines { "DEBUG" }
+    flags { "Symbols" }
+
+  configuration "Release-*"
+    defines { "NDEBUG" }
+    flags { "Optimize" }
@@ -165,7 +165,7 @@ struct SZ_HIDDEN sz_cxx_allocator_t
 template <typename T, typename U>
 bool operator == (
   const sz_cxx_allocator_t<T> &lhs,
-  const sz_cxx_allocator_t<T> &rhs
+  const sz_cxx_allocator_t<U> &rhs
   )
 {
   return lhs.allocator == rhs.allocator;
@@ -175,7 +175,7 @@ bool operator == (
 template <typename T, typename U>
 bool operator != (
   const sz_cxx_allocator_t<T> &lhs,
-  const sz_cxx_allocator_t<T> &rhs
+  const sz_cxx_allocator_t<U> &rhs
   )
 {
   return lhs.allocator != rhs.allocator;
@@ -0,0 +1,264 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+#include <snowball.h>
+
+
+// Alignment of every allocation from an arena, enough for any scalar type and
+// for 16-byte SIMD loads.
+#define SZ_ARENA_ALIGNMENT (16)
+
+
+struct SZ_HIDDEN sz_arena_block_t
+{
+  sz_arena_block_t *next;
+  size_t size;          // Usable bytes following the block's header
+};
+
+
+struct SZ_HIDDEN sz_arena_t
+{
+  sz_allocator_t base;
+
+  sz_allocator_t *allocator;
+  size_t block_size;
+  // Blocks, newest first. The first is the one being allocated from, except
+  // that blocks for large allocations are slipped in behind it.
+  sz_arena_block_t *blocks;
+  uint8_t *cursor;
+  uint8_t *end;
+};
+
+
+// Size of a block's header, rounded up so the block's memory stays aligned.
+static const size_t sz_arena_header_size =
+  (sizeof(sz_arena_block_t) + SZ_ARENA_ALIGNMENT - 1)
+  & ~size_t(SZ_ARENA_ALIGNMENT - 1);
+
+
+static
+void *
+sz_arena_malloc(size_t size, sz_allocator_t *alloc);
+
+
+static
+void
+sz_arena_free(void *ptr, sz_allocator_t *alloc);
+
+
+static
+uint8_t *
+sz_arena_block_data(sz_arena_block_t *block)
+{
+  return (uint8_t *)block + sz_arena_header_size;
+}
+
+
+static
+sz_arena_block_t *
+sz_arena_new_block(sz_arena_t *arena, size_t size)
+{
+  if (size > ~size_t(0) - sz_arena_header_size) {
+    return NULL;
+  }
+
+  sz_arena_block_t *block = (sz_arena_block_t *)sz_malloc(
+    sz_arena_header_size + size,
+    arena->allocator
+    );
+
+  if (block) {
+    block->next = NULL;
+    block->size = size;
+  }
+
+  return block;
+}
+
+
+static
+sz_arena_t *
+sz_as_arena(sz_allocator_t *alloc)
+{
+  if (alloc == NULL || alloc->malloc != sz_arena_malloc) {
+    return NULL;
+  }
+  return (sz_arena_t *)alloc;
+}
+
+
+static
+void *
+sz_arena_malloc(size_t size, sz_allocator_t *alloc)
+{
+  sz_arena_t *arena = (sz_arena_t *)alloc;
+
+  if (size == 0) {
+    size = 1;
+  } else if (size > ~size_t(0) - SZ_ARENA_ALIGNMENT) {
+    return NULL;
+  }
+
+  size = (size + SZ_ARENA_ALIGNMENT - 1) & ~size_t(SZ_ARENA_ALIGNMENT - 1);
+
+  if (size <= size_t(arena->end - arena->cursor)) {
+    void *ptr = arena->cursor;
+    arena->cursor += size;
+    return ptr;
+  }
+
+  // Allocations too big to share a block get one of their own, which goes
+  // behind the current block so the rest of that block is still used.
+  if (size > arena->block_size / 4) {
+    sz_arena_block_t *block = sz_arena_new_block(arena, size);
+
+    if (block == NULL) {
+      return NULL;
+    } else if (arena->blocks) {
+      block->next = arena->blocks->next;
+      arena->blocks->next = block;
+    } else {
+      arena->blocks = block;
+    }
+
+    return sz_arena_block_data(block);
+  }
+
+  sz_arena_block_t *block = sz_arena_new_block(arena, arena->block_size);
+
+  if (block == NULL) {
+    return NULL;
+  }
+
+  block->next = arena->blocks;
+  arena->blocks = block;
+  arena->cursor = sz_arena_block_data(block) + size;
+  arena->end = sz_arena_block_data(block) + block->size;
+
+  return sz_arena_block_data(block);
+}
+
+
+static
+void
+sz_arena_free(void *ptr, sz_allocator_t *alloc)
+{
+  // Memory is only released by resetting or destroying the arena.
+  (void)ptr;
+  (void)alloc;
+}
+
+
+static const sz_allocator_t sz_arena_base = {
+  sz_arena_malloc,
+  sz_arena_free
+};
+
+
+SZ_DEF_BEGIN
+
+
+sz_allocator_t *
+sz_arena_new(size_t block_size, sz_allocator_t *alloc)
+{
+  sz_arena_t *arena = (sz_arena_t *)sz_malloc(sizeof(sz_arena_t), alloc);
+
+  if (arena == NULL) {
+    return NULL;
+  }
+
+  if (block_size == 0) {
+    block_size = SZ_DEFAULT_ARENA_BLOCK_SIZE;
+  }
+
+  arena->base = sz_arena_base;
+  arena->allocator = alloc;
+  arena->block_size =
+    (block_size + SZ_ARENA_ALIGNMENT - 1) & ~size_t(SZ_ARENA_ALIGNMENT - 1);
+  arena->blocks = NULL;
+  arena->cursor = NULL;
+  arena->end = NULL;
+
+  return (sz_allocator_t *)arena;
+}
+
+
+void
+sz_arena_reset(sz_allocator_t *alloc)
+{
+  sz_arena_t *arena = sz_as_arena(alloc);
+
+  if (arena == NULL) {
+    return;
+  }
+
+  // Keep one full-size block around so refilling the arena doesn't have to
+  // start from nothing.
+  sz_arena_block_t *kept = NULL;
+  sz_arena_block_t *block = arena->blocks;
+
+  while (block) {
+    sz_arena_block_t *next = block->next;
+
+    if (kept == NULL && block->size == arena->block_size) {
+      kept = block;
+      kept->next = NULL;
+    } else {
+      sz_free(block, arena->allocator);
+    }
+
+    block = next;
+  }
+
+  arena->blocks = kept;
+
+  if (kept) {
+    arena->cursor = sz_arena_block_data(kept);
+    arena->end = arena->cursor + kept->size;
+  } else {
+    arena->cursor = NULL;
+    arena->end = NULL;
+  }
+}
+
+
+void
+sz_arena_destroy(sz_allocator_t *alloc)
+{
+  sz_arena_t *arena = sz_as_arena(alloc);
+
+  if (arena == NULL) {
+    return;
+  }
+
+  sz_arena_block_t *block = arena->blocks;
+
+  while (block) {
+    sz_arena_block_t *next = block->next;
+    sz_free(block, arena->allocator);
+    block = next;
+  }
+
+  sz_free(arena, arena->allocator);
+}
+
+
+SZ_DEF_END
@@ -0,0 +1,1867 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+#include "array_codec.hh"
+#include "chunk.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+# define SZ_ARRAY_CODEC_X86 1
+# include <immintrin.h>
+#else
+# define SZ_ARRAY_CODEC_X86 0
+#endif
+
+
+// Whether the SIMD paths may be taken -- see sz_array_codec_use_simd().
+static bool sz_array_codec_simd = true;
+
+#if SZ_ARRAY_CODEC_X86
+// Whether the SIMD paths are enabled and the CPU has the given feature.
+# define SZ_CPU_HAS(FEATURE) \
+  (sz_array_codec_simd && __builtin_cpu_supports(FEATURE))
+#endif
+
+
+static
+uint32_t
+sz_zigzag_encode32(int32_t value)
+{
+  return (uint32_t(value) << 1) ^ uint32_t(value >> 31);
+}
+
+
+static
+int32_t
+sz_zigzag_decode32(uint32_t value)
+{
+  return int32_t((value >> 1) ^ (0U - (value & 1)));
+}
+
+
+/*==============================================================================
+  Varint (SZ_ENCODING_VARINT)
+
+  Stream VByte: values are split into a control stream and a data stream. Each
+  control byte holds four 2-bit codes, lowest bits first, giving the number of
+  bytes (code + 1) each of the next four values takes in the data stream,
+  where they're stored little-endian. All control bytes come first, then all
+  data. Keeping lengths apart from data lets four values at a time be decoded
+  with one shuffle. Signed values are zigzag encoded first so small negative
+  values stay small.
+==============================================================================*/
+
+static
+size_t
+sz_vbyte_control_length(size_t count)
+{
+  return (count + 3) / 4;
+}
+
+
+static
+size_t
+sz_vbyte_bound(size_t count)
+{
+  return sz_vbyte_control_length(count) + count * sizeof(uint32_t);
+}
+
+
+static
+size_t
+sz_vbyte_encode(const uint32_t *in, size_t count, bool zigzag, uint8_t *out)
+{
+  uint8_t *control = out;
+  uint8_t *data = out + sz_vbyte_control_length(count);
+  const uint8_t *const data_start = data;
+
+  memset(control, 0, sz_vbyte_control_length(count));
+
+  for (size_t index = 0; index < count; ++index) {
+    const uint32_t value =
+      zigzag ? sz_zigzag_encode32(int32_t(in[index])) : in[index];
+    const unsigned code =
+      value < (1U << 8) ? 0 : value < (1U << 16) ? 1 : value < (1U << 24) ? 2 : 3;
+
+    control[index / 4] |= uint8_t(code << ((index % 4) * 2));
+
+    for (unsigned byte = 0; byte <= code; ++byte) {
+      *data++ = uint8_t(value >> (byte * 8));
+    }
+  }
+
+  return sz_vbyte_control_length(count) + size_t(data - data_start);
+}
+
+
+#if SZ_ARRAY_CODEC_X86
+
+// Per control byte, the pshufb mask that spreads its four values' bytes out to
+// 32-bit lanes and the total number of data bytes they take.
+struct SZ_HIDDEN sz_vbyte_tables_t
+{
+  uint8_t shuffle[256][16];
+  uint8_t length[256];
+
+  sz_vbyte_tables_t()
+  {
+    for (unsigned control = 0; control < 256; ++control) {
+      uint8_t offset = 0;
+
+      for (unsigned lane = 0; lane < 4; ++lane) {
+        const unsigned bytes = ((control >> (lane * 2)) & 3) + 1;
+
+        for (unsigned byte = 0; byte < 4; ++byte) {
+          // 0x80 zeroes the destination byte.
+          shuffle[control][lane * 4 + byte] =
+            byte < bytes ? uint8_t(offset + byte) : uint8_t(0x80);
+        }
+
+        offset = uint8_t(offset + bytes);
+      }
+
+      length[control] = offset;
+    }
+  }
+};
+
+
+static const sz_vbyte_tables_t sz_vbyte_tables;
+
+
+// Decodes whole groups of four values while at least 16 data bytes are left,
+// since each group loads 16 bytes whatever its length. Returns the number of
+// values decoded and advances *data past their bytes.
+__attribute__((target("ssse3")))
+static
+size_t
+sz_vbyte_decode_ssse3(
+  const uint8_t *control,
+  const uint8_t **data,
+  const uint8_t *data_end,
+  uint32_t *out,
+  size_t count,
+  bool zigzag
+  )
+{
+  const uint8_t *in = *data;
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i zero = _mm_setzero_si128();
+  size_t index = 0;
+
+  for (; index + 4 <= count && data_end - in >= 16; index += 4) {
+    const uint8_t group = control[index / 4];
+    const __m128i shuffle =
+      _mm_loadu_si128((const __m128i *)sz_vbyte_tables.shuffle[group]);
+    __m128i values =
+      _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)in), shuffle);
+
+    if (zigzag) {
+      values = _mm_xor_si128(
+        _mm_srli_epi32(values, 1),
+        _mm_sub_epi32(zero, _mm_and_si128(values, one))
+        );
+    }
+
+    _mm_storeu_si128((__m128i *)(out + index), values);
+    in += sz_vbyte_tables.length[group];
+  }
+
+  *data = in;
+  return index;
+}
+
+#endif
+
+
+static
+bool
+sz_vbyte_decode(
+  const uint8_t *in,
+  size_t length,
+  uint32_t *out,
+  size_t count,
+  bool zigzag
+  )
+{
+  const size_t control_length = sz_vbyte_control_length(count);
+
+  if (length < control_length) {
+    return true;
+  }
+
+  const uint8_t *const control = in;
+  const uint8_t *data = in + control_length;
+  const uint8_t *const data_end = in + length;
+  size_t index = 0;
+
+#if SZ_ARRAY_CODEC_X86
+  if (SZ_CPU_HAS("ssse3")) {
+    index = sz_vbyte_decode_ssse3(control, &data, data_end, out, count, zigzag);
+  }
+#endif
+
+  for (; index < count; ++index) {
+    const unsigned bytes = ((control[index / 4] >> ((index % 4) * 2)) & 3) + 1;
+    uint32_t value = 0;
+
+    if (size_t(data_end - data) < bytes) {
+      return true;
+    }
+
+    for (unsigned byte = 0; byte < bytes; ++byte) {
+      value |= uint32_t(data[byte]) << (byte * 8);
+    }
+
+    data += bytes;
+    out[index] = zigzag ? uint32_t(sz_zigzag_decode32(value)) : value;
+  }
+
+  return data != data_end;
+}
+
+
+/*==============================================================================
+  Packed deltas (SZ_ENCODING_PACKED_DELTAS)
+
+  The first value is stored as a base, then each value is stored as its
+  difference from the one before it. Deltas are split into blocks of 128; each
+  block stores its smallest delta as a reference and the bit width of the
+  largest delta minus that reference, followed by every delta minus the
+  reference packed at that width. Sorted or clustered values give small deltas
+  close together, so blocks pack to a few bits per value.
+
+  Packed values are laid out vertically across the lanes of a 128-bit vector:
+  value i goes to lane i % lanes, and each lane packs its values into its own
+  run of words, which are interleaved word by word. A whole block is then
+  packed or unpacked with the same shifts and masks applied to every lane,
+  and its deltas summed with a vector prefix sum. All arithmetic wraps, so
+  signed and unsigned values are encoded the same way.
+==============================================================================*/
+
+enum {
+  SZ_PACKED_BLOCK_LENGTH = 128,
+  SZ_PACKED_VECTOR_SIZE = 16
+};
+
+
+template <typename T>
+static
+T
+sz_load_le(const uint8_t *in)
+{
+  T value = 0;
+
+  for (size_t byte = 0; byte < sizeof(T); ++byte) {
+    value |= T(in[byte]) << (byte * 8);
+  }
+
+  return value;
+}
+
+
+template <typename T>
+static
+void
+sz_store_le(uint8_t *out, T value)
+{
+  for (size_t byte = 0; byte < sizeof(T); ++byte) {
+    out[byte] = uint8_t(value >> (byte * 8));
+  }
+}
+
+
+// Returns the number of words each lane of a block of count values takes when
+// packed at width bits.
+template <typename T>
+static
+size_t
+sz_packed_lane_words(size_t count, unsigned width)
+{
+  const size_t lanes = SZ_PACKED_VECTOR_SIZE / sizeof(T);
+  const size_t rows = (count + lanes - 1) / lanes;
+  const size_t bits = sizeof(T) * 8;
+  return (rows * width + bits - 1) / bits;
+}
+
+
+template <typename T>
+static
+size_t
+sz_packed_bound(size_t count)
+{
+  const size_t lanes = SZ_PACKED_VECTOR_SIZE / sizeof(T);
+  const size_t blocks =
+    (count + SZ_PACKED_BLOCK_LENGTH - 1) / SZ_PACKED_BLOCK_LENGTH;
+  const size_t rows = (count + lanes - 1) / lanes;
+  return sizeof(T) + blocks * (sizeof(T) + 1) + rows * lanes * sizeof(T);
+}
+
+
+template <typename T>
+static
+T
+sz_packed_mask(unsigned width)
+{
+  return width >= sizeof(T) * 8 ? ~T(0) : T((T(1) << width) - 1);
+}
+
+
+// Packs count offsets at width bits into words, which must be zeroed.
+template <typename T>
+static
+void
+sz_pack_scalar(const T *offsets, size_t count, unsigned width, T *words)
+{
+  const size_t lanes = SZ_PACKED_VECTOR_SIZE / sizeof(T);
+  const size_t bits = sizeof(T) * 8;
+
+  for (size_t index = 0; index < count; ++index) {
+    const size_t lane = index % lanes;
+    const size_t bit = (index / lanes) * width;
+    const size_t word = bit / bits;
+    const unsigned shift = unsigned(bit % bits);
+
+    words[word * lanes + lane] |= T(offsets[index] << shift);
+
+    if (shift && shift + width > bits) {
+      words[(word + 1) * lanes + lane] |= T(offsets[index] >> (bits - shift));
+    }
+  }
+}
+
+
+// Unpacks count values at width bits from little-endian words, adding
+// reference to each and summing them onto previous. Returns the last value.
+template <typename T>
+static
+T
+sz_unpack_scalar(
+  const uint8_t *words,
+  size_t count,
+  unsigned width,
+  T reference,
+  T previous,
+  T *out
+  )
+{
+  const size_t lanes = SZ_PACKED_VECTOR_SIZE / sizeof(T);
+  const size_t bits = sizeof(T) * 8;
+  const T mask = sz_packed_mask<T>(width);
+
+  for (size_t index = 0; index < count; ++index) {
+    const size_t lane = index % lanes;
+    const size_t bit = (index / lanes) * width;
+    const size_t word = bit / bits;
+    const unsigned shift = unsigned(bit % bits);
+    T offset = 0;
+
+    if (width) {
+      offset = T(
+        sz_load_le<T>(words + (word * lanes + lane) * sizeof(T)) >> shift
+        );
+
+      if (shift && shift + width > bits) {
+        offset |= T(
+          sz_load_le<T>(words + ((word + 1) * lanes + lane) * sizeof(T))
+            << (bits - shift)
+          );
+      }
+    }
+
+    previous = T(previous + reference + (offset & mask));
+    out[index] = previous;
+  }
+
+  return previous;
+}
+
+
+#if SZ_ARRAY_CODEC_X86 && defined(__SSE2__)
+
+// Vector ops for the lanes of a block of 32- or 64-bit values.
+struct SZ_HIDDEN sz_lanes32_t
+{
+  static __m128i set1(uint32_t value) { return _mm_set1_epi32(int(value)); }
+  static __m128i add(__m128i a, __m128i b) { return _mm_add_epi32(a, b); }
+
+  static __m128i srl(__m128i value, unsigned count)
+  {
+    return _mm_srl_epi32(value, _mm_cvtsi32_si128(int(count)));
+  }
+
+  static __m128i sll(__m128i value, unsigned count)
+  {
+    return _mm_sll_epi32(value, _mm_cvtsi32_si128(int(count)));
+  }
+
+  // Sums deltas onto the running total in carry and broadcasts the last sum
+  // to carry.
+  static __m128i prefix_sum(__m128i deltas, __m128i *carry)
+  {
+    deltas = _mm_add_epi32(deltas, _mm_slli_si128(deltas, 4));
+    deltas = _mm_add_epi32(deltas, _mm_slli_si128(deltas, 8));
+    deltas = _mm_add_epi32(deltas, *carry);
+    *carry = _mm_shuffle_epi32(deltas, _MM_SHUFFLE(3, 3, 3, 3));
+    return deltas;
+  }
+};
+
+
+struct SZ_HIDDEN sz_lanes64_t
+{
+  static __m128i set1(uint64_t value)
+  {
+    return _mm_set1_epi64x(int64_t(value));
+  }
+
+  static __m128i add(__m128i a, __m128i b) { return _mm_add_epi64(a, b); }
+
+  static __m128i srl(__m128i value, unsigned count)
+  {
+    return _mm_srl_epi64(value, _mm_cvtsi32_si128(int(count)));
+  }
+
+  static __m128i sll(__m128i value, unsigned count)
+  {
+    return _mm_sll_epi64(value, _mm_cvtsi32_si128(int(count)));
+  }
+
+  static __m128i prefix_sum(__m128i deltas, __m128i *carry)
+  {
+    deltas = _mm_add_epi64(deltas, _mm_slli_si128(deltas, 8));
+    deltas = _mm_add_epi64(deltas, *carry);
+    *carry = _mm_unpackhi_epi64(deltas, deltas);
+    return deltas;
+  }
+};
+
+
+// Packs a whole block of offsets at width bits to out, one vector of words at
+// a time.
+template <typename T, typename L>
+static
+void
+sz_pack_block_sse2(const T *offsets, unsigned width, uint8_t *out)
+{
+  const size_t lanes = SZ_PACKED_VECTOR_SIZE / sizeof(T);
+  const unsigned bits = sizeof(T) * 8;
+  __m128i word = _mm_setzero_si128();
+  unsigned shift = 0;
+
+  if (width == 0) {
+    return;
+  }
+
+  for (size_t row = 0; row < SZ_PACKED_BLOCK_LENGTH / lanes; ++row) {
+    const __m128i value =
+      _mm_loadu_si128((const __m128i *)(offsets + row * lanes));
+
+    word = _mm_or_si128(word, L::sll(value, shift));
+    shift += width;
+
+    if (shift >= bits) {
+      _mm_storeu_si128((__m128i *)out, word);
+      out += SZ_PACKED_VECTOR_SIZE;
+      shift -= bits;
+      word = shift ? L::srl(value, width - shift) : _mm_setzero_si128();
+    }
+  }
+}
+
+
+// Unpacks a whole block of values at width bits from in, adding reference to
+// each and summing them onto previous. Returns the last value.
+template <typename T, typename L>
+static
+T
+sz_unpack_block_sse2(
+  const uint8_t *in,
+  unsigned width,
+  T reference,
+  T previous,
+  T *out
+  )
+{
+  const size_t lanes = SZ_PACKED_VECTOR_SIZE / sizeof(T);
+  const size_t rows = SZ_PACKED_BLOCK_LENGTH / lanes;
+  const unsigned bits = sizeof(T) * 8;
+  const __m128i mask = L::set1(sz_packed_mask<T>(width));
+  const __m128i base = L::set1(reference);
+  __m128i carry = L::set1(previous);
+  __m128i word =
+    width ? _mm_loadu_si128((const __m128i *)in) : _mm_setzero_si128();
+  unsigned shift = 0;
+
+  for (size_t row = 0; row < rows; ++row) {
+    __m128i value = L::srl(word, shift);
+    shift += width;
+
+    if (shift >= bits && row + 1 < rows) {
+      in += SZ_PACKED_VECTOR_SIZE;
+      word = _mm_loadu_si128((const __m128i *)in);
+      shift -= bits;
+
+      if (shift) {
+        value = _mm_or_si128(value, L::sll(word, width - shift));
+      }
+    }
+
+    value = L::add(_mm_and_si128(value, mask), base);
+    _mm_storeu_si128(
+      (__m128i *)(out + row * lanes),
+      L::prefix_sum(value, &carry)
+      );
+  }
+
+  return out[SZ_PACKED_BLOCK_LENGTH - 1];
+}
+
+
+template <typename T> struct sz_lanes_of_t;
+template <> struct sz_lanes_of_t<uint32_t> { typedef sz_lanes32_t type; };
+template <> struct sz_lanes_of_t<uint64_t> { typedef sz_lanes64_t type; };
+
+# define SZ_PACKED_SSE2 1
+#else
+# define SZ_PACKED_SSE2 0
+#endif
+
+
+template <typename T>
+static
+size_t
+sz_packed_encode(const T *in, size_t count, uint8_t *out)
+{
+  const size_t lanes = SZ_PACKED_VECTOR_SIZE / sizeof(T);
+  const size_t bits = sizeof(T) * 8;
+  const T sign = T(T(1) << (bits - 1));
+  uint8_t *const start = out;
+  T offsets[SZ_PACKED_BLOCK_LENGTH];
+  T words[SZ_PACKED_BLOCK_LENGTH];
+  T previous = in[0];
+
+  sz_store_le<T>(out, previous);
+  out += sizeof(T);
+
+  for (size_t first = 0; first < count; first += SZ_PACKED_BLOCK_LENGTH) {
+    const size_t length =
+      std::min(count - first, size_t(SZ_PACKED_BLOCK_LENGTH));
+    T reference = T(in[first] - previous);
+    T spread = 0;
+    unsigned width = 0;
+
+    // Offsets are taken from the smallest delta as a signed value, so
+    // clustered values that aren't sorted still pack tightly.
+    for (size_t index = 0; index < length; ++index) {
+      offsets[index] = T(in[first + index] - previous);
+      previous = in[first + index];
+
+      if (T(offsets[index] ^ sign) < T(reference ^ sign)) {
+        reference = offsets[index];
+      }
+    }
+
+    for (size_t index = 0; index < length; ++index) {
+      offsets[index] = T(offsets[index] - reference);
+      spread |= offsets[index];
+    }
+
+    while (width < bits && (spread >> width)) {
+      ++width;
+    }
+
+    sz_store_le<T>(out, reference);
+    out[sizeof(T)] = uint8_t(width);
+    out += sizeof(T) + 1;
+
+    const size_t word_count = sz_packed_lane_words<T>(length, width) * lanes;
+
+#if SZ_PACKED_SSE2
+    if (sz_array_codec_simd && length == SZ_PACKED_BLOCK_LENGTH) {
+      sz_pack_block_sse2<T, typename sz_lanes_of_t<T>::type>(
+        offsets,
+        width,
+        out
+        );
+      out += word_count * sizeof(T);
+      continue;
+    }
+#endif
+
+    std::fill(words, words + word_count, T(0));
+    sz_pack_scalar<T>(offsets, length, width, words);
+
+    for (size_t word = 0; word < word_count; ++word) {
+      sz_store_le<T>(out, words[word]);
+      out += sizeof(T);
+    }
+  }
+
+  return size_t(out - start);
+}
+
+
+template <typename T>
+static
+bool
+sz_packed_decode(const uint8_t *in, size_t length, T *out, size_t count)
+{
+  const size_t lanes = SZ_PACKED_VECTOR_SIZE / sizeof(T);
+  const uint8_t *const end = in + length;
+
+  if (length < sizeof(T)) {
+    return true;
+  }
+
+  T previous = sz_load_le<T>(in);
+  in += sizeof(T);
+
+  for (size_t first = 0; first < count; first += SZ_PACKED_BLOCK_LENGTH) {
+    const size_t block_length =
+      std::min(count - first, size_t(SZ_PACKED_BLOCK_LENGTH));
+
+    if (size_t(end - in) < sizeof(T) + 1 || in[sizeof(T)] > sizeof(T) * 8) {
+      return true;
+    }
+
+    const T reference = sz_load_le<T>(in);
+    const unsigned width = in[sizeof(T)];
+    const size_t block_size =
+      sz_packed_lane_words<T>(block_length, width) * lanes * sizeof(T);
+
+    in += sizeof(T) + 1;
+
+    if (size_t(end - in) < block_size) {
+      return true;
+    }
+
+#if SZ_PACKED_SSE2
+    if (sz_array_codec_simd && block_length == SZ_PACKED_BLOCK_LENGTH) {
+      previous = sz_unpack_block_sse2<T, typename sz_lanes_of_t<T>::type>(
+        in,
+        width,
+        reference,
+        previous,
+        out + first
+        );
+      in += block_size;
+      continue;
+    }
+#endif
+
+    previous = sz_unpack_scalar<T>(
+      in,
+      block_length,
+      width,
+      reference,
+      previous,
+      out + first
+      );
+    in += block_size;
+  }
+
+  return in != end;
+}
+
+
+/*==============================================================================
+  Byte shuffle (SZ_ENCODING_SHUFFLE, SZ_ENCODING_XOR_SHUFFLE)
+
+  Values are split into blocks of SZ_SHUFFLE_BLOCK_SIZE bytes. Each block's
+  bytes are regrouped into planes -- the first byte of every value, then the
+  second, and so on -- so that the sign and exponent bytes of similar floats
+  end up next to each other, and the planes are then compressed with a small
+  LZ77 compressor. With SZ_ENCODING_XOR_SHUFFLE, each value is first XORed
+  with the value before it, which zeroes the bytes that slowly changing values
+  share. Each block is stored as its 32-bit compressed size followed by its
+  data; a block that doesn't compress is stored shuffled but uncompressed,
+  with its uncompressed size.
+
+  The LZ77 stream is a series of sequences, each a token byte holding a
+  literal length in its high nibble and a match length (less
+  SZ_LZ_MIN_MATCH) in its low nibble, either of which is continued in
+  following bytes when 15, then the literals, then a 16-bit offset back to
+  the match. The last sequence has literals only.
+==============================================================================*/
+
+enum {
+  SZ_SHUFFLE_BLOCK_SIZE = 16384,
+  SZ_LZ_MIN_MATCH = 4,
+  SZ_LZ_MAX_OFFSET = 65535,
+  SZ_LZ_HASH_BITS = 12
+};
+
+
+static
+size_t
+sz_shuffle_value_size(sz_chunk_id_t type)
+{
+  return type == SZ_DOUBLE_CHUNK ? sizeof(double) : sizeof(float);
+}
+
+
+static
+size_t
+sz_shuffle_bound(size_t count, size_t value_size)
+{
+  const size_t size = count * value_size;
+  const size_t blocks =
+    (size + SZ_SHUFFLE_BLOCK_SIZE - 1) / SZ_SHUFFLE_BLOCK_SIZE;
+  return blocks * sizeof(uint32_t) + size;
+}
+
+
+static
+uint32_t
+sz_lz_read32(const uint8_t *in)
+{
+  uint32_t value;
+  memcpy(&value, in, sizeof(value));
+  return value;
+}
+
+
+static
+uint32_t
+sz_lz_hash(uint32_t value)
+{
+  return (value * 2654435761U) >> (32 - SZ_LZ_HASH_BITS);
+}
+
+
+static
+uint8_t *
+sz_lz_write_length(uint8_t *out, size_t length)
+{
+  for (; length >= 255; length -= 255) {
+    *out++ = 255;
+  }
+
+  *out++ = uint8_t(length);
+  return out;
+}
+
+
+// Writes a sequence of literals followed by a match, or only literals if
+// match_length is 0. Returns NULL if it doesn't fit before limit.
+static
+uint8_t *
+sz_lz_write_sequence(
+  uint8_t *out,
+  const uint8_t *limit,
+  const uint8_t *literals,
+  size_t literal_length,
+  size_t offset,
+  size_t match_length
+  )
+{
+  const size_t match_code = match_length ? match_length - SZ_LZ_MIN_MATCH : 0;
+  const size_t worst_case =
+    1 + literal_length + literal_length / 255 + 1 + 2 + match_code / 255 + 1;
+
+  if (size_t(limit - out) < worst_case) {
+    return NULL;
+  }
+
+  *out++ = uint8_t(
+      (std::min(literal_length, size_t(15)) << 4)
+    | std::min(match_code, size_t(15))
+    );
+
+  if (literal_length >= 15) {
+    out = sz_lz_write_length(out, literal_length - 15);
+  }
+
+  memcpy(out, literals, literal_length);
+  out += literal_length;
+
+  if (match_length) {
+    *out++ = uint8_t(offset);
+    *out++ = uint8_t(offset >> 8);
+
+    if (match_code >= 15) {
+      out = sz_lz_write_length(out, match_code - 15);
+    }
+  }
+
+  return out;
+}
+
+
+// Compresses length bytes from in to out. Returns the compressed size, or 0
+// if it wouldn't be smaller than capacity.
+static
+size_t
+sz_lz_compress(const uint8_t *in, size_t length, uint8_t *out, size_t capacity)
+{
+  // Positions are stored plus one so that zero means empty.
+  uint16_t table[1 << SZ_LZ_HASH_BITS] = { 0 };
+  const uint8_t *const limit = out + capacity;
+  uint8_t *const start = out;
+  size_t anchor = 0;
+  size_t position = 0;
+  size_t misses = 0;
+
+  while (position + SZ_LZ_MIN_MATCH <= length) {
+    const uint32_t value = sz_lz_read32(in + position);
+    const uint32_t hash = sz_lz_hash(value);
+    const size_t candidate = table[hash];
+
+    table[hash] = uint16_t(position + 1);
+
+    if (candidate == 0
+        || position + 1 - candidate > SZ_LZ_MAX_OFFSET
+        || sz_lz_read32(in + candidate - 1) != value) {
+      // Step faster through data that isn't matching.
+      position += 1 + (misses++ >> 5);
+      continue;
+    }
+
+    const size_t match = candidate - 1;
+    size_t match_length = SZ_LZ_MIN_MATCH;
+
+    while (position + match_length < length
+           && in[match + match_length] == in[position + match_length]) {
+      ++match_length;
+    }
+
+    out = sz_lz_write_sequence(
+      out,
+      limit,
+      in + anchor,
+      position - anchor,
+      position - match,
+      match_length
+      );
+
+    if (out == NULL) {
+      return 0;
+    }
+
+    position += match_length;
+    anchor = position;
+    misses = 0;
+  }
+
+  out = sz_lz_write_sequence(out, limit, in + anchor, length - anchor, 0, 0);
+
+  return out && out < limit ? size_t(out - start) : 0;
+}
+
+
+// Reads a length continued past a nibble of 15. Returns false on success,
+// true if the input ends first.
+static
+bool
+sz_lz_read_length(const uint8_t **in, const uint8_t *end, size_t *length)
+{
+  if (*length != 15) {
+    return false;
+  }
+
+  for (;;) {
+    if (*in == end) {
+      return true;
+    }
+
+    const uint8_t byte = *(*in)++;
+    *length += byte;
+
+    if (byte != 255) {
+      return false;
+    }
+  }
+}
+
+
+// Decompresses length bytes from in to exactly size bytes at out. Returns
+// false on success, true if the data is malformed.
+static
+bool
+sz_lz_decompress(const uint8_t *in, size_t length, uint8_t *out, size_t size)
+{
+  const uint8_t *const end = in + length;
+  size_t position = 0;
+
+  while (in < end) {
+    const uint8_t token = *in++;
+    size_t literal_length = token >> 4;
+    size_t match_length = token & 15;
+
+    if (sz_lz_read_length(&in, end, &literal_length)
+        || literal_length > size_t(end - in)
+        || literal_length > size - position) {
+      return true;
+    }
+
+    memcpy(out + position, in, literal_length);
+    in += literal_length;
+    position += literal_length;
+
+    if (in == end) {
+      break;
+    } else if (end - in < 2) {
+      return true;
+    }
+
+    const size_t offset = size_t(in[0]) | (size_t(in[1]) << 8);
+    in += 2;
+
+    if (sz_lz_read_length(&in, end, &match_length)) {
+      return true;
+    }
+
+    match_length += SZ_LZ_MIN_MATCH;
+
+    if (offset == 0 || offset > position || match_length > size - position) {
+      return true;
+    }
+
+    const uint8_t *match = out + position - offset;
+
+    if (offset >= match_length) {
+      memcpy(out + position, match, match_length);
+    } else {
+      // Overlapping matches repeat the bytes just written.
+      for (size_t index = 0; index < match_length; ++index) {
+        out[position + index] = match[index];
+      }
+    }
+
+    position += match_length;
+  }
+
+  return position != size;
+}
+
+
+// XORs each of count values in in with the value before it, starting with
+// previous, and returns the last value.
+template <typename T>
+static
+T
+sz_xor_encode(const uint8_t *in, size_t count, T previous, uint8_t *out)
+{
+  for (size_t index = 0; index < count; ++index) {
+    T value;
+    memcpy(&value, in + index * sizeof(T), sizeof(T));
+    const T delta = T(value ^ previous);
+    memcpy(out + index * sizeof(T), &delta, sizeof(T));
+    previous = value;
+  }
+
+  return previous;
+}
+
+
+// Undoes sz_xor_encode in place and returns the last value.
+template <typename T>
+static
+T
+sz_xor_decode(uint8_t *values, size_t count, T previous)
+{
+  for (size_t index = 0; index < count; ++index) {
+    T delta;
+    memcpy(&delta, values + index * sizeof(T), sizeof(T));
+    previous = T(previous ^ delta);
+    memcpy(values + index * sizeof(T), &previous, sizeof(T));
+  }
+
+  return previous;
+}
+
+
+#if SZ_ARRAY_CODEC_X86
+
+// Gathers the bytes of four floats by plane, and back again.
+static const uint8_t sz_shuffle_transpose4[16] = {
+  0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15
+};
+
+
+// Transposes a 4x4 matrix of 32-bit lanes held in rows.
+__attribute__((target("ssse3")))
+static
+void
+sz_transpose_4x4_epi32(__m128i rows[4])
+{
+  const __m128i low01 = _mm_unpacklo_epi32(rows[0], rows[1]);
+  const __m128i low23 = _mm_unpacklo_epi32(rows[2], rows[3]);
+  const __m128i high01 = _mm_unpackhi_epi32(rows[0], rows[1]);
+  const __m128i high23 = _mm_unpackhi_epi32(rows[2], rows[3]);
+
+  rows[0] = _mm_unpacklo_epi64(low01, low23);
+  rows[1] = _mm_unpackhi_epi64(low01, low23);
+  rows[2] = _mm_unpacklo_epi64(high01, high23);
+  rows[3] = _mm_unpackhi_epi64(high01, high23);
+}
+
+
+// Shuffles 16 floats at a time into planes that are count bytes apart.
+// Returns the number of floats shuffled.
+__attribute__((target("ssse3")))
+static
+size_t
+sz_shuffle4_ssse3(const uint8_t *in, size_t count, uint8_t *out)
+{
+  const __m128i transpose =
+    _mm_loadu_si128((const __m128i *)sz_shuffle_transpose4);
+  size_t index = 0;
+
+  for (; index + 16 <= count; index += 16) {
+    __m128i rows[4];
+
+    for (int row = 0; row < 4; ++row) {
+      rows[row] = _mm_shuffle_epi8(
+        _mm_loadu_si128((const __m128i *)(in + index * 4 + row * 16)),
+        transpose
+        );
+    }
+
+    sz_transpose_4x4_epi32(rows);
+
+    for (int plane = 0; plane < 4; ++plane) {
+      _mm_storeu_si128((__m128i *)(out + plane * count + index), rows[plane]);
+    }
+  }
+
+  return index;
+}
+
+
+__attribute__((target("ssse3")))
+static
+size_t
+sz_unshuffle4_ssse3(const uint8_t *in, size_t count, uint8_t *out)
+{
+  const __m128i transpose =
+    _mm_loadu_si128((const __m128i *)sz_shuffle_transpose4);
+  size_t index = 0;
+
+  for (; index + 16 <= count; index += 16) {
+    __m128i rows[4];
+
+    for (int plane = 0; plane < 4; ++plane) {
+      rows[plane] =
+        _mm_loadu_si128((const __m128i *)(in + plane * count + index));
+    }
+
+    sz_transpose_4x4_epi32(rows);
+
+    for (int row = 0; row < 4; ++row) {
+      _mm_storeu_si128(
+        (__m128i *)(out + index * 4 + row * 16),
+        _mm_shuffle_epi8(rows[row], transpose)
+        );
+    }
+  }
+
+  return index;
+}
+
+#endif
+
+
+static
+void
+sz_shuffle(const uint8_t *in, size_t count, size_t value_size, uint8_t *out)
+{
+  size_t index = 0;
+
+#if SZ_ARRAY_CODEC_X86
+  if (value_size == 4 && SZ_CPU_HAS("ssse3")) {
+    index = sz_shuffle4_ssse3(in, count, out);
+  }
+#endif
+
+  // Planes are ordered from the least significant byte up on any host.
+  const bool big_endian = sz_host_big_endian();
+
+  for (; index < count; ++index) {
+    for (size_t byte = 0; byte < value_size; ++byte) {
+      const size_t plane = big_endian ? value_size - 1 - byte : byte;
+      out[plane * count + index] = in[index * value_size + byte];
+    }
+  }
+}
+
+
+static
+void
+sz_unshuffle(const uint8_t *in, size_t count, size_t value_size, uint8_t *out)
+{
+  size_t index = 0;
+
+#if SZ_ARRAY_CODEC_X86
+  if (value_size == 4 && SZ_CPU_HAS("ssse3")) {
+    index = sz_unshuffle4_ssse3(in, count, out);
+  }
+#endif
+
+  const bool big_endian = sz_host_big_endian();
+
+  for (; index < count; ++index) {
+    for (size_t byte = 0; byte < value_size; ++byte) {
+      const size_t plane = big_endian ? value_size - 1 - byte : byte;
+      out[index * value_size + byte] = in[plane * count + index];
+    }
+  }
+}
+
+
+static
+size_t
+sz_shuffle_encode(
+  const uint8_t *in,
+  size_t count,
+  size_t value_size,
+  bool xor_delta,
+  uint8_t *out
+  )
+{
+  uint8_t deltas[SZ_SHUFFLE_BLOCK_SIZE];
+  uint8_t planes[SZ_SHUFFLE_BLOCK_SIZE];
+  const size_t block_count = SZ_SHUFFLE_BLOCK_SIZE / value_size;
+  uint8_t *const start = out;
+  uint64_t previous = 0;
+
+  for (size_t first = 0; first < count; first += block_count) {
+    const size_t length = std::min(count - first, block_count);
+    const size_t size = length * value_size;
+    const uint8_t *source = in + first * value_size;
+
+    if (xor_delta) {
+      if (value_size == sizeof(uint64_t)) {
+        previous = sz_xor_encode<uint64_t>(source, length, previous, deltas);
+      } else {
+        previous = sz_xor_encode<uint32_t>(
+          source,
+          length,
+          uint32_t(previous),
+          deltas
+          );
+      }
+
+      source = deltas;
+    }
+
+    sz_shuffle(source, length, value_size, planes);
+
+    size_t compressed =
+      sz_lz_compress(planes, size, out + sizeof(uint32_t), size);
+
+    if (compressed == 0) {
+      memcpy(out + sizeof(uint32_t), planes, size);
+      compressed = size;
+    }
+
+    sz_store_le<uint32_t>(out, uint32_t(compressed));
+    out += sizeof(uint32_t) + compressed;
+  }
+
+  return size_t(out - start);
+}
+
+
+static
+bool
+sz_shuffle_decode(
+  const uint8_t *in,
+  size_t length,
+  size_t value_size,
+  bool xor_delta,
+  uint8_t *out,
+  size_t count
+  )
+{
+  uint8_t planes[SZ_SHUFFLE_BLOCK_SIZE];
+  const size_t block_count = SZ_SHUFFLE_BLOCK_SIZE / value_size;
+  const uint8_t *const end = in + length;
+  uint64_t previous = 0;
+
+  for (size_t first = 0; first < count; first += block_count) {
+    const size_t block_length = std::min(count - first, block_count);
+    const size_t size = block_length * value_size;
+    uint8_t *const values = out + first * value_size;
+
+    if (size_t(end - in) < sizeof(uint32_t)) {
+      return true;
+    }
+
+    const size_t compressed = sz_load_le<uint32_t>(in);
+    const uint8_t *source = in + sizeof(uint32_t);
+
+    in += sizeof(uint32_t);
+
+    if (compressed > size || compressed > size_t(end - in)) {
+      return true;
+    } else if (compressed < size) {
+      if (sz_lz_decompress(in, compressed, planes, size)) {
+        return true;
+      }
+
+      source = planes;
+    }
+
+    in += compressed;
+    sz_unshuffle(source, block_length, value_size, values);
+
+    if (xor_delta) {
+      if (value_size == sizeof(uint64_t)) {
+        previous = sz_xor_decode<uint64_t>(values, block_length, previous);
+      } else {
+        previous =
+          sz_xor_decode<uint32_t>(values, block_length, uint32_t(previous));
+      }
+    }
+  }
+
+  return in != end;
+}
+
+
+/*==============================================================================
+  Reduced precision floats (SZ_ENCODING_HALF, SZ_ENCODING_BFLOAT16,
+  SZ_ENCODING_QUANTIZED16)
+
+  Each float is stored in 16 bits: as an IEEE half (rounded to nearest even),
+  as its upper 16 bits (bfloat16, rounded to nearest even), or quantized to
+  its position between the smallest and largest finite values of the array.
+  Quantized arrays start with the smallest value and the step between levels
+  as floats, and each value decodes to smallest + level * step. NaNs are
+  quantized to the smallest value and infinities are clamped to the range.
+
+  The vector kernels convert 8 values at a time using F16C for halves and AVX2
+  for the rest. The scalar conversions match them bit for bit.
+==============================================================================*/
+
+enum {
+  SZ_QUANTIZED_HEADER_SIZE = 2 * sizeof(float),
+  SZ_QUANTIZED_LEVELS = 65535
+};
+
+
+static
+uint32_t
+sz_float_bits(float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+
+static
+float
+sz_bits_float(uint32_t bits)
+{
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+
+// Shifts value right, rounding to nearest even.
+static
+uint32_t
+sz_shift_round_even(uint32_t value, unsigned shift)
+{
+  const uint32_t half = 1U << (shift - 1);
+  const uint32_t remainder = value & ((1U << shift) - 1);
+  const uint32_t result = value >> shift;
+  return result + (remainder > half || (remainder == half && (result & 1)));
+}
+
+
+static
+uint16_t
+sz_float_to_half(float value)
+{
+  const uint32_t bits = sz_float_bits(value);
+  const uint32_t sign = (bits >> 16) & 0x8000U;
+  const uint32_t magnitude = bits & 0x7FFFFFFFU;
+
+  if (magnitude > 0x7F800000U) {
+    // NaNs stay NaNs, quieted, keeping the top of their payload.
+    return uint16_t(sign | 0x7E00U | ((magnitude >> 13) & 0x3FFU));
+  } else if (magnitude >= 0x477FF000U) {
+    // At or past the point that rounds to infinity.
+    return uint16_t(sign | 0x7C00U);
+  } else if (magnitude >= 0x38800000U) {
+    // Normal halves. Rounding may carry into the exponent, which is correct.
+    return uint16_t(
+      sign | sz_shift_round_even(magnitude - 0x38000000U, 13)
+      );
+  } else if (magnitude > 0x33000000U) {
+    // Subnormal halves count in units of 2^-24.
+    const uint32_t exponent = magnitude >> 23;
+    const uint32_t mantissa = (magnitude & 0x7FFFFFU) | 0x800000U;
+    return uint16_t(sign | sz_shift_round_even(mantissa, 126 - exponent));
+  }
+
+  return uint16_t(sign);
+}
+
+
+static
+float
+sz_half_to_float(uint16_t half)
+{
+  const uint32_t sign = uint32_t(half & 0x8000U) << 16;
+  const uint32_t exponent = (half >> 10) & 0x1FU;
+  uint32_t mantissa = half & 0x3FFU;
+
+  if (exponent == 0x1FU) {
+    return sz_bits_float(
+      sign | 0x7F800000U | (mantissa << 13) | (mantissa ? 0x400000U : 0)
+      );
+  } else if (exponent != 0) {
+    return sz_bits_float(sign | ((exponent + 112) << 23) | (mantissa << 13));
+  } else if (mantissa == 0) {
+    return sz_bits_float(sign);
+  }
+
+  // Subnormal halves are normal floats.
+  uint32_t float_exponent = 113;
+
+  while ((mantissa & 0x400U) == 0) {
+    mantissa <<= 1;
+    --float_exponent;
+  }
+
+  return sz_bits_float(
+    sign | (float_exponent << 23) | ((mantissa & 0x3FFU) << 13)
+    );
+}
+
+
+static
+uint16_t
+sz_float_to_bfloat16(float value)
+{
+  const uint32_t bits = sz_float_bits(value);
+
+  if ((bits & 0x7FFFFFFFU) > 0x7F800000U) {
+    return uint16_t((bits >> 16) | 0x40U);
+  }
+
+  return uint16_t((bits + 0x7FFFU + ((bits >> 16) & 1)) >> 16);
+}
+
+
+static
+float
+sz_bfloat16_to_float(uint16_t value)
+{
+  return sz_bits_float(uint32_t(value) << 16);
+}
+
+
+static
+uint16_t
+sz_quantize(float value, float minimum, float scale)
+{
+  const float levels = float(SZ_QUANTIZED_LEVELS);
+  float level = (value - minimum) * scale;
+  // Written so NaNs become 0, as with maxps/minps.
+  level = level > 0.0f ? level : 0.0f;
+  level = level < levels ? level : levels;
+  return uint16_t(lrintf(level));
+}
+
+
+#if SZ_ARRAY_CODEC_X86
+
+__attribute__((target("avx,f16c")))
+static
+size_t
+sz_halves_encode_f16c(const float *in, size_t count, uint8_t *out)
+{
+  size_t index = 0;
+
+  for (; index + 8 <= count; index += 8) {
+    _mm_storeu_si128(
+      (__m128i *)(out + index * 2),
+      _mm256_cvtps_ph(_mm256_loadu_ps(in + index), _MM_FROUND_TO_NEAREST_INT)
+      );
+  }
+
+  return index;
+}
+
+
+__attribute__((target("avx,f16c")))
+static
+size_t
+sz_halves_decode_f16c(const uint8_t *in, size_t count, float *out)
+{
+  size_t index = 0;
+
+  for (; index + 8 <= count; index += 8) {
+    _mm256_storeu_ps(
+      out + index,
+      _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)(in + index * 2)))
+      );
+  }
+
+  return index;
+}
+
+
+// Narrows eight 32-bit lanes holding 16-bit values to 16 bits.
+__attribute__((target("avx2")))
+static
+__m128i
+sz_narrow_epi32_avx2(__m256i values)
+{
+  const __m256i packed = _mm256_packus_epi32(values, values);
+  return _mm256_castsi256_si128(
+    _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0))
+    );
+}
+
+
+__attribute__((target("avx2")))
+static
+size_t
+sz_bfloat16s_encode_avx2(const float *in, size_t count, uint8_t *out)
+{
+  const __m256i magnitude_mask = _mm256_set1_epi32(0x7FFFFFFF);
+  const __m256i infinity = _mm256_set1_epi32(0x7F800000);
+  const __m256i rounding = _mm256_set1_epi32(0x7FFF);
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i quiet = _mm256_set1_epi32(0x40);
+  size_t index = 0;
+
+  for (; index + 8 <= count; index += 8) {
+    const __m256i bits = _mm256_loadu_si256((const __m256i *)(in + index));
+    const __m256i nan = _mm256_cmpgt_epi32(
+      _mm256_and_si256(bits, magnitude_mask),
+      infinity
+      );
+    const __m256i high = _mm256_srli_epi32(bits, 16);
+    const __m256i rounded = _mm256_srli_epi32(
+      _mm256_add_epi32(
+        _mm256_add_epi32(bits, rounding),
+        _mm256_and_si256(high, one)
+        ),
+      16
+      );
+    const __m256i values =
+      _mm256_blendv_epi8(rounded, _mm256_or_si256(high, quiet), nan);
+
+    _mm_storeu_si128(
+      (__m128i *)(out + index * 2),
+      sz_narrow_epi32_avx2(values)
+      );
+  }
+
+  return index;
+}
+
+
+__attribute__((target("avx2")))
+static
+size_t
+sz_bfloat16s_decode_avx2(const uint8_t *in, size_t count, float *out)
+{
+  size_t index = 0;
+
+  for (; index + 8 <= count; index += 8) {
+    const __m256i values = _mm256_cvtepu16_epi32(
+      _mm_loadu_si128((const __m128i *)(in + index * 2))
+      );
+    _mm256_storeu_si256(
+      (__m256i *)(out + index),
+      _mm256_slli_epi32(values, 16)
+      );
+  }
+
+  return index;
+}
+
+
+__attribute__((target("avx2")))
+static
+size_t
+sz_quantize_avx2(
+  const float *in,
+  size_t count,
+  float minimum,
+  float scale,
+  uint8_t *out
+  )
+{
+  const __m256 offset = _mm256_set1_ps(minimum);
+  const __m256 factor = _mm256_set1_ps(scale);
+  const __m256 zero = _mm256_setzero_ps();
+  const __m256 levels = _mm256_set1_ps(float(SZ_QUANTIZED_LEVELS));
+  size_t index = 0;
+
+  for (; index + 8 <= count; index += 8) {
+    __m256 level = _mm256_mul_ps(
+      _mm256_sub_ps(_mm256_loadu_ps(in + index), offset),
+      factor
+      );
+    level = _mm256_min_ps(_mm256_max_ps(level, zero), levels);
+
+    _mm_storeu_si128(
+      (__m128i *)(out + index * 2),
+      sz_narrow_epi32_avx2(_mm256_cvtps_epi32(level))
+      );
+  }
+
+  return index;
+}
+
+
+__attribute__((target("avx2")))
+static
+size_t
+sz_dequantize_avx2(
+  const uint8_t *in,
+  size_t count,
+  float minimum,
+  float step,
+  float *out
+  )
+{
+  const __m256 offset = _mm256_set1_ps(minimum);
+  const __m256 factor = _mm256_set1_ps(step);
+  size_t index = 0;
+
+  for (; index + 8 <= count; index += 8) {
+    const __m256i levels = _mm256_cvtepu16_epi32(
+      _mm_loadu_si128((const __m128i *)(in + index * 2))
+      );
+    _mm256_storeu_ps(
+      out + index,
+      _mm256_add_ps(
+        offset,
+        _mm256_mul_ps(_mm256_cvtepi32_ps(levels), factor)
+        )
+      );
+  }
+
+  return index;
+}
+
+#endif
+
+
+static
+size_t
+sz_reduced_bound(sz_array_encoding_t encoding, size_t count)
+{
+  const size_t header =
+    encoding == SZ_ENCODING_QUANTIZED16 ? SZ_QUANTIZED_HEADER_SIZE : 0;
+  return header + count * sizeof(uint16_t);
+}
+
+
+static
+size_t
+sz_reduced_encode(
+  sz_array_encoding_t encoding,
+  const float *in,
+  size_t count,
+  uint8_t *out
+  )
+{
+  uint8_t *const start = out;
+  float minimum = 0.0f;
+  float scale = 0.0f;
+  size_t index = 0;
+
+  if (encoding == SZ_ENCODING_QUANTIZED16) {
+    float maximum = 0.0f;
+    bool found = false;
+
+    for (size_t value = 0; value < count; ++value) {
+      // Skips NaNs and infinities.
+      if (in[value] - in[value] != 0.0f) {
+        continue;
+      } else if (!found) {
+        minimum = maximum = in[value];
+        found = true;
+      } else {
+        minimum = std::min(minimum, in[value]);
+        maximum = std::max(maximum, in[value]);
+      }
+    }
+
+    const double range = double(maximum) - double(minimum);
+    const float step = float(range / SZ_QUANTIZED_LEVELS);
+
+    scale = range > 0.0 ? float(SZ_QUANTIZED_LEVELS / range) : 0.0f;
+
+    sz_store_le<uint32_t>(out, sz_float_bits(minimum));
+    sz_store_le<uint32_t>(out + sizeof(float), sz_float_bits(step));
+    out += SZ_QUANTIZED_HEADER_SIZE;
+  }
+
+#if SZ_ARRAY_CODEC_X86
+  if (encoding == SZ_ENCODING_HALF && SZ_CPU_HAS("f16c")) {
+    index = sz_halves_encode_f16c(in, count, out);
+  } else if (encoding == SZ_ENCODING_BFLOAT16
+             && SZ_CPU_HAS("avx2")) {
+    index = sz_bfloat16s_encode_avx2(in, count, out);
+  } else if (encoding == SZ_ENCODING_QUANTIZED16
+             && SZ_CPU_HAS("avx2")) {
+    index = sz_quantize_avx2(in, count, minimum, scale, out);
+  }
+#endif
+
+  for (; index < count; ++index) {
+    uint16_t value;
+
+    switch (encoding) {
+    case SZ_ENCODING_HALF: value = sz_float_to_half(in[index]); break;
+    case SZ_ENCODING_BFLOAT16: value = sz_float_to_bfloat16(in[index]); break;
+    default: value = sz_quantize(in[index], minimum, scale); break;
+    }
+
+    sz_store_le<uint16_t>(out + index * sizeof(uint16_t), value);
+  }
+
+  return size_t(out - start) + count * sizeof(uint16_t);
+}
+
+
+static
+bool
+sz_reduced_decode(
+  sz_array_encoding_t encoding,
+  const uint8_t *in,
+  size_t length,
+  float *out,
+  size_t count
+  )
+{
+  float minimum = 0.0f;
+  float step = 0.0f;
+  size_t index = 0;
+
+  if (length != sz_reduced_bound(encoding, count)) {
+    return true;
+  }
+
+  if (encoding == SZ_ENCODING_QUANTIZED16) {
+    minimum = sz_bits_float(sz_load_le<uint32_t>(in));
+    step = sz_bits_float(sz_load_le<uint32_t>(in + sizeof(float)));
+    in += SZ_QUANTIZED_HEADER_SIZE;
+  }
+
+#if SZ_ARRAY_CODEC_X86
+  if (encoding == SZ_ENCODING_HALF && SZ_CPU_HAS("f16c")) {
+    index = sz_halves_decode_f16c(in, count, out);
+  } else if (encoding == SZ_ENCODING_BFLOAT16
+             && SZ_CPU_HAS("avx2")) {
+    index = sz_bfloat16s_decode_avx2(in, count, out);
+  } else if (encoding == SZ_ENCODING_QUANTIZED16
+             && SZ_CPU_HAS("avx2")) {
+    index = sz_dequantize_avx2(in, count, minimum, step, out);
+  }
+#endif
+
+  for (; index < count; ++index) {
+    const uint16_t value = sz_load_le<uint16_t>(in + index * sizeof(uint16_t));
+
+    switch (encoding) {
+    case SZ_ENCODING_HALF: out[index] = sz_half_to_float(value); break;
+    case SZ_ENCODING_BFLOAT16: out[index] = sz_bfloat16_to_float(value); break;
+    default: out[index] = minimum + float(value) * step; break;
+    }
+  }
+
+  return false;
+}
+
+
+/*==============================================================================
+  Dispatch
+==============================================================================*/
+
+void
+sz_array_codec_use_simd(bool enabled)
+{
+  sz_array_codec_simd = enabled;
+}
+
+
+bool
+sz_array_encoding_applies(sz_array_encoding_t encoding, sz_chunk_id_t type)
+{
+  switch (encoding) {
+  case SZ_ENCODING_VARINT:
+    return type == SZ_UINT32_CHUNK || type == SZ_SINT32_CHUNK;
+
+  case SZ_ENCODING_PACKED_DELTAS:
+    return
+      type == SZ_UINT32_CHUNK || type == SZ_SINT32_CHUNK ||
+      type == SZ_UINT64_CHUNK || type == SZ_SINT64_CHUNK;
+
+  case SZ_ENCODING_SHUFFLE:
+  case SZ_ENCODING_XOR_SHUFFLE:
+    return type == SZ_FLOAT_CHUNK || type == SZ_DOUBLE_CHUNK;
+
+  case SZ_ENCODING_HALF:
+  case SZ_ENCODING_BFLOAT16:
+  case SZ_ENCODING_QUANTIZED16:
+    return type == SZ_FLOAT_CHUNK;
+
+  default:
+    return false;
+  }
+}
+
+
+size_t
+sz_array_encoded_bound(
+  sz_array_encoding_t encoding,
+  sz_chunk_id_t type,
+  size_t count
+  )
+{
+  switch (encoding) {
+  case SZ_ENCODING_VARINT: return sz_vbyte_bound(count);
+
+  case SZ_ENCODING_PACKED_DELTAS:
+    if (type == SZ_UINT64_CHUNK || type == SZ_SINT64_CHUNK) {
+      return sz_packed_bound<uint64_t>(count);
+    }
+    return sz_packed_bound<uint32_t>(count);
+
+  case SZ_ENCODING_SHUFFLE:
+  case SZ_ENCODING_XOR_SHUFFLE:
+    return sz_shuffle_bound(count, sz_shuffle_value_size(type));
+
+  case SZ_ENCODING_HALF:
+  case SZ_ENCODING_BFLOAT16:
+  case SZ_ENCODING_QUANTIZED16:
+    return sz_reduced_bound(encoding, count);
+
+  default: return 0;
+  }
+}
+
+
+size_t
+sz_array_encode(
+  sz_array_encoding_t encoding,
+  sz_chunk_id_t type,
+  const void *in,
+  size_t count,
+  uint8_t *out
+  )
+{
+  switch (encoding) {
+  case SZ_ENCODING_VARINT:
+    return sz_vbyte_encode(
+      (const uint32_t *)in,
+      count,
+      type == SZ_SINT32_CHUNK,
+      out
+      );
+
+  case SZ_ENCODING_PACKED_DELTAS:
+    if (type == SZ_UINT64_CHUNK || type == SZ_SINT64_CHUNK) {
+      return sz_packed_encode((const uint64_t *)in, count, out);
+    }
+    return sz_packed_encode((const uint32_t *)in, count, out);
+
+  case SZ_ENCODING_SHUFFLE:
+  case SZ_ENCODING_XOR_SHUFFLE:
+    return sz_shuffle_encode(
+      (const uint8_t *)in,
+      count,
+      sz_shuffle_value_size(type),
+      encoding == SZ_ENCODING_XOR_SHUFFLE,
+      out
+      );
+
+  case SZ_ENCODING_HALF:
+  case SZ_ENCODING_BFLOAT16:
+  case SZ_ENCODING_QUANTIZED16:
+    return sz_reduced_encode(encoding, (const float *)in, count, out);
+
+  default: break;
+  }
+
+  return 0;
+}
+
+
+bool
+sz_array_decode(
+  sz_array_encoding_t encoding,
+  sz_chunk_id_t type,
+  const uint8_t *in,
+  size_t length,
+  void *out,
+  size_t count
+  )
+{
+  if (!sz_array_encoding_applies(encoding, type)) {
+    return true;
+  }
+
+  switch (encoding) {
+  case SZ_ENCODING_VARINT:
+    return sz_vbyte_decode(
+      in,
+      length,
+      (uint32_t *)out,
+      count,
+      type == SZ_SINT32_CHUNK
+      );
+
+  case SZ_ENCODING_PACKED_DELTAS:
+    if (type == SZ_UINT64_CHUNK || type == SZ_SINT64_CHUNK) {
+      return sz_packed_decode(in, length, (uint64_t *)out, count);
+    }
+    return sz_packed_decode(in, length, (uint32_t *)out, count);
+
+  case SZ_ENCODING_SHUFFLE:
+  case SZ_ENCODING_XOR_SHUFFLE:
+    return sz_shuffle_decode(
+      in,
+      length,
+      sz_shuffle_value_size(type),
+      encoding == SZ_ENCODING_XOR_SHUFFLE,
+      (uint8_t *)out,
+      count
+      );
+
+  case SZ_ENCODING_HALF:
+  case SZ_ENCODING_BFLOAT16:
+  case SZ_ENCODING_QUANTIZED16:
+    return sz_reduced_decode(encoding, in, length, (float *)out, count);
+
+  default: break;
+  }
+
+  return true;
+}
@@ -0,0 +1,88 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+#ifndef __SZ_SNOWBALL__ARRAY_CODEC_HH__
+#define __SZ_SNOWBALL__ARRAY_CODEC_HH__
+
+
+#include <snowball.h>
+
+
+// An encoded array's sz_array_t::type holds its element type in the low 16
+// bits and its sz_array_encoding_t in the high 16 bits. Its length is the
+// number of elements once decoded, and its payload is the encoded data.
+// Encoded data is always little-endian, so it's read the same way on any host.
+#define SZ_ARRAY_TYPE_MASK (0xFFFFU)
+#define SZ_ARRAY_ENCODING_SHIFT (16)
+
+
+// Returns whether arrays of the given type can be stored with the encoding.
+SZ_HIDDEN
+bool
+sz_array_encoding_applies(sz_array_encoding_t encoding, sz_chunk_id_t type);
+
+// Returns the largest number of bytes count elements of the given type can
+// take once encoded. The encoding must apply to the type.
+SZ_HIDDEN
+size_t
+sz_array_encoded_bound(
+  sz_array_encoding_t encoding,
+  sz_chunk_id_t type,
+  size_t count
+  );
+
+// Encodes count elements of the given type from in to out, which must have
+// room for sz_array_encoded_bound() bytes. Returns the number of bytes
+// written.
+SZ_HIDDEN
+size_t
+sz_array_encode(
+  sz_array_encoding_t encoding,
+  sz_chunk_id_t type,
+  const void *in,
+  size_t count,
+  uint8_t *out
+  );
+
+// Decodes count elements of the given type from the length bytes at in to
+// out, in host byte order. Returns false on success, true if the data is
+// malformed or the encoding is unknown.
+SZ_HIDDEN
+bool
+sz_array_decode(
+  sz_array_encoding_t encoding,
+  sz_chunk_id_t type,
+  const uint8_t *in,
+  size_t length,
+  void *out,
+  size_t count
+  );
+
+// Enables or disables the codecs' SIMD paths, which are taken by default where
+// the CPU supports them. Encoded data is the same either way, so this is only
+// for tests comparing the two. Not thread-safe.
+SZ_HIDDEN
+void
+sz_array_codec_use_simd(bool enabled);
+
+
+#endif /* end __SZ_SNOWBALL__ARRAY_CODEC_HH__ include guard */
@@ -22,19 +22,9 @@
 
 #include "bufstream.hh"
 
-#include <sstream>
 
-
-typedef std::basic_stringstream<
-#if __cplusplus >= 201103L
-  char,
-  std::char_traits<char>,
-  sz_cxx_allocator_t<char>
-#else
-  char,
-  std::char_traits<char>
-#endif
-  > sz_buffer_t;
+// Smallest capacity allocated for a buffer stream that's written to.
+#define SZ_BUFSTREAM_MIN_CAPACITY (256)
 
 
 static
@@ -47,6 +37,11 @@ size_t
 sz_bufstream_write(const void *in, size_t length, sz_stream_t *stream);
 
 
+static
+size_t
+sz_bufstream_writev(const sz_iovec_t *iov, size_t count, sz_stream_t *stream);
+
+
 static
 off_t
 sz_bufstream_seek(off_t off, int whence, sz_stream_t *stream);
@@ -62,40 +57,14 @@ void
 sz_bufstream_close(sz_stream_t *stream);
 
 
-struct SZ_HIDDEN sz_bufstream_t
-{
-  sz_stream_t base;
-  sz_allocator_t *alloc;
-  sz_mode_t mode;
-  uint8_t opaque[sizeof(sz_buffer_t)];
-
-  sz_buffer_t *buffer()
-  {
-    return (sz_buffer_t *)&opaque[0];
-  }
-
-  void init()
-  {
-    new (opaque) sz_buffer_t(
-    #if __cplusplus >= 201103L
-      sz_bufstring_t(sz_cxx_allocator_t<char>(alloc))
-    #endif
-      );
-  }
-
-  void finalize()
-  {
-    buffer()->~sz_buffer_t();
-  }
-};
-
-
 static sz_stream_t sz_bufstream_base = {
   sz_bufstream_read,
   sz_bufstream_write,
   sz_bufstream_seek,
   sz_bufstream_eof,
-  sz_bufstream_close
+  sz_bufstream_close,
+  NULL,
+  sz_bufstream_writev
 };
 
 
@@ -103,17 +72,62 @@ sz_stream_t *
 sz_buffer_stream(sz_mode_t mode, sz_allocator_t *alloc)
 {
   sz_bufstream_t *stream = (sz_bufstream_t *)sz_malloc(sizeof(sz_bufstream_t), alloc);
+  if (stream == NULL) {
+    return NULL;
+  }
   stream->base = sz_bufstream_base;
-  stream->init();
+  stream->alloc = alloc;
   stream->mode = mode;
+  stream->eof = 0;
+  stream->data = NULL;
+  stream->size = 0;
+  stream->capacity = 0;
+  stream->pos = 0;
   return (sz_stream_t *)stream;
 }
 
 
-sz_bufstring_t
-sz_buffer_stream_data(sz_stream_t *stream)
+bool
+sz_buffer_stream_reserve(sz_bufstream_t *stream, size_t min_capacity)
 {
-  return ((sz_bufstream_t *)stream)->buffer()->str();
+  if (min_capacity <= stream->capacity) {
+    return true;
+  }
+
+  size_t new_capacity =
+    stream->capacity ? stream->capacity : SZ_BUFSTREAM_MIN_CAPACITY;
+  while (new_capacity < min_capacity) {
+    if (new_capacity > ~size_t(0) / 2) {
+      new_capacity = min_capacity;
+      break;
+    }
+    new_capacity *= 2;
+  }
+
+  uint8_t *new_data = (uint8_t *)sz_malloc(new_capacity, stream->alloc);
+  if (new_data == NULL) {
+    return false;
+  }
+
+  if (stream->data) {
+    memcpy(new_data, stream->data, stream->size);
+    sz_free(stream->data, stream->alloc);
+  }
+
+  stream->data = new_data;
+  stream->capacity = new_capacity;
+  return true;
+}
+
+
+const void *
+sz_buffer_stream_data(sz_stream_t *stream, size_t *length)
+{
+  sz_bufstream_t *bufstream = (sz_bufstream_t *)stream;
+  if (length) {
+    *length = bufstream->size;
+  }
+  return bufstream->data;
 }
 
 
@@ -122,11 +136,22 @@ size_t
 sz_bufstream_read(void *out, size_t length, sz_stream_t *stream)
 {
   sz_bufstream_t *bufstream = (sz_bufstream_t *)stream;
-  if (bufstream->mode == SZ_READER) {
-    bufstream->buffer()->read((char *)out, length);
-    return bufstream->buffer()->gcount();
+  if (bufstream->mode != SZ_READER) {
+    return 0;
   }
-  return 0;
+
+  const size_t remaining = bufstream->size - bufstream->pos;
+  if (length > remaining) {
+    length = remaining;
+    bufstream->eof = 1;
+  }
+
+  if (length) {
+    memcpy(out, bufstream->data + bufstream->pos, length);
+    bufstream->pos += length;
+  }
+
+  return length;
 }
 
 
@@ -134,13 +159,15 @@ static
 size_t
 sz_bufstream_write(const void *in, size_t length, sz_stream_t *stream)
 {
-  sz_bufstream_t *bufstream = (sz_bufstream_t *)stream;
-  if (bufstream->mode == SZ_WRITER) {
-    off_t offset = bufstream->buffer()->tellp();
-    bufstream->buffer()->write((const char *)in, length);
-    return size_t(bufstream->buffer()->tellp() - offset);
-  }
-  return 0;
+  return sz_buffer_stream_write(in, length, stream);
+}
+
+
+static
+size_t
+sz_bufstream_writev(const sz_iovec_t *iov, size_t count, sz_stream_t *stream)
+{
+  return sz_buffer_stream_writev(iov, count, stream);
 }
 
 
@@ -149,21 +176,22 @@ off_t
 sz_bufstream_seek(off_t off, int whence, sz_stream_t *stream)
 {
   sz_bufstream_t *bufstream = (sz_bufstream_t *)stream;
-  sz_buffer_t::seekdir dir = sz_buffer_t::beg;
+  off_t base = 0;
+
   switch (whence) {
-  case SEEK_CUR: dir = sz_buffer_t::cur; break;
-  case SEEK_END: dir = sz_buffer_t::end; break;
+  case SEEK_CUR: base = off_t(bufstream->pos); break;
+  case SEEK_END: base = off_t(bufstream->size); break;
   case SEEK_SET:
   default: break;
   }
 
-  if (bufstream->mode == SZ_WRITER) {
-    bufstream->buffer()->seekp(off, dir);
-    return bufstream->buffer()->tellp();
-  } else {
-    bufstream->buffer()->seekg(off, dir);
-    return bufstream->buffer()->tellg();
+  if (off < -base || off > off_t(bufstream->size) - base) {
+    return -1;
   }
+
+  bufstream->pos = size_t(base + off);
+  bufstream->eof = 0;
+  return off_t(bufstream->pos);
 }
 
 
@@ -171,7 +199,7 @@ static
 int
 sz_bufstream_eof(sz_stream_t *stream)
 {
-  return ((sz_bufstream_t *)stream)->buffer()->eof();
+  return ((sz_bufstream_t *)stream)->eof;
 }
 
 
@@ -180,6 +208,8 @@ void
 sz_bufstream_close(sz_stream_t *stream)
 {
   sz_bufstream_t *bufstream = (sz_bufstream_t *)stream;
-  bufstream->finalize();
+  if (bufstream->data) {
+    sz_free(bufstream->data, bufstream->alloc);
+  }
   sz_free(bufstream, bufstream->alloc);
 }
@@ -25,32 +25,120 @@
 
 
 #include <snowball.h>
-#include <string>
-#include "allocator_wrapper.hh"
 
+#include <cstring>
 
-typedef std::basic_string<
-#if __cplusplus >= 201103L
-  char,
-  std::char_traits<char>,
-  sz_cxx_allocator_t<char>
-#else
-  char,
-  std::char_traits<char>,
-  std::allocator<char>
-#endif
-  > sz_bufstring_t;
 
+struct SZ_HIDDEN sz_bufstream_t
+{
+  sz_stream_t base;
+  sz_allocator_t *alloc;
+  sz_mode_t mode;
+  int eof;
 
-// Returns a sz-stream backed by a stringstream. The underlying buffer
+  uint8_t *data;
+  size_t size;      // bytes written to data
+  size_t capacity;  // bytes allocated for data
+  size_t pos;
+};
+
+
+// Returns a sz-stream backed by a contiguous, growable block of memory
+// allocated using alloc. Writes go to the current position, growing the
+// buffer as needed.
 SZ_HIDDEN
 sz_stream_t *
 sz_buffer_stream(sz_mode_t mode, sz_allocator_t *alloc);
 
-// Returns the underlying string for the stream.
+// Returns a pointer to the stream's contents and writes their size to length.
+// The contents are not copied, so the pointer is only valid until the stream
+// is next written to or closed. May return NULL if the stream is empty.
+SZ_HIDDEN
+const void *
+sz_buffer_stream_data(sz_stream_t *stream, size_t *length);
+
+// Ensures a buffer stream has room for at least min_capacity bytes. Returns
+// false if the buffer couldn't be grown.
 SZ_HIDDEN
-sz_bufstring_t
-sz_buffer_stream_data(sz_stream_t *stream);
+bool
+sz_buffer_stream_reserve(sz_bufstream_t *stream, size_t min_capacity);
+
+// Empties a buffer stream without releasing its memory, so it can be reused.
+inline
+void
+sz_buffer_stream_reset(sz_stream_t *stream)
+{
+  sz_bufstream_t *bufstream = (sz_bufstream_t *)stream;
+  bufstream->size = 0;
+  bufstream->pos = 0;
+  bufstream->eof = 0;
+}
+
+// Writes length bytes to a buffer stream. Equivalent to sz_stream_write on a
+// buffer stream, but skips the indirect call so small writes can be inlined.
+inline
+size_t
+sz_buffer_stream_write(const void *in, size_t length, sz_stream_t *stream)
+{
+  sz_bufstream_t *bufstream = (sz_bufstream_t *)stream;
+  const size_t end = bufstream->pos + length;
+
+  if (bufstream->mode != SZ_WRITER || length == 0) {
+    return 0;
+  } else if (end > bufstream->capacity) {
+    if (end < length || !sz_buffer_stream_reserve(bufstream, end)) {
+      return 0;
+    }
+  }
+
+  memcpy(bufstream->data + bufstream->pos, in, length);
+  bufstream->pos = end;
+  if (end > bufstream->size) {
+    bufstream->size = end;
+  }
+
+  return length;
+}
+
+// Writes count buffers to a buffer stream as one write, growing the buffer at
+// most once. Returns the total number of bytes written, which is 0 if the
+// buffer couldn't be grown.
+inline
+size_t
+sz_buffer_stream_writev(const sz_iovec_t *iov, size_t count, sz_stream_t *stream)
+{
+  sz_bufstream_t *bufstream = (sz_bufstream_t *)stream;
+  size_t length = 0;
+
+  for (size_t index = 0; index < count; ++index) {
+    length += iov[index].length;
+  }
+
+  const size_t end = bufstream->pos + length;
+
+  if (bufstream->mode != SZ_WRITER || length == 0) {
+    return 0;
+  } else if (end > bufstream->capacity) {
+    if (end < length || !sz_buffer_stream_reserve(bufstream, end)) {
+      return 0;
+    }
+  }
+
+  uint8_t *out = bufstream->data + bufstream->pos;
+  for (size_t index = 0; index < count; ++index) {
+    if (iov[index].length) {
+      memcpy(out, iov[index].base, iov[index].length);
+      out += iov[index].length;
+    }
+  }
+
+  bufstream->pos = end;
+  if (end > bufstream->size) {
+    bufstream->size = end;
+  }
+
+  return length;
+}
 
 
 #endif /* end __BUFSTREAM_HH__ include guard */
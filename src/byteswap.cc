@@ -0,0 +1,211 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+#include "byteswap.hh"
+
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+# define SZ_BYTESWAP_X86 1
+# include <immintrin.h>
+#else
+# define SZ_BYTESWAP_X86 0
+#endif
+
+
+// Which kernels may be used -- see sz_byteswap_use_simd().
+static bool sz_byteswap_avx2_allowed = true;
+static bool sz_byteswap_ssse3_allowed = true;
+
+
+// The scalar loops are written with shifts rather than builtins so they're
+// portable -- compilers recognize them as byte swaps either way.
+static
+void
+sz_byteswap_16(uint8_t *out, const uint8_t *in, size_t count)
+{
+  for (size_t index = 0; index < count; ++index, in += 2, out += 2) {
+    uint16_t value;
+    memcpy(&value, in, sizeof(value));
+    value = uint16_t((value >> 8) | (value << 8));
+    memcpy(out, &value, sizeof(value));
+  }
+}
+
+
+static
+void
+sz_byteswap_32(uint8_t *out, const uint8_t *in, size_t count)
+{
+  for (size_t index = 0; index < count; ++index, in += 4, out += 4) {
+    uint32_t value;
+    memcpy(&value, in, sizeof(value));
+    value =
+        (value >> 24)
+      | ((value >> 8) & 0x0000FF00U)
+      | ((value << 8) & 0x00FF0000U)
+      | (value << 24);
+    memcpy(out, &value, sizeof(value));
+  }
+}
+
+
+static
+void
+sz_byteswap_64(uint8_t *out, const uint8_t *in, size_t count)
+{
+  for (size_t index = 0; index < count; ++index, in += 8, out += 8) {
+    uint64_t value;
+    memcpy(&value, in, sizeof(value));
+    value =
+        ((value >> 8) & 0x00FF00FF00FF00FFULL)
+      | ((value & 0x00FF00FF00FF00FFULL) << 8);
+    value =
+        ((value >> 16) & 0x0000FFFF0000FFFFULL)
+      | ((value & 0x0000FFFF0000FFFFULL) << 16);
+    value = (value >> 32) | (value << 32);
+    memcpy(out, &value, sizeof(value));
+  }
+}
+
+
+#if SZ_BYTESWAP_X86
+
+// pshufb masks reversing each 2-, 4-, and 8-byte element of a 16-byte lane.
+static const uint8_t sz_byteswap_masks[3][16] = {
+  { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 },
+  { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 },
+  { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 }
+};
+
+
+// Both kernels swap as many whole vectors as fit in length bytes and return
+// how many bytes that was. Elements never straddle a 16-byte lane, so the same
+// mask works for both halves of an AVX2 vector.
+__attribute__((target("ssse3")))
+static
+size_t
+sz_byteswap_ssse3(uint8_t *out, const uint8_t *in, size_t length, const uint8_t *mask)
+{
+  const __m128i shuffle = _mm_loadu_si128((const __m128i *)mask);
+  size_t offset = 0;
+
+  for (; offset + 16 <= length; offset += 16) {
+    const __m128i block = _mm_loadu_si128((const __m128i *)(in + offset));
+    _mm_storeu_si128((__m128i *)(out + offset), _mm_shuffle_epi8(block, shuffle));
+  }
+
+  return offset;
+}
+
+
+__attribute__((target("avx2")))
+static
+size_t
+sz_byteswap_avx2(uint8_t *out, const uint8_t *in, size_t length, const uint8_t *mask)
+{
+  const __m128i lane = _mm_loadu_si128((const __m128i *)mask);
+  const __m256i shuffle = _mm256_broadcastsi128_si256(lane);
+  size_t offset = 0;
+
+  for (; offset + 64 <= length; offset += 64) {
+    const __m256i first = _mm256_loadu_si256((const __m256i *)(in + offset));
+    const __m256i second = _mm256_loadu_si256((const __m256i *)(in + offset + 32));
+    _mm256_storeu_si256(
+      (__m256i *)(out + offset),
+      _mm256_shuffle_epi8(first, shuffle)
+      );
+    _mm256_storeu_si256(
+      (__m256i *)(out + offset + 32),
+      _mm256_shuffle_epi8(second, shuffle)
+      );
+  }
+
+  for (; offset + 32 <= length; offset += 32) {
+    const __m256i block = _mm256_loadu_si256((const __m256i *)(in + offset));
+    _mm256_storeu_si256((__m256i *)(out + offset), _mm256_shuffle_epi8(block, shuffle));
+  }
+
+  return offset;
+}
+
+#endif
+
+
+void
+sz_byteswap(void *out, const void *in, size_t count, size_t type_size)
+{
+  uint8_t *out_bytes = (uint8_t *)out;
+  const uint8_t *in_bytes = (const uint8_t *)in;
+
+  if (type_size < 2) {
+    if (out != in) {
+      memmove(out, in, count * type_size);
+    }
+    return;
+  }
+
+#if SZ_BYTESWAP_X86
+  {
+    const size_t length = count * type_size;
+    const uint8_t *mask =
+      sz_byteswap_masks[type_size == 2 ? 0 : (type_size == 4 ? 1 : 2)];
+    size_t swapped = 0;
+
+    // __builtin_cpu_supports only reads flags set up at startup, so it's cheap
+    // enough to check on every call.
+    if (sz_byteswap_avx2_allowed && __builtin_cpu_supports("avx2")) {
+      swapped = sz_byteswap_avx2(out_bytes, in_bytes, length, mask);
+    }
+
+    if (sz_byteswap_ssse3_allowed && __builtin_cpu_supports("ssse3")) {
+      swapped += sz_byteswap_ssse3(
+        out_bytes + swapped,
+        in_bytes + swapped,
+        length - swapped,
+        mask
+        );
+    }
+
+    // Vectors hold whole elements, so whatever's left is a whole number of
+    // them too.
+    out_bytes += swapped;
+    in_bytes += swapped;
+    count -= swapped / type_size;
+  }
+#endif
+
+  switch (type_size) {
+  case 2: sz_byteswap_16(out_bytes, in_bytes, count); break;
+  case 4: sz_byteswap_32(out_bytes, in_bytes, count); break;
+  case 8: sz_byteswap_64(out_bytes, in_bytes, count); break;
+  default: break;
+  }
+}
+
+
+void
+sz_byteswap_use_simd(bool avx2, bool ssse3)
+{
+  sz_byteswap_avx2_allowed = avx2;
+  sz_byteswap_ssse3_allowed = ssse3;
+}
@@ -0,0 +1,47 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+#ifndef __SZ_SNOWBALL__BYTESWAP_HH__
+#define __SZ_SNOWBALL__BYTESWAP_HH__
+
+
+#include <snowball.h>
+
+
+// Reverses the bytes of each of count elements of type_size bytes -- 1, 2, 4,
+// or 8 -- read from in and writes them to out. in and out may be the same, to
+// swap in place, but must not otherwise overlap. Uses AVX2 or SSSE3 shuffles
+// when the CPU has them, checked at runtime, and a portable loop otherwise.
+SZ_HIDDEN
+void
+sz_byteswap(void *out, const void *in, size_t count, size_t type_size);
+
+// Allows or forbids sz_byteswap()'s AVX2 and SSSE3 kernels, which are allowed
+// by default and used where the CPU has them. Output is the same either way,
+// so this is only for tests comparing the kernels with the portable loops. Not
+// thread-safe.
+SZ_HIDDEN
+void
+sz_byteswap_use_simd(bool avx2, bool ssse3);
+
+
+#endif /* end __SZ_SNOWBALL__BYTESWAP_HH__ include guard */
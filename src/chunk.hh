@@ -29,20 +29,115 @@ enum {
 };
 
 
+// Magic number of the previous format revision, SZ02. SZ02 snowballs use
+// 32-bit sizes and offsets throughout and are still accepted by readers.
+enum {
+  SZ_MAGIC_SZ02 = 0x32305A53
+};
+
+
+// Array lengths are stored as uint32_t in every format version.
+enum {
+  SZ_MAX_ARRAY_LENGTH = 0xFFFFFFFFU
+};
+
+
+// sz_root_t::flags bits.
+enum {
+  // Chunk headers use the compact encoding: a kind byte, the chunk's name as a
+  // varint index into the name table, then the payload size (excluding the
+  // header) as a varint. Compound and data chunks store their names as plain
+  // varints instead of name table indices. The name table immediately follows
+  // the mappings table and is a uint32_t count followed by that many names.
+  SZ_ROOT_COMPACT_HEADERS = 1 << 0,
+  // The data chunk and every compound chunk have a name index between their
+  // header and body: a uint32_t count followed by that many entries, each a
+  // uint32_t name and the uint64_t offset of a field with that name from the
+  // start of the body. Entries are sorted by name, then offset.
+  SZ_ROOT_NAME_INDEX = 1 << 1,
+  // Everything after the root's magic number and flags, which are always
+  // little endian, is big endian instead of little endian. Writers use their
+  // host's byte order and readers swap bytes only if theirs differs.
+  SZ_ROOT_BIG_ENDIAN = 1 << 2,
+  // Bits 8-15 hold log2 of the payload alignment. If nonzero, the payloads of
+  // array and bytes chunks are preceded by zero padding that aligns them
+  // relative to the root, and compound and data chunks are preceded by padding
+  // that aligns their bodies. Chunk sizes don't include the padding.
+  SZ_ROOT_ALIGNMENT_SHIFT = 8,
+  SZ_ROOT_ALIGNMENT_MASK = 0xFF << SZ_ROOT_ALIGNMENT_SHIFT
+};
+
+
+// Encoded size of a name index entry.
+enum {
+  SZ_NAME_INDEX_ENTRY_SIZE = sizeof(uint32_t) + sizeof(uint64_t)
+};
+
+
+// Returns the number of bytes of padding needed to align offset. alignment
+// must be a power of two.
+inline
+uint64_t
+sz_padding(uint64_t offset, uint64_t alignment)
+{
+  return (uint64_t(0) - offset) & (alignment - 1);
+}
+
+
+// Returns whether the host is big endian. Compilers fold this to a constant.
+inline
+bool
+sz_host_big_endian()
+{
+  const uint16_t probe = 1;
+  return *(const uint8_t *)&probe == 0;
+}
+
+
+// Encodes and decodes the little-endian root magic number and flags.
+inline
+void
+sz_encode_le32(uint8_t *out, uint32_t value)
+{
+  out[0] = uint8_t(value);
+  out[1] = uint8_t(value >> 8);
+  out[2] = uint8_t(value >> 16);
+  out[3] = uint8_t(value >> 24);
+}
+
+
+inline
+uint32_t
+sz_decode_le32(const uint8_t *in)
+{
+  return
+      uint32_t(in[0])
+    | (uint32_t(in[1]) << 8)
+    | (uint32_t(in[2]) << 16)
+    | (uint32_t(in[3]) << 24);
+}
+
+
+// The structs below are laid out to match the current format, so sizeof()
+// gives their encoded sizes.
 typedef struct SZ_HIDDEN s_sz_root
 {
   // magic number -- should be SZ_MAGIC
   uint32_t magic;
+  // format options -- see SZ_ROOT_COMPACT_HEADERS and so on
+  uint32_t flags;
   // size of the serializable data including this root
-  uint32_t size;
+  uint64_t size;
   // offsets are from the root
   uint32_t num_compounds;
+  // padding to keep the offsets below 8-byte aligned -- always 0
+  uint32_t reserved;
   // Always immediately follows the root, so = sizeof(root)
-  uint32_t mappings_offset;
+  uint64_t mappings_offset;
   // Follows mappings
-  uint32_t compounds_offset;
+  uint64_t compounds_offset;
   // Follows compounds
-  uint32_t data_offset;
+  uint64_t data_offset;
 
   // mappings
   // data
@@ -54,17 +149,10 @@ typedef struct SZ_HIDDEN s_sz_header
 {
   uint32_t kind;  // chunk type
   uint32_t name;  // chunk name
-  uint32_t size;  // length including this header
+  uint64_t size;  // length including this header
 } sz_header_t;
 
 
-typedef struct SZ_HIDDEN s_sz_compound_ref
-{
-  sz_header_t base;
-  uint32_t index;
-} sz_compound_ref_t;
-
-
 typedef struct SZ_HIDDEN s_sz_array
 {
   sz_header_t base;
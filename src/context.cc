@@ -31,6 +31,9 @@ s_sz_context::s_sz_context(sz_allocator_t *alloc)
 , ctx_alloc(alloc)
 , stream(NULL)
 , stream_pos(0)
+, flags(0)
+, alignment(1)
+, buffer_alloc(NULL)
 {
   // nop
 }
@@ -60,6 +63,17 @@ s_sz_context::file_error() const
 }
 
 
+sz_response_t
+s_sz_context::reset()
+{
+  error = sz_errstr_no_error;
+  stream = NULL;
+  stream_pos = 0;
+
+  return SZ_SUCCESS;
+}
+
+
 sz_response_t
 s_sz_context::set_stream(sz_stream_t *stream)
 {
@@ -78,6 +92,53 @@ s_sz_context::set_stream(sz_stream_t *stream)
 }
 
 
+sz_response_t
+s_sz_context::set_flags(uint32_t flags)
+{
+  if (opened()) {
+    error = sz_errstr_open_set_flags;
+    return SZ_ERROR_CONTEXT_OPEN;
+  }
+
+  this->flags = flags;
+
+  return SZ_SUCCESS;
+}
+
+
+sz_response_t
+s_sz_context::set_alignment(uint32_t alignment)
+{
+  if (opened()) {
+    error = sz_errstr_open_set_alignment;
+    return SZ_ERROR_CONTEXT_OPEN;
+  } else if (   alignment == 0
+             || alignment > SZ_MAX_ALIGNMENT
+             || (alignment & (alignment - 1)) != 0) {
+    error = sz_errstr_bad_alignment;
+    return SZ_ERROR_INVALID_OPERATION;
+  }
+
+  this->alignment = alignment;
+
+  return SZ_SUCCESS;
+}
+
+
+sz_response_t
+s_sz_context::set_buffer_allocator(sz_allocator_t *alloc)
+{
+  if (opened()) {
+    error = sz_errstr_open_set_buffer_allocator;
+    return SZ_ERROR_CONTEXT_OPEN;
+  }
+
+  buffer_alloc = alloc;
+
+  return SZ_SUCCESS;
+}
+
+
 sz_response_t
 sz_check_context(const sz_context_t *ctx, sz_mode_t mode)
 {
@@ -115,6 +176,27 @@ sz_set_stream(sz_context_t *ctx, sz_stream_t *stream)
 }
 
 
+sz_response_t
+sz_set_flags(sz_context_t *ctx, uint32_t flags)
+{
+  return ctx ? ctx->set_flags(flags) : SZ_ERROR_NULL_CONTEXT;
+}
+
+
+sz_response_t
+sz_set_alignment(sz_context_t *ctx, uint32_t alignment)
+{
+  return ctx ? ctx->set_alignment(alignment) : SZ_ERROR_NULL_CONTEXT;
+}
+
+
+sz_response_t
+sz_set_buffer_allocator(sz_context_t *ctx, sz_allocator_t *alloc)
+{
+  return ctx ? ctx->set_buffer_allocator(alloc) : SZ_ERROR_NULL_CONTEXT;
+}
+
+
 sz_context_t *
 sz_new_context(sz_mode_t mode, sz_allocator_t *allocator)
 {
@@ -167,6 +249,17 @@ sz_close(sz_context_t *ctx)
 }
 
 
+sz_response_t
+sz_reset_context(sz_context_t *ctx)
+{
+  if (ctx == NULL) {
+    return SZ_ERROR_NULL_CONTEXT;
+  }
+
+  return ctx->reset();
+}
+
+
 sz_response_t
 sz_open(sz_context_t *ctx)
 {
@@ -35,6 +35,13 @@ struct SZ_HIDDEN s_sz_context
   sz_stream_t *         stream;
   off_t                 stream_pos;
 
+  uint32_t              flags;
+  uint32_t              alignment;
+
+  // Allocator for buffers returned by reads when none is given. NULL for the
+  // default allocator.
+  sz_allocator_t *      buffer_alloc;
+
 
   s_sz_context(sz_allocator_t *alloc);
 
@@ -56,9 +63,24 @@ struct SZ_HIDDEN s_sz_context
   sz_response_t
   close() = 0;
 
+  // Closes the context, if open, without finishing de/serialization and unsets
+  // its stream, but keeps its memory for reuse. Subclasses call this last.
+  virtual
+  sz_response_t
+  reset();
+
   sz_response_t
   set_stream(sz_stream_t *stream);
 
+  sz_response_t
+  set_flags(uint32_t flags);
+
+  sz_response_t
+  set_alignment(uint32_t alignment);
+
+  sz_response_t
+  set_buffer_allocator(sz_allocator_t *alloc);
+
   virtual
   bool
   opened() const = 0;
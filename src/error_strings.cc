@@ -74,6 +74,18 @@ SZ_HIDDEN const char *const sz_errstr_already_open =
 SZ_HIDDEN const char *const sz_errstr_open_set_stream =
   "Cannot set stream for open serializer.";
 
+SZ_HIDDEN const char *const sz_errstr_open_set_flags =
+  "Cannot set flags for open serializer.";
+
+SZ_HIDDEN const char *const sz_errstr_open_set_alignment =
+  "Cannot set alignment for open serializer.";
+
+SZ_HIDDEN const char *const sz_errstr_open_set_buffer_allocator =
+  "Cannot set buffer allocator for open serializer.";
+
+SZ_HIDDEN const char *const sz_errstr_bad_alignment =
+  "Alignment must be a power of two no greater than SZ_MAX_ALIGNMENT.";
+
 SZ_HIDDEN const char *const sz_errstr_null_stream =
   "Stream is NULL.";
 
@@ -82,3 +94,42 @@ SZ_HIDDEN const char *const sz_errstr_empty_array =
 
 SZ_HIDDEN const char *const sz_errstr_nomem =
   "Allocation failed.";
+
+SZ_HIDDEN const char *const sz_errstr_no_view =
+  "Stream cannot provide a view of the requested data.";
+
+SZ_HIDDEN const char *const sz_errstr_view_endianness =
+  "Cannot view data whose endianness differs from the host's.";
+
+SZ_HIDDEN const char *const sz_errstr_view_misaligned =
+  "Array data is not aligned for its element type.";
+
+SZ_HIDDEN const char *const sz_errstr_cannot_seek =
+  "Unable to seek in stream.";
+
+SZ_HIDDEN const char *const sz_errstr_array_too_long =
+  "Array is too long to serialize.";
+
+SZ_HIDDEN const char *const sz_errstr_bad_header =
+  "Chunk header is malformed.";
+
+SZ_HIDDEN const char *const sz_errstr_malformed_root =
+  "Root is malformed.";
+
+SZ_HIDDEN const char *const sz_errstr_worker_context =
+  "Cannot close or reset the context of a compound written in parallel.";
+
+SZ_HIDDEN const char *const sz_errstr_array_open =
+  "Cannot read other chunks while an array is being read in windows.";
+
+SZ_HIDDEN const char *const sz_errstr_no_array =
+  "No array is being read in windows.";
+
+SZ_HIDDEN const char *const sz_errstr_bad_encoding =
+  "Array encoding does not apply to the array's element type.";
+
+SZ_HIDDEN const char *const sz_errstr_corrupt_array =
+  "Encoded array data is malformed.";
+
+SZ_HIDDEN const char *const sz_errstr_encoded_array =
+  "Operation is not supported on encoded arrays.";
@@ -45,9 +45,26 @@ SZ_HIDDEN extern const char *const sz_errstr_compound_zero;
 SZ_HIDDEN extern const char *const sz_errstr_already_closed;
 SZ_HIDDEN extern const char *const sz_errstr_already_open;
 SZ_HIDDEN extern const char *const sz_errstr_open_set_stream;
+SZ_HIDDEN extern const char *const sz_errstr_open_set_flags;
+SZ_HIDDEN extern const char *const sz_errstr_open_set_alignment;
+SZ_HIDDEN extern const char *const sz_errstr_open_set_buffer_allocator;
+SZ_HIDDEN extern const char *const sz_errstr_bad_alignment;
 SZ_HIDDEN extern const char *const sz_errstr_null_stream;
 SZ_HIDDEN extern const char *const sz_errstr_empty_array;
 SZ_HIDDEN extern const char *const sz_errstr_nomem;
+SZ_HIDDEN extern const char *const sz_errstr_no_view;
+SZ_HIDDEN extern const char *const sz_errstr_view_endianness;
+SZ_HIDDEN extern const char *const sz_errstr_view_misaligned;
+SZ_HIDDEN extern const char *const sz_errstr_cannot_seek;
+SZ_HIDDEN extern const char *const sz_errstr_array_too_long;
+SZ_HIDDEN extern const char *const sz_errstr_bad_header;
+SZ_HIDDEN extern const char *const sz_errstr_malformed_root;
+SZ_HIDDEN extern const char *const sz_errstr_worker_context;
+SZ_HIDDEN extern const char *const sz_errstr_array_open;
+SZ_HIDDEN extern const char *const sz_errstr_no_array;
+SZ_HIDDEN extern const char *const sz_errstr_bad_encoding;
+SZ_HIDDEN extern const char *const sz_errstr_corrupt_array;
+SZ_HIDDEN extern const char *const sz_errstr_encoded_array;
 
 
 #endif /* end __ERROR_STRINGS_HH__ include guard */
@@ -20,9 +20,21 @@
   IN THE SOFTWARE.
 */
 
-#include <snowball.h>
+#include "fstream.hh"
 
 #include <cstdio>
+#include <cstring>
+
+#include <cerrno>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+
+// Maximum number of buffers passed to a single writev call.
+#define SZ_IOV_BATCH (256)
 
 
 struct SZ_HIDDEN sz_fstream_t
@@ -34,6 +46,31 @@ struct SZ_HIDDEN sz_fstream_t
 };
 
 
+struct SZ_HIDDEN sz_fdstream_t
+{
+  sz_stream_t base;
+
+  sz_allocator_t *allocator;
+  sz_mode_t mode;
+  int fd;
+  off_t pos;
+  int eof;
+};
+
+
+// Also used for sz_stream_memopen, which differs only in how it's closed.
+struct SZ_HIDDEN sz_mmstream_t
+{
+  sz_stream_t base;
+
+  sz_allocator_t *allocator;
+  const uint8_t *data;  // NULL if the file is empty
+  size_t size;
+  size_t pos;
+  int eof;
+};
+
+
 static
 size_t
 sz_fstream_read(void *out, size_t length, sz_stream_t *stream);
@@ -49,6 +86,11 @@ off_t
 sz_fstream_seek(off_t off, int whence, sz_stream_t *stream);
 
 
+static
+size_t
+sz_fstream_writev(const sz_iovec_t *iov, size_t count, sz_stream_t *stream);
+
+
 static
 int
 sz_fstream_eof(sz_stream_t *stream);
@@ -59,12 +101,112 @@ void
 sz_fstream_close(sz_stream_t *stream);
 
 
+static
+size_t
+sz_fdstream_read(void *out, size_t length, sz_stream_t *stream);
+
+
+static
+size_t
+sz_fdstream_write(const void *in, size_t length, sz_stream_t *stream);
+
+
+static
+size_t
+sz_fdstream_writev(const sz_iovec_t *iov, size_t count, sz_stream_t *stream);
+
+
+static
+off_t
+sz_fdstream_seek(off_t off, int whence, sz_stream_t *stream);
+
+
+static
+int
+sz_fdstream_eof(sz_stream_t *stream);
+
+
+static
+void
+sz_fdstream_close(sz_stream_t *stream);
+
+
+static
+size_t
+sz_mmstream_read(void *out, size_t length, sz_stream_t *stream);
+
+
+static
+size_t
+sz_mmstream_write(const void *in, size_t length, sz_stream_t *stream);
+
+
+static
+off_t
+sz_mmstream_seek(off_t off, int whence, sz_stream_t *stream);
+
+
+static
+int
+sz_mmstream_eof(sz_stream_t *stream);
+
+
+static
+void
+sz_mmstream_close(sz_stream_t *stream);
+
+
+static
+const void *
+sz_mmstream_view(size_t length, sz_stream_t *stream);
+
+
+static
+void
+sz_memstream_close(sz_stream_t *stream);
+
+
 static sz_stream_t sz_fstream_base = {
   sz_fstream_read,
   sz_fstream_write,
   sz_fstream_seek,
   sz_fstream_eof,
-  sz_fstream_close
+  sz_fstream_close,
+  NULL,
+  sz_fstream_writev
+};
+
+
+static sz_stream_t sz_fdstream_base = {
+  sz_fdstream_read,
+  sz_fdstream_write,
+  sz_fdstream_seek,
+  sz_fdstream_eof,
+  sz_fdstream_close,
+  NULL,
+  sz_fdstream_writev
+};
+
+
+static sz_stream_t sz_mmstream_base = {
+  sz_mmstream_read,
+  sz_mmstream_write,
+  sz_mmstream_seek,
+  sz_mmstream_eof,
+  sz_mmstream_close,
+  sz_mmstream_view,
+  NULL
+};
+
+
+static sz_stream_t sz_memstream_base = {
+  sz_mmstream_read,
+  sz_mmstream_write,
+  sz_mmstream_seek,
+  sz_mmstream_eof,
+  sz_memstream_close,
+  sz_mmstream_view,
+  NULL
 };
 
 
@@ -94,15 +236,129 @@ sz_stream_fopen(const char *filename, sz_mode_t mode, sz_allocator_t *alloc)
 }
 
 
+sz_stream_t *
+sz_stream_fdopen(int fd, sz_mode_t mode, sz_allocator_t *alloc)
+{
+  sz_fdstream_t *stream = NULL;
+
+  if (fd < 0 || fcntl(fd, F_GETFD) == -1) {
+    return NULL;
+  }
+
+  off_t pos = lseek(fd, 0, SEEK_CUR);
+  if (pos < 0) {
+    pos = 0;
+  }
+
+  stream = (sz_fdstream_t *)sz_malloc(sizeof(sz_fdstream_t), alloc);
+  if (stream) {
+    stream->base = sz_fdstream_base;
+    stream->allocator = alloc;
+    stream->mode = mode;
+    stream->fd = fd;
+    stream->pos = pos;
+    stream->eof = 0;
+  }
+
+  return (sz_stream_t *)stream;
+}
+
+
+sz_stream_t *
+sz_stream_mmap(const char *filename, sz_allocator_t *alloc)
+{
+  sz_mmstream_t *stream = NULL;
+  void *data = NULL;
+  struct stat info;
+  int fd = open(filename, O_RDONLY);
+
+  if (fd == -1) {
+    return NULL;
+  }
+
+  if (fstat(fd, &info) == -1) {
+    close(fd);
+    return NULL;
+  }
+
+  // mmap refuses zero-length mappings, so empty files just get no data.
+  if (info.st_size > 0) {
+    data = mmap(NULL, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  }
+
+  // The mapping keeps its own reference to the file.
+  close(fd);
+
+  if (data == MAP_FAILED) {
+    return NULL;
+  }
+
+  stream = (sz_mmstream_t *)sz_malloc(sizeof(sz_mmstream_t), alloc);
+  if (stream == NULL) {
+    if (data) {
+      munmap(data, size_t(info.st_size));
+    }
+    return NULL;
+  }
+
+  stream->base = sz_mmstream_base;
+  stream->allocator = alloc;
+  stream->data = (const uint8_t *)data;
+  stream->size = size_t(info.st_size);
+  stream->pos = 0;
+  stream->eof = 0;
+
+  return (sz_stream_t *)stream;
+}
+
+
+sz_stream_t *
+sz_stream_memopen(const void *data, size_t length, sz_allocator_t *alloc)
+{
+  sz_mmstream_t *stream = NULL;
+
+  if (data == NULL && length) {
+    return NULL;
+  }
+
+  stream = (sz_mmstream_t *)sz_malloc(sizeof(sz_mmstream_t), alloc);
+  if (stream == NULL) {
+    return NULL;
+  }
+
+  stream->base = sz_memstream_base;
+  stream->allocator = alloc;
+  stream->data = (const uint8_t *)data;
+  stream->size = length;
+  stream->pos = 0;
+  stream->eof = 0;
+
+  return (sz_stream_t *)stream;
+}
+
+
 SZ_DEF_END
 
 
+const uint8_t *
+sz_stream_memory(sz_stream_t *stream, size_t *length)
+{
+  if (stream == NULL || stream->view != sz_mmstream_view) {
+    return NULL;
+  }
+
+  sz_mmstream_t *mmstream = (sz_mmstream_t *)stream;
+  *length = mmstream->size - mmstream->pos;
+  return mmstream->data + mmstream->pos;
+}
+
+
 static
 size_t
 sz_fstream_read(void *out, size_t length, sz_stream_t *stream)
 {
   sz_fstream_t *fstream = (sz_fstream_t *)stream;
-  return fread(out, length, 1, fstream->file) * length;
+  return fread(out, 1, length, fstream->file);
 }
 
 
@@ -111,7 +367,84 @@ size_t
 sz_fstream_write(const void *in, size_t length, sz_stream_t *stream)
 {
   sz_fstream_t *fstream = (sz_fstream_t *)stream;
-  return fwrite(in, length, 1, fstream->file) * length;
+  return fwrite(in, 1, length, fstream->file);
+}
+
+
+// Writes all count buffers in iov to fd, retrying on partial writes. If
+// offset is negative, writes at the descriptor's offset using writev,
+// otherwise writes at offset using pwritev. Returns the number of bytes
+// written.
+static
+size_t
+sz_fd_writev(int fd, const sz_iovec_t *iov, size_t count, off_t offset)
+{
+  struct iovec batch[SZ_IOV_BATCH];
+  size_t total = 0;
+  size_t index = 0;
+  size_t skip = 0;  // bytes of iov[index] already written
+
+  while (index < count) {
+    int batch_count = 0;
+    for (size_t next = index; next < count && batch_count < SZ_IOV_BATCH; ++next) {
+      const size_t offset = (next == index) ? skip : 0;
+      batch[batch_count].iov_base = (uint8_t *)iov[next].base + offset;
+      batch[batch_count].iov_len = iov[next].length - offset;
+      ++batch_count;
+    }
+
+    const ssize_t written =
+      offset < 0
+      ? writev(fd, batch, batch_count)
+      : pwritev(fd, batch, batch_count, offset + off_t(total));
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+
+    total += size_t(written);
+
+    // Skip past whatever was written, which may end partway into a buffer.
+    size_t remaining = size_t(written);
+    while (index < count && remaining >= iov[index].length - skip) {
+      remaining -= iov[index].length - skip;
+      skip = 0;
+      ++index;
+    }
+    skip += remaining;
+
+    if (written == 0 && index < count && iov[index].length) {
+      break;
+    }
+  }
+
+  return total;
+}
+
+
+static
+size_t
+sz_fstream_writev(const sz_iovec_t *iov, size_t count, sz_stream_t *stream)
+{
+  sz_fstream_t *fstream = (sz_fstream_t *)stream;
+
+  // Anything buffered by stdio has to reach the file before writing to the
+  // descriptor directly. Afterward, seek the FILE to where the writes ended so
+  // its idea of the position isn't stale.
+  if (fflush(fstream->file)) {
+    return 0;
+  }
+
+  const off_t start = ftello(fstream->file);
+  if (start < 0) {
+    return 0;
+  }
+
+  const size_t written = sz_fd_writev(fileno(fstream->file), iov, count, -1);
+  fseeko(fstream->file, start + off_t(written), SEEK_SET);
+  return written;
 }
 
 
@@ -120,13 +453,13 @@ off_t
 sz_fstream_seek(off_t off, int whence, sz_stream_t *stream)
 {
   sz_fstream_t *fstream = (sz_fstream_t *)stream;
-  if (off != 0 && whence != SEEK_CUR) {
-    int result = fseek(fstream->file, long(off), whence);
+  if (off != 0 || whence != SEEK_CUR) {
+    int result = fseeko(fstream->file, off, whence);
     if (result) {
       return off_t(result);
     }
   }
-  return ftell(fstream->file);
+  return ftello(fstream->file);
 }
 
 
@@ -148,3 +481,235 @@ sz_fstream_close(sz_stream_t *stream)
   sz_free(fstream, fstream->allocator);
 }
 
+
+static
+size_t
+sz_fdstream_read(void *out, size_t length, sz_stream_t *stream)
+{
+  sz_fdstream_t *fdstream = (sz_fdstream_t *)stream;
+  size_t total = 0;
+
+  if (fdstream->mode != SZ_READER) {
+    return 0;
+  }
+
+  while (total < length) {
+    const ssize_t result = pread(
+      fdstream->fd,
+      (uint8_t *)out + total,
+      length - total,
+      fdstream->pos + off_t(total)
+      );
+
+    if (result < 0 && errno == EINTR) {
+      continue;
+    } else if (result <= 0) {
+      fdstream->eof = (result == 0);
+      break;
+    }
+
+    total += size_t(result);
+  }
+
+  fdstream->pos += off_t(total);
+  return total;
+}
+
+
+static
+size_t
+sz_fdstream_write(const void *in, size_t length, sz_stream_t *stream)
+{
+  sz_fdstream_t *fdstream = (sz_fdstream_t *)stream;
+  size_t total = 0;
+
+  if (fdstream->mode != SZ_WRITER) {
+    return 0;
+  }
+
+  while (total < length) {
+    const ssize_t result = pwrite(
+      fdstream->fd,
+      (const uint8_t *)in + total,
+      length - total,
+      fdstream->pos + off_t(total)
+      );
+
+    if (result < 0 && errno == EINTR) {
+      continue;
+    } else if (result <= 0) {
+      break;
+    }
+
+    total += size_t(result);
+  }
+
+  fdstream->pos += off_t(total);
+  return total;
+}
+
+
+static
+size_t
+sz_fdstream_writev(const sz_iovec_t *iov, size_t count, sz_stream_t *stream)
+{
+  sz_fdstream_t *fdstream = (sz_fdstream_t *)stream;
+
+  if (fdstream->mode != SZ_WRITER) {
+    return 0;
+  }
+
+  const size_t written = sz_fd_writev(fdstream->fd, iov, count, fdstream->pos);
+  fdstream->pos += off_t(written);
+  return written;
+}
+
+
+static
+off_t
+sz_fdstream_seek(off_t off, int whence, sz_stream_t *stream)
+{
+  sz_fdstream_t *fdstream = (sz_fdstream_t *)stream;
+  off_t base = 0;
+
+  switch (whence) {
+  case SEEK_CUR: base = fdstream->pos; break;
+  case SEEK_END: {
+    struct stat info;
+    if (fstat(fdstream->fd, &info) == -1) {
+      return -1;
+    }
+    base = info.st_size;
+  } break;
+  case SEEK_SET:
+  default: break;
+  }
+
+  if (base + off < 0) {
+    return -1;
+  }
+
+  fdstream->pos = base + off;
+  fdstream->eof = 0;
+  return fdstream->pos;
+}
+
+
+static
+int
+sz_fdstream_eof(sz_stream_t *stream)
+{
+  return ((sz_fdstream_t *)stream)->eof;
+}
+
+
+static
+void
+sz_fdstream_close(sz_stream_t *stream)
+{
+  // The descriptor belongs to the caller, so only the stream is released.
+  sz_fdstream_t *fdstream = (sz_fdstream_t *)stream;
+  sz_free(fdstream, fdstream->allocator);
+}
+
+
+static
+size_t
+sz_mmstream_read(void *out, size_t length, sz_stream_t *stream)
+{
+  sz_mmstream_t *mmstream = (sz_mmstream_t *)stream;
+  const size_t remaining = mmstream->size - mmstream->pos;
+
+  if (length > remaining) {
+    length = remaining;
+    mmstream->eof = 1;
+  }
+
+  if (length) {
+    memcpy(out, mmstream->data + mmstream->pos, length);
+    mmstream->pos += length;
+  }
+
+  return length;
+}
+
+
+static
+size_t
+sz_mmstream_write(const void *in, size_t length, sz_stream_t *stream)
+{
+  (void)in;
+  (void)length;
+  (void)stream;
+  return 0;
+}
+
+
+static
+off_t
+sz_mmstream_seek(off_t off, int whence, sz_stream_t *stream)
+{
+  sz_mmstream_t *mmstream = (sz_mmstream_t *)stream;
+  off_t base = 0;
+
+  switch (whence) {
+  case SEEK_CUR: base = off_t(mmstream->pos); break;
+  case SEEK_END: base = off_t(mmstream->size); break;
+  case SEEK_SET:
+  default: break;
+  }
+
+  if (off < -base || off > off_t(mmstream->size) - base) {
+    return -1;
+  }
+
+  mmstream->pos = size_t(base + off);
+  mmstream->eof = 0;
+  return off_t(mmstream->pos);
+}
+
+
+static
+int
+sz_mmstream_eof(sz_stream_t *stream)
+{
+  return ((sz_mmstream_t *)stream)->eof;
+}
+
+
+static
+void
+sz_mmstream_close(sz_stream_t *stream)
+{
+  sz_mmstream_t *mmstream = (sz_mmstream_t *)stream;
+  if (mmstream->data) {
+    munmap((void *)mmstream->data, mmstream->size);
+  }
+  sz_free(mmstream, mmstream->allocator);
+}
+
+
+static
+const void *
+sz_mmstream_view(size_t length, sz_stream_t *stream)
+{
+  sz_mmstream_t *mmstream = (sz_mmstream_t *)stream;
+  const uint8_t *view = mmstream->data + mmstream->pos;
+
+  if (length > mmstream->size - mmstream->pos) {
+    return NULL;
+  }
+
+  mmstream->pos += length;
+  return view;
+}
+
+
+static
+void
+sz_memstream_close(sz_stream_t *stream)
+{
+  // The memory belongs to the caller, so only the stream is released.
+  sz_mmstream_t *mmstream = (sz_mmstream_t *)stream;
+  sz_free(mmstream, mmstream->allocator);
+}
@@ -0,0 +1,39 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+#ifndef __SZ_SNOWBALL__FSTREAM_HH__
+#define __SZ_SNOWBALL__FSTREAM_HH__
+
+
+#include <snowball.h>
+
+
+// If stream is a memory-backed stream (from sz_stream_mmap or
+// sz_stream_memopen), returns a pointer to the stream's memory at its current
+// position and sets *length to the number of bytes from there to the end of
+// the stream. Otherwise, returns NULL and leaves *length alone.
+SZ_HIDDEN
+const uint8_t *
+sz_stream_memory(sz_stream_t *stream, size_t *length);
+
+
+#endif /* end __SZ_SNOWBALL__FSTREAM_HH__ include guard */
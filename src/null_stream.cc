@@ -78,7 +78,9 @@ static sz_stream_t sz_null_stream_ops = {
   sz_nullstream_write,
   sz_nullstream_seek,
   sz_nullstream_eof,
-  sz_nullstream_close
+  sz_nullstream_close,
+  NULL,
+  NULL
 };
 
 
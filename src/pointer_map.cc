@@ -0,0 +1,174 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+#include "pointer_map.hh"
+
+#include <cstring>
+
+
+// Smallest table allocated, in entries.
+#define SZ_POINTER_MAP_MIN_CAPACITY (64)
+
+
+// Tables grow before they're more than 3/4 full.
+static
+bool
+sz_pointer_map_overloaded(size_t count, size_t capacity)
+{
+  return count * 4 > capacity * 3;
+}
+
+
+// Mixes a pointer's bits so that aligned, closely spaced pointers spread out
+// across the table (the 64-bit finalizer from MurmurHash3).
+static
+size_t
+sz_pointer_hash(const void *key)
+{
+  uint64_t hash = uint64_t(uintptr_t(key));
+  hash ^= hash >> 33;
+  hash *= 0xFF51AFD7ED558CCDULL;
+  hash ^= hash >> 33;
+  hash *= 0xC4CEB9FE1A85EC53ULL;
+  hash ^= hash >> 33;
+  return size_t(hash);
+}
+
+
+sz_pointer_map_t::sz_pointer_map_t(sz_allocator_t *alloc)
+: alloc(alloc)
+, entries(NULL)
+, capacity(0)
+, count(0)
+{
+  /* nop */
+}
+
+
+sz_pointer_map_t::~sz_pointer_map_t()
+{
+  if (entries) {
+    sz_free(entries, alloc);
+  }
+}
+
+
+sz_pointer_map_t::entry_t *
+sz_pointer_map_t::probe(const void *key) const
+{
+  const size_t mask = capacity - 1;
+  size_t index = sz_pointer_hash(key) & mask;
+
+  // The table is never full, so this always ends at an empty entry if key
+  // isn't found first.
+  while (entries[index].key != NULL && entries[index].key != key) {
+    index = (index + 1) & mask;
+  }
+
+  return &entries[index];
+}
+
+
+uint32_t *
+sz_pointer_map_t::find(const void *key) const
+{
+  if (count == 0) {
+    return NULL;
+  }
+
+  entry_t *const entry = probe(key);
+  return entry->key ? &entry->value : NULL;
+}
+
+
+bool
+sz_pointer_map_t::insert(const void *key, uint32_t value)
+{
+  if (   capacity == 0
+      || sz_pointer_map_overloaded(count + 1, capacity)) {
+    if (!resize(capacity ? capacity * 2 : SZ_POINTER_MAP_MIN_CAPACITY)) {
+      return false;
+    }
+  }
+
+  entry_t *const entry = probe(key);
+  if (entry->key == NULL) {
+    entry->key = key;
+    entry->value = value;
+    ++count;
+  }
+
+  return true;
+}
+
+
+bool
+sz_pointer_map_t::reserve(size_t min_count)
+{
+  size_t new_capacity = capacity ? capacity : SZ_POINTER_MAP_MIN_CAPACITY;
+
+  while (sz_pointer_map_overloaded(min_count, new_capacity)) {
+    new_capacity *= 2;
+  }
+
+  return new_capacity == capacity || resize(new_capacity);
+}
+
+
+void
+sz_pointer_map_t::clear()
+{
+  if (entries) {
+    memset(entries, 0, sizeof(*entries) * capacity);
+  }
+  count = 0;
+}
+
+
+bool
+sz_pointer_map_t::resize(size_t new_capacity)
+{
+  entry_t *const old_entries = entries;
+  const size_t old_capacity = capacity;
+  entry_t *const new_entries =
+    (entry_t *)sz_malloc(sizeof(*new_entries) * new_capacity, alloc);
+
+  if (new_entries == NULL) {
+    return false;
+  }
+
+  memset(new_entries, 0, sizeof(*new_entries) * new_capacity);
+  entries = new_entries;
+  capacity = new_capacity;
+
+  for (size_t index = 0; index < old_capacity; ++index) {
+    if (old_entries[index].key) {
+      *probe(old_entries[index].key) = old_entries[index];
+    }
+  }
+
+  if (old_entries) {
+    sz_free(old_entries, alloc);
+  }
+
+  return true;
+}
@@ -0,0 +1,89 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+#ifndef __POINTER_MAP_HH__
+#define __POINTER_MAP_HH__
+
+
+#include <snowball.h>
+
+
+// Open-addressing hash table mapping non-NULL pointers to uint32_t values.
+// Entries are stored in one flat, power-of-two sized array allocated with the
+// map's allocator and probed linearly, so inserting doesn't allocate unless
+// the table has to grow. Entries can't be removed, only cleared all at once.
+struct SZ_HIDDEN sz_pointer_map_t
+{
+  struct entry_t
+  {
+    const void *key;  // NULL if the entry is empty
+    uint32_t value;
+  };
+
+  sz_pointer_map_t(sz_allocator_t *alloc);
+  ~sz_pointer_map_t();
+
+  // Returns a pointer to the value for key, or NULL if key isn't in the map.
+  // The pointer is valid until the map is next inserted into.
+  uint32_t *
+  find(const void *key) const;
+
+  // Inserts key with the given value if it's not already in the map. Returns
+  // false if the table couldn't grow to fit it.
+  bool
+  insert(const void *key, uint32_t value);
+
+  // Grows the table so it can hold count entries without growing again.
+  // Returns false if the table couldn't be allocated.
+  bool
+  reserve(size_t count);
+
+  // Removes all entries, keeping the table's memory for reuse.
+  void
+  clear();
+
+  size_t
+  size() const
+  {
+    return count;
+  }
+
+private:
+  sz_allocator_t *alloc;
+  entry_t *entries;
+  size_t capacity;  // always 0 or a power of two
+  size_t count;
+
+  // Returns the entry for key, or the empty entry where it would go.
+  entry_t *
+  probe(const void *key) const;
+
+  bool
+  resize(size_t new_capacity);
+
+  // Not copyable.
+  sz_pointer_map_t(const sz_pointer_map_t &);
+  sz_pointer_map_t &operator = (const sz_pointer_map_t &);
+};
+
+
+#endif /* end __POINTER_MAP_HH__ include guard */
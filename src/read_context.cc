@@ -23,68 +23,39 @@
 #include "read_context.hh"
 #include "error_strings.hh"
 #include "utilities.hh"
+#include "varint.hh"
+#include "byteswap.hh"
+#include "fstream.hh"
+#include "array_codec.hh"
 
+#include <limits>
 
-// Reads a primitive of type T to out (may be nullptr, though in that case
-// you'll want to provide T yourself). Returns false on success, true if an
-// error occurred.
-template <typename T>
-SZ_HIDDEN
-bool
-sz_read_prim(sz_stream_t *stream, T *out)
-{
-  T result = T();
-
-  if (sz_stream_read(&result, sizeof(result), stream) == sizeof(result)) {
-
-#if SZ_ENDIANNESS != SZ_BASE_ENDIANNESS
-    T swapout = T(result);
-    uint8_t *out = (uint8_t *)&result;
-    const uint8_t *in = (const uint8_t *)&swapout;
-    for (size_t i = 0; i < sizeof(T); ++i) {
-      out[(sizeof(T) - 1) - i] = in[i];
-    }
-#endif
-
-    if (out) {
-      *out = result;
-    }
-
-    return false;
-  }
-
-  return true;
-}
 
+// Largest possible compact chunk header: a kind byte and two varints.
+#define SZ_COMPACT_HEADER_MAX_SIZE (1 + 2 * SZ_VARINT_MAX_LENGTH)
 
-#if SZ_ENDIANNESS != SZ_BASE_ENDIANNESS
 
-template <>
+// Reads a primitive of type T from the context's stream to out (may be
+// nullptr, though in that case you'll want to provide T yourself), swapping its
+// bytes if the snowball's byte order isn't the host's. Returns false on
+// success, true if an error occurred.
+template <typename T>
 SZ_HIDDEN
 bool
-sz_read_prim(sz_stream_t *stream, int8_t *out)
+sz_read_prim(sz_read_context_t *ctx, T *out)
 {
-  int8_t result = 0;
+  T result = T();
 
-  if (sz_stream_read(&result, sizeof(result), stream) == sizeof(result)) {
-    if (out) {
-      *out = result;
+  if (ctx->buffered_read(&result, sizeof(result)) == sizeof(result)) {
+    if (sizeof(T) > 1 && ctx->swapping()) {
+      T swapout = T(result);
+      uint8_t *out = (uint8_t *)&result;
+      const uint8_t *in = (const uint8_t *)&swapout;
+      for (size_t i = 0; i < sizeof(T); ++i) {
+        out[(sizeof(T) - 1) - i] = in[i];
+      }
     }
 
-    return false;
-  }
-
-  return true;
-}
-
-template <>
-SZ_HIDDEN
-bool
-sz_read_prim(sz_stream_t *stream, uint8_t *out)
-{
-  uint8_t result = 0;
-
-  if (sz_stream_read(&result, sizeof(result), stream) == sizeof(result)) {
     if (out) {
       *out = result;
     }
@@ -96,68 +67,76 @@ sz_read_prim(sz_stream_t *stream, uint8_t *out)
 }
 
 
-template <>
-SZ_HIDDEN
-bool
-sz_read_prim(sz_stream_t *stream, uint32_t *out)
-{
-  uint32_t result = 0;
-
-  if (sz_stream_read(&result, sizeof(result), stream) == sizeof(result)) {
-    if (out) {
-      *out = sz_htonl(result);
-    }
-
-    return false;
-  }
-
-  return true;
-}
+const sz_read_context_t::unpacked_compound_t
+sz_read_context_t::default_unpacked_compound = {
+  0,     // position
+  NULL,  // value
+  false  // unpacked
+};
 
 
-template <>
-SZ_HIDDEN
-bool
-sz_read_prim(sz_stream_t *stream, int32_t *out)
-{
-  uint32_t result = 0;
-  bool r = sz_read_prim(stream, &result);
-  if (r && out) {
-    *out = *(int32_t *)&result;
-  }
-  return r;
-}
+const sz_read_context_t::window_t
+sz_read_context_t::no_window = {
+  false,  // active
+  0,      // type_size
+  0,      // remaining
+  0,      // pos
+  0       // end
+};
 
 
-template <>
-SZ_HIDDEN
-bool
-sz_read_prim(sz_stream_t *stream, float *out)
+// Returns the size of an array element of the given type, or 0 if arrays
+// can't hold the type. Bytes chunks count as arrays of 1-byte elements.
+static
+size_t
+sz_element_size(sz_chunk_id_t type)
 {
-  uint32_t result = 0;
-  bool r = sz_read_prim(stream, &result);
-  if (r && out) {
-    *out = *(float *)&result;
+  switch (type) {
+  case SZ_BYTES_CHUNK:
+  case SZ_SINT8_CHUNK:
+    return sizeof(uint8_t);
+
+  case SZ_SINT16_CHUNK:
+    return sizeof(uint16_t);
+
+  case SZ_FLOAT_CHUNK:
+  case SZ_UINT32_CHUNK:
+  case SZ_SINT32_CHUNK:
+  case SZ_COMPOUND_REF_CHUNK:
+    return sizeof(uint32_t);
+
+  case SZ_DOUBLE_CHUNK:
+  case SZ_SINT64_CHUNK:
+  case SZ_UINT64_CHUNK:
+    return sizeof(uint64_t);
+
+  default:
+    return 0;
   }
-  return r;
 }
 
-#endif
-
-
-const sz_read_context_t::unpacked_compound_t
-sz_read_context_t::default_unpacked_compound = {
-  0,     // position
-  NULL,  // value
-  false  // unpacked
-};
-
 
 sz_read_context_t::sz_read_context_t(sz_allocator_t *alloc)
 : s_sz_context(alloc)
 , compounds(sz_cxx_allocator_t<unpacked_compound_t>(alloc))
 , offsets(sz_cxx_allocator_t<off_t>(alloc))
+, window(no_window)
+, names(sz_cxx_allocator_t<uint32_t>(alloc))
+, scopes(sz_cxx_allocator_t<scope_t>(alloc))
+, encoded(sz_cxx_allocator_t<uint8_t>(alloc))
 , is_open(false)
+, buffer(NULL)
+, data(NULL)
+, buffer_capacity(0)
+, buffer_length(0)
+, buffer_pos(0)
+, buffer_origin(0)
+, preloaded(false)
+, format_version(SZ_MAGIC_VER_INT(SZ_MAGIC))
+, root_flags(0)
+, payload_alignment(1)
+, swap_bytes(false)
+, chunk_end(0)
 {
   /* nop */
 }
@@ -165,7 +144,9 @@ sz_read_context_t::sz_read_context_t(sz_allocator_t *alloc)
 
 sz_read_context_t::~sz_read_context_t()
 {
-  /* nop */
+  if (buffer) {
+    sz_free(buffer, ctx_alloc);
+  }
 }
 
 
@@ -180,30 +161,103 @@ sz_read_context_t::mode() const
 sz_response_t
 sz_read_context_t::read_root(sz_root_t *root)
 {
-  sz_root_t res;
-  if (   sz_read_prim(stream, &res.magic)
-      || sz_read_prim(stream, &res.size)
-      || sz_read_prim(stream, &res.num_compounds)
-      || sz_read_prim(stream, &res.mappings_offset)
-      || sz_read_prim(stream, &res.compounds_offset)
-      || sz_read_prim(stream, &res.data_offset)) {
+  sz_root_t res = { 0, 0, 0, 0, 0, 0, 0, 0 };
+  uint8_t head[2 * sizeof(uint32_t)];
+
+  // The magic number is always little endian. So are SZ03+ root flags, which
+  // give the byte order of the rest of the snowball. SZ02 snowballs are always
+  // little endian.
+  if (buffered_read(head, sizeof(uint32_t)) != sizeof(uint32_t)) {
     return file_error();
   }
 
+  res.magic = sz_decode_le32(head);
+
   if (res.magic != SZ_MAGIC) {
-    // Check if the version is supported. Currently, this just means the version
-    // number is the same or less and the first bytes of the stream are 'SZ'
+    // Check if the version is supported. Currently, this means the version
+    // is SZ02 or newer and no newer than SZ_MAGIC, and the first bytes of the
+    // stream are 'SZ'
     if ((res.magic & 0xFFFF) != (SZ_MAGIC & 0xFFFF)) {
       error = sz_errstr_invalid_magic_head;
       return SZ_ERROR_MALFORMED_MAGIC_HEAD;
     }
 
-    if (SZ_MAGIC_VER_INT(res.magic) > SZ_MAGIC_VER_INT(SZ_MAGIC)) {
+    if (   SZ_MAGIC_VER_INT(res.magic) > SZ_MAGIC_VER_INT(SZ_MAGIC)
+        || SZ_MAGIC_VER_INT(res.magic) < SZ_MAGIC_VER_INT(SZ_MAGIC_SZ02)) {
       error = sz_errstr_invalid_magic_version;
       return SZ_ERROR_MALFORMED_MAGIC_VERSION;
     }
   }
 
+  format_version = SZ_MAGIC_VER_INT(res.magic);
+  root_flags = 0;
+  payload_alignment = 1;
+  swap_bytes = sz_host_big_endian();
+
+  if (res.magic == SZ_MAGIC_SZ02) {
+    uint32_t size = 0;
+    uint32_t mappings_offset = 0;
+    uint32_t compounds_offset = 0;
+    uint32_t data_offset = 0;
+
+    if (   sz_read_prim(this, &size)
+        || sz_read_prim(this, &res.num_compounds)
+        || sz_read_prim(this, &mappings_offset)
+        || sz_read_prim(this, &compounds_offset)
+        || sz_read_prim(this, &data_offset)) {
+      return file_error();
+    }
+
+    res.size = size;
+    res.mappings_offset = mappings_offset;
+    res.compounds_offset = compounds_offset;
+    res.data_offset = data_offset;
+  } else {
+    if (buffered_read(head + sizeof(uint32_t), sizeof(uint32_t)) != sizeof(uint32_t)) {
+      return file_error();
+    }
+
+    res.flags = sz_decode_le32(head + sizeof(uint32_t));
+    swap_bytes =
+      ((res.flags & SZ_ROOT_BIG_ENDIAN) != 0) != sz_host_big_endian();
+
+    if (   sz_read_prim(this, &res.size)
+        || sz_read_prim(this, &res.num_compounds)
+        || sz_read_prim(this, &res.reserved)
+        || sz_read_prim(this, &res.mappings_offset)
+        || sz_read_prim(this, &res.compounds_offset)
+        || sz_read_prim(this, &res.data_offset)) {
+      return file_error();
+    }
+  }
+
+  // Offsets are from the root, so as long as they're within the snowball and
+  // the snowball's end fits in an off_t, adding them to stream_pos is safe.
+  const uint64_t max_size =
+    uint64_t(std::numeric_limits<off_t>::max()) - uint64_t(stream_pos);
+
+  if (   res.size > max_size
+      || res.mappings_offset > res.size
+      || res.compounds_offset > res.size
+      || res.data_offset > res.size) {
+    error = sz_errstr_malformed_root;
+    return SZ_INVALID_ROOT;
+  }
+
+  // Writers never align to more than SZ_MAX_ALIGNMENT, and the exponent is
+  // checked before it's used so it can't shift past 63 either.
+  const uint32_t alignment_log2 =
+    (res.flags & SZ_ROOT_ALIGNMENT_MASK) >> SZ_ROOT_ALIGNMENT_SHIFT;
+
+  if (   alignment_log2 >= 64
+      || (uint64_t(1) << alignment_log2) > SZ_MAX_ALIGNMENT) {
+    error = sz_errstr_malformed_root;
+    return SZ_INVALID_ROOT;
+  }
+
+  root_flags = res.flags;
+  payload_alignment = uint64_t(1) << alignment_log2;
+
   if (root) {
     *root = res;
   }
@@ -223,18 +277,39 @@ sz_read_context_t::read_header(
 {
   sz_header_t res;
 
-  if (   sz_read_prim(stream, &res.kind)
-      || sz_read_prim(stream, &res.name)
-      || sz_read_prim(stream, &res.size)) {
-    return file_error();
+  if (window.active) {
+    error = sz_errstr_array_open;
+    return SZ_ERROR_INVALID_OPERATION;
+  }
+
+  // Fields can be looked up by name if there's a name index. Compound and data
+  // chunks aren't fields, so they're never looked up.
+  const bool indexed =
+       (root_flags & SZ_ROOT_NAME_INDEX)
+    && type != SZ_COMPOUND_CHUNK
+    && type != SZ_DATA_CHUNK
+    && !scopes.empty();
+
+  if (indexed && buffered_tell() >= scopes.back().body_end) {
+    SZ_RETURN_IF_ERROR( seek_field(name, buffered_tell()) );
+  }
+
+  const off_t chunk_start = buffered_tell();
+
+  SZ_RETURN_IF_ERROR( read_any_header(&res) );
+
+  if (indexed && res.name != name) {
+    SZ_RETURN_IF_ERROR( seek_field(name, chunk_start) );
+    SZ_RETURN_IF_ERROR( read_any_header(&res) );
   }
 
   if (header) {
     *header = res;
   }
 
-  if (   (res.kind == SZ_NULL_POINTER_CHUNK && !null_allowed)
-      || res.kind != type) {
+  if (  res.kind == SZ_NULL_POINTER_CHUNK
+      ? !null_allowed
+      : res.kind != type) {
     error = sz_errstr_wrong_kind;
     return SZ_ERROR_WRONG_KIND;
   } else if (res.name != name) {
@@ -259,21 +334,38 @@ sz_read_context_t::read_array_header(
   SZ_RETURN_IF_ERROR( read_header(&res.base, SZ_ARRAY_CHUNK, name, true) );
 
   if (res.base.kind == SZ_NULL_POINTER_CHUNK) {
+    if (chunk) {
+      chunk->base = res.base;
+    }
     return SZ_SUCCESS;
-  } else if (   sz_read_prim(stream, &res.length)
-             || sz_read_prim(stream, &res.type)) {
+  } else if (   sz_read_prim(this, &res.length)
+             || sz_read_prim(this, &res.type)) {
     return file_error();
   }
 
+  skip_padding();
+
   if (chunk) {
     *chunk = res;
   }
 
-  if (res.type == type) {
-    return SZ_SUCCESS;
-  } else {
+  // Encoded arrays are read as arrays of their element type.
+  if ((res.type & SZ_ARRAY_TYPE_MASK) != uint32_t(type)) {
+    return SZ_ERROR_WRONG_KIND;
+  }
+
+  // Unencoded arrays can't claim more elements than their payload holds, or
+  // reading, swapping or viewing them would run past it.
+  const size_t type_size = sz_element_size(type);
+
+  if (   (res.type >> SZ_ARRAY_ENCODING_SHIFT) == 0
+      && type_size != 0
+      && res.length > uint64_t(chunk_end - buffered_tell()) / type_size) {
+    error = sz_errstr_bad_header;
     return SZ_ERROR_WRONG_KIND;
   }
+
+  return SZ_SUCCESS;
 }
 
 
@@ -288,6 +380,8 @@ sz_read_context_t::read_array_body(
   const bool have_buffer = (buf_out != nullptr) && (*buf_out != nullptr);
   void *buffer;
 
+  alloc = output_allocator(alloc);
+
   if (chunk->base.kind == SZ_NULL_POINTER_CHUNK) {
     if (buf_out) {
       *buf_out = NULL;
@@ -312,23 +406,25 @@ sz_read_context_t::read_array_body(
     *length = arr_length;
   }
 
-  const size_t block_remainder = size_t(chunk->base.size) - sizeof(sz_array_t);
-
-  off_t end_of_block = sz_stream_tell(stream);
-
-  if (end_of_block == -1) {
-    return file_error();
+  if (chunk->type >> SZ_ARRAY_ENCODING_SHIFT) {
+    return read_encoded_array_body(buf_out, chunk, alloc);
   }
 
-  end_of_block += block_remainder;
+  const off_t end_of_block = chunk_end;
+  const size_t type_size = sz_element_size(sz_chunk_id_t(chunk->type));
+  // read_array_header checked that the payload holds this many bytes.
+  const size_t payload_size = arr_length * type_size;
 
   sz_response_t response = SZ_SUCCESS;
 
-  if (buf_out) {
+  if (type_size == 0) {
+    error = sz_errstr_wrong_kind;
+    response = SZ_ERROR_INVALID_OPERATION;
+  } else if (buf_out) {
     if (have_buffer) {
       buffer = *buf_out;
     } else {
-      buffer = sz_malloc(block_remainder, alloc);
+      buffer = sz_malloc(payload_size, alloc);
 
       if (!buffer) {
         error = sz_errstr_nomem;
@@ -337,7 +433,7 @@ sz_read_context_t::read_array_body(
       }
     }
 
-    if (sz_stream_read(buffer, block_remainder, stream) != block_remainder) {
+    if (buffered_read(buffer, payload_size) != payload_size) {
       if (!have_buffer) {
         sz_free(buffer, alloc);
       }
@@ -345,28 +441,10 @@ sz_read_context_t::read_array_body(
       goto sz_read_array_body_done;
     }
 
-#if SZ_ENDIANNESS != SZ_BASE_ENDIANNESS
-    switch (chunk->type) {
-    case SZ_UINT32_CHUNK:
-    case SZ_SINT32_CHUNK:
-    case SZ_FLOAT_CHUNK:
-    case SZ_COMPOUND_REF_CHUNK: {
-      uint32_t *data = (uint32_t *)buffer;
-      const uint32_t *const data_end = data + arr_length;
-      for (; data < data_end; ++data) {
-        *data = sz_htonl(*data);
-      }
-    } break;
-
-    default:
-      if (!have_buffer) {
-        sz_free(buffer, alloc);
-      }
-      response = SZ_ERROR_INVALID_OPERATION;
-      error = sz_errstr_wrong_kind;
-      goto sz_read_array_body_done;
+    // Swap the whole array at once if it's not in the host's byte order.
+    if (swap_bytes) {
+      sz_byteswap(buffer, buffer, arr_length, type_size);
     }
-#endif
 
     if (!have_buffer) {
       *buf_out = buffer;
@@ -377,7 +455,92 @@ sz_read_context_t::read_array_body(
   }
 
 sz_read_array_body_done:
-  sz_stream_seek(end_of_block, SEEK_SET, stream);
+  buffered_seek(end_of_block);
+
+  return response;
+}
+
+
+sz_response_t
+sz_read_context_t::read_encoded_array_body(
+  void **buf_out,
+  const sz_array_t *chunk,
+  sz_allocator_t *alloc
+  )
+{
+  const bool have_buffer = (buf_out != nullptr) && (*buf_out != nullptr);
+  const sz_chunk_id_t type = sz_chunk_id_t(chunk->type & SZ_ARRAY_TYPE_MASK);
+  const sz_array_encoding_t encoding =
+    sz_array_encoding_t(chunk->type >> SZ_ARRAY_ENCODING_SHIFT);
+  const size_t arr_length = size_t(chunk->length);
+  const size_t type_size = sz_element_size(type);
+  const off_t end_of_block = chunk_end;
+  const size_t encoded_size = size_t(end_of_block - buffered_tell());
+  const uint8_t *source = NULL;
+  void *buffer = NULL;
+
+  sz_response_t response = SZ_SUCCESS;
+
+  if (buf_out == NULL) {
+    error = sz_errstr_cannot_read;
+    response = SZ_ERROR_CANNOT_READ;
+    goto sz_read_encoded_array_body_done;
+  } else if (type_size == 0 || arr_length > ~size_t(0) / type_size) {
+    error = sz_errstr_corrupt_array;
+    response = SZ_ERROR_WRONG_KIND;
+    goto sz_read_encoded_array_body_done;
+  }
+
+  // Payloads already in memory are decoded in place.
+  if (encoded_size <= buffer_length - buffer_pos) {
+    source = data + buffer_pos;
+  } else {
+    if (encoded.size() < encoded_size) {
+      encoded.resize(encoded_size);
+    }
+
+    if (buffered_read(&encoded[0], encoded_size) != encoded_size) {
+      response = file_error();
+      goto sz_read_encoded_array_body_done;
+    }
+
+    source = &encoded[0];
+  }
+
+  if (have_buffer) {
+    buffer = *buf_out;
+  } else {
+    buffer = sz_malloc(arr_length * type_size, alloc);
+
+    if (!buffer) {
+      error = sz_errstr_nomem;
+      response = SZ_ERROR_OUT_OF_MEMORY;
+      goto sz_read_encoded_array_body_done;
+    }
+  }
+
+  if (sz_array_decode(
+        encoding,
+        type,
+        source,
+        encoded_size,
+        buffer,
+        arr_length
+        )) {
+    if (!have_buffer) {
+      sz_free(buffer, alloc);
+    }
+    error = sz_errstr_corrupt_array;
+    response = SZ_ERROR_WRONG_KIND;
+    goto sz_read_encoded_array_body_done;
+  }
+
+  if (!have_buffer) {
+    *buf_out = buffer;
+  }
+
+sz_read_encoded_array_body_done:
+  buffered_seek(end_of_block);
 
   return response;
 }
@@ -397,7 +560,7 @@ sz_read_context_t::read_primitive_array(
 
   sz_response_t response;
   sz_array_t header;
-  const off_t error_off = sz_stream_tell(stream);
+  const off_t error_off = buffered_tell();
 
   response = read_array_header(&header, type, name);
   if (response != SZ_SUCCESS) {
@@ -412,7 +575,7 @@ sz_read_context_t::read_primitive_array(
   return SZ_SUCCESS;
 
 sz_read_primitive_array_error:
-  sz_stream_seek(error_off, SEEK_SET, stream);
+  buffered_seek(error_off);
   return response;
 }
 
@@ -430,10 +593,12 @@ sz_read_context_t::read_bytes(
   const bool have_buffer = (out != nullptr) && (*out != nullptr);
   sz_response_t response = SZ_SUCCESS;
   sz_header_t header;
-  const off_t error_off = sz_stream_tell(stream);
+  const off_t error_off = buffered_tell();
   size_t bytes_length = 0;
   void *buffer = NULL;
 
+  buf_alloc = output_allocator(buf_alloc);
+
   SZ_JUMP_IF_ERROR(
     read_header(&header, SZ_BYTES_CHUNK, name, true),
     response,
@@ -441,7 +606,8 @@ sz_read_context_t::read_bytes(
     );
 
   if (header.kind != SZ_NULL_POINTER_CHUNK) {
-    bytes_length = header.size - sizeof(header);
+    skip_padding();
+    bytes_length = size_t(chunk_end - buffered_tell());
 
     if (out) {
       if (have_buffer) {
@@ -457,7 +623,7 @@ sz_read_context_t::read_bytes(
       }
 
 
-      if (sz_stream_read(buffer, bytes_length, stream) != bytes_length) {
+      if (buffered_read(buffer, bytes_length) != bytes_length) {
         if (!have_buffer) {
           sz_free(buffer, buf_alloc);
         }
@@ -465,7 +631,7 @@ sz_read_context_t::read_bytes(
         goto sz_read_bytes_error;
       }
     } else {
-      sz_stream_seek(bytes_length, SEEK_CUR, stream);
+      buffered_seek(buffered_tell() + off_t(bytes_length));
     }
   }
 
@@ -480,31 +646,16 @@ sz_read_context_t::read_bytes(
   return SZ_SUCCESS;
 
   sz_read_bytes_error:
-    sz_stream_seek(error_off, SEEK_SET, stream);
+    buffered_seek(error_off);
     return response;
 }
 
 
-// Info stack
-void
-sz_read_context_t::push_stack()
-{
-  offsets.push_back(sz_stream_tell(stream));
-}
-
-
-void
-sz_read_context_t::pop_stack()
-{
-  sz_stream_seek(offsets.back(), SEEK_SET, stream);
-  offsets.pop_back();
-}
-
-
-// Primitives
+// Views
 sz_response_t
-sz_read_context_t::read_primitive(
-  void *out,
+sz_read_context_t::read_array_view(
+  const void **out,
+  size_t *length,
   sz_chunk_id_t type,
   size_t type_size,
   uint32_t name
@@ -512,119 +663,718 @@ sz_read_context_t::read_primitive(
 {
   SZ_RETURN_IF_CLOSED;
 
-  sz_header_t header;
-  const off_t error_off = sz_stream_tell(stream);
   sz_response_t response = SZ_SUCCESS;
+  sz_array_t header;
+  const off_t error_off = buffered_tell();
+  const void *view = NULL;
+  size_t arr_length = 0;
 
-  response = read_header(&header, type, name, false);
-  if (response != SZ_SUCCESS) {
-    goto sz_read_primitive_error;
-  }
+  SZ_JUMP_IF_ERROR(
+    read_array_header(&header, type, name),
+    response,
+    sz_read_array_view_error
+    );
 
-  if (sz_stream_read(out, type_size, stream) != type_size) {
-    response = file_error();
-    goto sz_read_primitive_error;
-  }
+  if (header.base.kind != SZ_NULL_POINTER_CHUNK) {
+    if (header.type >> SZ_ARRAY_ENCODING_SHIFT) {
+      error = sz_errstr_encoded_array;
+      response = SZ_ERROR_INVALID_OPERATION;
+      goto sz_read_array_view_error;
+    } else if (swap_bytes && type_size > 1) {
+      error = sz_errstr_view_endianness;
+      response = SZ_ERROR_INVALID_OPERATION;
+      goto sz_read_array_view_error;
+    }
 
-  // TODO: Verify structure size if changing header structure (i.e., if the
-  // format changes, make the appropriate changes to support older versions and
-  // account for padding bytes and so on)
-  if (   header.kind != type
-      || header.size != sizeof(sz_header_t) + type_size) {
-    error = sz_errstr_wrong_kind;
-    response = SZ_ERROR_WRONG_KIND;
-    goto sz_read_primitive_error;
-  } else if (header.name != name) {
-    error = sz_errstr_bad_name;
-    response = SZ_ERROR_BAD_NAME;
-    goto sz_read_primitive_error;
-  }
+    arr_length = size_t(header.length);
+
+    if (arr_length == 0) {
+      error = sz_errstr_empty_array;
+      response = SZ_ERROR_EMPTY_ARRAY;
+      goto sz_read_array_view_error;
+    }
 
-#if SZ_ENDIANNESS != SZ_BASE_ENDIANNESS
-  if (out && type_size > 1) {
-    switch (type_size) {
-    case 2: *(uint16_t *)out = sz_htons(*(uint16_t *)out); break;
-    case 4: *(uint32_t *)out = sz_htonl(*(uint32_t *)out); break;
-    default:
-      error = sz_errstr_wrong_kind;
+    view = buffered_view(size_t(chunk_end - buffered_tell()));
+
+    if (view == NULL) {
+      error = sz_errstr_no_view;
+      response = SZ_ERROR_INVALID_OPERATION;
+      goto sz_read_array_view_error;
+    } else if ((uintptr_t)view % type_size) {
+      error = sz_errstr_view_misaligned;
       response = SZ_ERROR_INVALID_OPERATION;
-      goto sz_read_primitive_error;
+      goto sz_read_array_view_error;
     }
   }
-#endif
+
+  if (out) {
+    *out = view;
+  }
+
+  if (length) {
+    *length = arr_length;
+  }
 
   return SZ_SUCCESS;
 
-sz_read_primitive_error:
-  sz_stream_seek(error_off, SEEK_SET, stream);
+sz_read_array_view_error:
+  buffered_seek(error_off);
   return response;
 }
 
 
 sz_response_t
-sz_read_context_t::read_compound(
-  void **compound,
-  uint32_t name,
-  sz_compound_reader_fn_t reader,
-  void *reader_ctx
+sz_read_context_t::read_bytes_view(
+  const void **out,
+  size_t *length,
+  uint32_t name
   )
 {
-  const off_t error_off = sz_stream_tell(stream);
+  SZ_RETURN_IF_CLOSED;
+
   sz_response_t response = SZ_SUCCESS;
   sz_header_t header;
-  void *result = NULL;
+  const off_t error_off = buffered_tell();
+  const void *view = NULL;
+  size_t bytes_length = 0;
 
   SZ_JUMP_IF_ERROR(
-    read_header(&header, SZ_COMPOUND_REF_CHUNK, name, true),
+    read_header(&header, SZ_BYTES_CHUNK, name, true),
     response,
-    sz_read_compound_error
+    sz_read_bytes_view_error
     );
 
   if (header.kind != SZ_NULL_POINTER_CHUNK) {
-    uint32_t compound_index = 0;
+    skip_padding();
+    bytes_length = size_t(chunk_end - buffered_tell());
+    view = buffered_view(bytes_length);
 
-    if (sz_read_prim(stream, &compound_index)) {
-      response = file_error();
-      goto sz_read_compound_error;
+    if (view == NULL && bytes_length) {
+      error = sz_errstr_no_view;
+      response = SZ_ERROR_INVALID_OPERATION;
+      goto sz_read_bytes_view_error;
     }
+  }
 
-    SZ_JUMP_IF_ERROR(
-      get_compound(&result, compound_index, reader, reader_ctx),
-      response,
-      sz_read_compound_error
-      );
+  if (out) {
+    *out = view;
   }
 
-  if (compound) {
-    *compound = result;
+  if (length) {
+    *length = bytes_length;
   }
 
   return SZ_SUCCESS;
 
-sz_read_compound_error:
-  sz_stream_seek(error_off, SEEK_SET, stream);
+sz_read_bytes_view_error:
+  buffered_seek(error_off);
   return response;
 }
 
 
 sz_response_t
-sz_read_context_t::read_compound_array(
-  void ***compounds,
-  size_t *length,
+sz_read_context_t::begin_array(
+  sz_chunk_id_t type,
   uint32_t name,
-  sz_compound_reader_fn_t reader,
-  void *reader_ctx,
-  sz_allocator_t *alloc
+  size_t *length
   )
 {
-  sz_response_t response;
+  SZ_RETURN_IF_CLOSED;
+
+  if (window.active) {
+    error = sz_errstr_array_open;
+    return SZ_ERROR_INVALID_OPERATION;
+  }
+
+  // Compound refs are only meaningful to the reader itself.
+  const size_t type_size =
+    type == SZ_COMPOUND_REF_CHUNK ? 0 : sz_element_size(type);
+
+  if (type_size == 0) {
+    error = sz_errstr_wrong_kind;
+    return SZ_ERROR_INVALID_OPERATION;
+  }
+
+  sz_response_t response = SZ_SUCCESS;
+  const off_t error_off = buffered_tell();
+  window_t opened_window = { true, type_size, 0, 0, 0 };
+  bool is_null = false;
+
+  if (type == SZ_BYTES_CHUNK) {
+    sz_header_t header;
+
+    SZ_JUMP_IF_ERROR(
+      read_header(&header, SZ_BYTES_CHUNK, name, true),
+      response,
+      sz_begin_array_error
+      );
+
+    is_null = header.kind == SZ_NULL_POINTER_CHUNK;
+    if (!is_null) {
+      skip_padding();
+      opened_window.remaining = uint64_t(chunk_end - buffered_tell());
+    }
+  } else {
+    sz_array_t header;
+
+    SZ_JUMP_IF_ERROR(
+      read_array_header(&header, type, name),
+      response,
+      sz_begin_array_error
+      );
+
+    is_null = header.base.kind == SZ_NULL_POINTER_CHUNK;
+    if (!is_null) {
+      if (header.type >> SZ_ARRAY_ENCODING_SHIFT) {
+        error = sz_errstr_encoded_array;
+        response = SZ_ERROR_INVALID_OPERATION;
+        goto sz_begin_array_error;
+      } else if (header.length == 0) {
+        error = sz_errstr_empty_array;
+        response = SZ_ERROR_EMPTY_ARRAY;
+        goto sz_begin_array_error;
+      }
+
+      opened_window.remaining = header.length;
+    }
+  }
+
+  if (uint64_t(size_t(opened_window.remaining)) != opened_window.remaining) {
+    error = sz_errstr_array_too_long;
+    response = SZ_ERROR_INVALID_OPERATION;
+    goto sz_begin_array_error;
+  }
+
+  opened_window.pos = buffered_tell();
+  opened_window.end = is_null ? opened_window.pos : chunk_end;
+  window = opened_window;
+
+  if (length) {
+    *length = size_t(opened_window.remaining);
+  }
+
+  return SZ_SUCCESS;
+
+sz_begin_array_error:
+  buffered_seek(error_off);
+  return response;
+}
+
+
+sz_response_t
+sz_read_context_t::read_array_window(
+  void *out,
+  size_t capacity,
+  size_t *count
+  )
+{
+  SZ_RETURN_IF_CLOSED;
+
+  if (!window.active) {
+    error = sz_errstr_no_array;
+    return SZ_ERROR_INVALID_OPERATION;
+  }
+
+  const size_t window_length =
+    uint64_t(capacity) < window.remaining
+    ? capacity
+    : size_t(window.remaining);
+  const size_t window_size = window_length * window.type_size;
+
+  if (out && window_length) {
+    buffered_seek(window.pos);
+
+    if (buffered_read(out, window_size) != window_size) {
+      return file_error();
+    }
+
+    if (swap_bytes && window.type_size > 1) {
+      sz_byteswap(out, out, window_length, window.type_size);
+    }
+  }
+
+  window.pos += off_t(window_size);
+  window.remaining -= window_length;
+
+  if (count) {
+    *count = window_length;
+  }
+
+  return SZ_SUCCESS;
+}
+
+
+sz_response_t
+sz_read_context_t::end_array()
+{
+  SZ_RETURN_IF_CLOSED;
+
+  if (!window.active) {
+    error = sz_errstr_no_array;
+    return SZ_ERROR_INVALID_OPERATION;
+  }
+
+  // Skips whatever wasn't read.
+  buffered_seek(window.end);
+  window = no_window;
+
+  return SZ_SUCCESS;
+}
+
+
+bool
+sz_read_context_t::read_size(uint64_t *out)
+{
+  if (format_version < 3) {
+    uint32_t size = 0;
+    const bool r = sz_read_prim(this, &size);
+    *out = size;
+    return r;
+  }
+
+  return sz_read_prim(this, out);
+}
+
+
+void
+sz_read_context_t::skip_padding()
+{
+  const off_t offset = buffered_tell();
+  const off_t pad_size =
+    off_t(sz_padding(uint64_t(offset - stream_pos), payload_alignment));
+
+  if (pad_size) {
+    buffered_seek(offset + pad_size);
+    chunk_end += pad_size;
+  }
+}
+
+
+bool
+sz_read_context_t::read_varint(uint64_t *out)
+{
+  uint64_t value = 0;
+
+  for (int shift = 0; shift < 7 * SZ_VARINT_MAX_LENGTH; shift += 7) {
+    uint8_t byte = 0;
+
+    if (buffered_read(&byte, 1) != 1) {
+      return true;
+    }
+
+    value |= uint64_t(byte & 0x7F) << shift;
+
+    if ((byte & 0x80) == 0) {
+      *out = value;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+sz_response_t
+sz_read_context_t::read_compact_header(sz_header_t *header)
+{
+  const off_t chunk_start = buffered_tell();
+  uint8_t kind = 0;
+  uint64_t name = 0;
+  uint64_t payload_size = 0;
+
+  if (buffer_length - buffer_pos >= SZ_COMPACT_HEADER_MAX_SIZE) {
+    // Fast path: the whole header is in the read-ahead buffer, so decode it in
+    // place.
+    const uint8_t *const start = data + buffer_pos;
+    const uint8_t *const end = start + SZ_COMPACT_HEADER_MAX_SIZE;
+    const uint8_t *in = start;
+    size_t length = 0;
+
+    kind = *in++;
+
+    if ((length = sz_varint_decode(in, end, &name)) == 0) {
+      error = sz_errstr_bad_header;
+      return SZ_ERROR_WRONG_KIND;
+    }
+    in += length;
+
+    if ((length = sz_varint_decode(in, end, &payload_size)) == 0) {
+      error = sz_errstr_bad_header;
+      return SZ_ERROR_WRONG_KIND;
+    }
+    in += length;
+
+    buffer_pos += size_t(in - start);
+  } else if (   buffered_read(&kind, 1) != 1
+             || read_varint(&name)
+             || read_varint(&payload_size)) {
+    return file_error();
+  }
+
+  if (kind != SZ_COMPOUND_CHUNK && kind != SZ_DATA_CHUNK) {
+    if (name >= names.size()) {
+      error = sz_errstr_bad_name;
+      return SZ_ERROR_BAD_NAME;
+    }
+
+    name = names[size_t(name)];
+  }
+
+  header->kind = kind;
+  header->name = uint32_t(name);
+  header->size = uint64_t(buffered_tell() - chunk_start) + payload_size;
+
+  return SZ_SUCCESS;
+}
+
+
+sz_response_t
+sz_read_context_t::read_any_header(sz_header_t *header)
+{
+  const off_t chunk_start = buffered_tell();
+
+  if (root_flags & SZ_ROOT_COMPACT_HEADERS) {
+    SZ_RETURN_IF_ERROR( read_compact_header(header) );
+  } else if (   sz_read_prim(this, &header->kind)
+             || sz_read_prim(this, &header->name)
+             || read_size(&header->size)) {
+    return file_error();
+  }
+
+  chunk_end = chunk_start + off_t(header->size);
+
+  return SZ_SUCCESS;
+}
+
+
+sz_response_t
+sz_read_context_t::enter_scope()
+{
+  scope_t scope = { 0, 0, 0, chunk_end };
+
+  if (root_flags & SZ_ROOT_NAME_INDEX) {
+    if (sz_read_prim(this, &scope.index_length)) {
+      return file_error();
+    }
+
+    scope.index_offset = buffered_tell();
+    buffered_seek(
+      scope.index_offset
+      + off_t(scope.index_length) * off_t(SZ_NAME_INDEX_ENTRY_SIZE)
+      );
+  }
+
+  scope.body_offset = buffered_tell();
+  scopes.push_back(scope);
+
+  return SZ_SUCCESS;
+}
+
+
+sz_response_t
+sz_read_context_t::seek_field(uint32_t name, off_t from)
+{
+  const scope_t &scope = scopes.back();
+  const uint64_t relative_from =
+    from > scope.body_offset ? uint64_t(from - scope.body_offset) : 0;
+  uint32_t entry_name = 0;
+  uint64_t entry_offset = 0;
+
+  // Entries are sorted by name, then offset, so binary search for the first
+  // entry for name at or after from. If there isn't one, search again for the
+  // first entry for name at all.
+  for (int pass = 0; pass < 2; ++pass) {
+    const uint64_t min_offset = pass == 0 ? relative_from : 0;
+    uint32_t low = 0;
+    uint32_t high = scope.index_length;
+
+    while (low < high) {
+      const uint32_t mid = low + (high - low) / 2;
+
+      buffered_seek(
+        scope.index_offset + off_t(mid) * off_t(SZ_NAME_INDEX_ENTRY_SIZE)
+        );
+      if (   sz_read_prim(this, &entry_name)
+          || sz_read_prim(this, &entry_offset)) {
+        return file_error();
+      }
+
+      if (   entry_name < name
+          || (entry_name == name && entry_offset < min_offset)) {
+        low = mid + 1;
+      } else {
+        high = mid;
+      }
+    }
+
+    if (low < scope.index_length) {
+      buffered_seek(
+        scope.index_offset + off_t(low) * off_t(SZ_NAME_INDEX_ENTRY_SIZE)
+        );
+      if (   sz_read_prim(this, &entry_name)
+          || sz_read_prim(this, &entry_offset)) {
+        return file_error();
+      }
+
+      if (entry_name == name) {
+        buffered_seek(scope.body_offset + off_t(entry_offset));
+        return SZ_SUCCESS;
+      }
+    }
+  }
+
+  error = sz_errstr_bad_name;
+  return SZ_ERROR_BAD_NAME;
+}
+
+
+// Buffered stream access
+size_t
+sz_read_context_t::refill_read(void *out, size_t length)
+{
+  uint8_t *dst = (uint8_t *)out;
+  const size_t buffered = buffer_length - buffer_pos;
+
+  memcpy(dst, data + buffer_pos, buffered);
+  dst += buffered;
+  length -= buffered;
+
+  buffer_origin += off_t(buffer_length);
+  buffer_length = 0;
+  buffer_pos = 0;
+  data = buffer;
+  preloaded = false;
+
+  // Reads at least as big as the buffer skip it and go straight to out.
+  if (length >= SZ_READ_BUFFER_SIZE) {
+    const size_t read_size = sz_stream_read(dst, length, stream);
+    buffer_origin += off_t(read_size);
+    return buffered + read_size;
+  }
+
+  buffer_length = sz_stream_read(buffer, SZ_READ_BUFFER_SIZE, stream);
+  if (length > buffer_length) {
+    length = buffer_length;
+  }
+
+  memcpy(dst, buffer, length);
+  buffer_pos = length;
+  return buffered + length;
+}
+
+
+void
+sz_read_context_t::discard_buffer(off_t off)
+{
+  sz_stream_seek(off, SEEK_SET, stream);
+  buffer_origin = off;
+  buffer_length = 0;
+  buffer_pos = 0;
+  data = buffer;
+  preloaded = false;
+}
+
+
+sz_response_t
+sz_read_context_t::preload(uint64_t size)
+{
+  // The root was read from the start of the buffer, so whatever the buffer
+  // holds is the start of the snowball and the stream is right after it.
+  if (uint64_t(size_t(size)) != size) {
+    error = sz_errstr_nomem;
+    return SZ_ERROR_OUT_OF_MEMORY;
+  }
+
+  const size_t total = size_t(size);
+
+  if (total > buffer_capacity) {
+    uint8_t *const grown = (uint8_t *)sz_malloc(total, ctx_alloc);
+
+    if (grown == NULL) {
+      error = sz_errstr_nomem;
+      return SZ_ERROR_OUT_OF_MEMORY;
+    }
+
+    memcpy(grown, buffer, buffer_length);
+    sz_free(buffer, ctx_alloc);
+    buffer = grown;
+    data = grown;
+    buffer_capacity = total;
+  }
+
+  if (buffer_length < total) {
+    const size_t rest = total - buffer_length;
+
+    if (sz_stream_read(buffer + buffer_length, rest, stream) != rest) {
+      return file_error();
+    }
+
+    buffer_length = total;
+  }
+
+  preloaded = true;
+
+  return SZ_SUCCESS;
+}
+
+
+const void *
+sz_read_context_t::buffered_view(size_t length)
+{
+  // A preloaded buffer isn't refilled, so it can be viewed directly.
+  if (preloaded && length <= buffer_length - buffer_pos) {
+    const void *const view = data + buffer_pos;
+    buffer_pos += length;
+    return view;
+  }
+
+  // The stream has to be at the logical position to view from it.
+  discard_buffer(buffered_tell());
+
+  const void *view = sz_stream_view(length, stream);
+  if (view) {
+    buffer_origin += off_t(length);
+  }
+
+  return view;
+}
+
+
+// Info stack
+void
+sz_read_context_t::push_stack()
+{
+  offsets.push_back(buffered_tell());
+}
+
+
+void
+sz_read_context_t::pop_stack()
+{
+  buffered_seek(offsets.back());
+  offsets.pop_back();
+}
+
+
+// Primitives
+sz_response_t
+sz_read_context_t::read_primitive(
+  void *out,
+  sz_chunk_id_t type,
+  size_t type_size,
+  uint32_t name
+  )
+{
+  SZ_RETURN_IF_CLOSED;
+
+  sz_header_t header;
+  const off_t error_off = buffered_tell();
+  sz_response_t response = SZ_SUCCESS;
+  off_t payload_size = 0;
+
+  response = read_header(&header, type, name, false);
+  if (response != SZ_SUCCESS) {
+    goto sz_read_primitive_error;
+  }
+
+  payload_size = chunk_end - buffered_tell();
+
+  if (buffered_read(out, type_size) != type_size) {
+    response = file_error();
+    goto sz_read_primitive_error;
+  }
+
+  // The payload size is checked against chunk_end rather than the header size
+  // so this holds for every format version.
+  if (   header.kind != type
+      || payload_size != off_t(type_size)) {
+    error = sz_errstr_wrong_kind;
+    response = SZ_ERROR_WRONG_KIND;
+    goto sz_read_primitive_error;
+  } else if (header.name != name) {
+    error = sz_errstr_bad_name;
+    response = SZ_ERROR_BAD_NAME;
+    goto sz_read_primitive_error;
+  }
+
+  if (swap_bytes && out) {
+    sz_byteswap(out, out, 1, type_size);
+  }
+
+  return SZ_SUCCESS;
+
+sz_read_primitive_error:
+  buffered_seek(error_off);
+  return response;
+}
+
+
+sz_response_t
+sz_read_context_t::read_compound(
+  void **compound,
+  uint32_t name,
+  sz_compound_reader_fn_t reader,
+  void *reader_ctx
+  )
+{
+  const off_t error_off = buffered_tell();
+  sz_response_t response = SZ_SUCCESS;
+  sz_header_t header;
+  void *result = NULL;
+
+  SZ_JUMP_IF_ERROR(
+    read_header(&header, SZ_COMPOUND_REF_CHUNK, name, true),
+    response,
+    sz_read_compound_error
+    );
+
+  if (header.kind != SZ_NULL_POINTER_CHUNK) {
+    uint32_t compound_index = 0;
+
+    if (sz_read_prim(this, &compound_index)) {
+      response = file_error();
+      goto sz_read_compound_error;
+    }
+
+    SZ_JUMP_IF_ERROR(
+      get_compound(&result, compound_index, reader, reader_ctx),
+      response,
+      sz_read_compound_error
+      );
+  }
+
+  if (compound) {
+    *compound = result;
+  }
+
+  return SZ_SUCCESS;
+
+sz_read_compound_error:
+  buffered_seek(error_off);
+  return response;
+}
+
+
+sz_response_t
+sz_read_context_t::read_compound_array(
+  void ***compounds,
+  size_t *length,
+  uint32_t name,
+  sz_compound_reader_fn_t reader,
+  void *reader_ctx,
+  sz_allocator_t *alloc
+  )
+{
+  sz_response_t response;
   sz_array_t header;
-  const off_t error_off = sz_stream_tell(stream);
+  const off_t error_off = buffered_tell();
 
   const bool have_buffer = (compounds != nullptr) && (*compounds != nullptr);
   void **compound_ptrs = NULL;
   size_t array_length = 0;
 
+  alloc = output_allocator(alloc);
+
   SZ_JUMP_IF_ERROR(
     read_array_header(&header, SZ_COMPOUND_REF_CHUNK, name),
     response,
@@ -652,7 +1402,7 @@ sz_read_context_t::read_compound_array(
       }
 
       for (; index < array_length; ++index) {
-        if (sz_read_prim(stream, &compound_index)) {
+        if (sz_read_prim(this, &compound_index)) {
           if (!have_buffer) {
             sz_free(compound_ptrs, alloc);
           }
@@ -672,7 +1422,7 @@ sz_read_context_t::read_compound_array(
           );
       }
     } else {
-      sz_stream_seek(sizeof(uint32_t) * header.length, SEEK_CUR, stream);
+      buffered_seek(buffered_tell() + off_t(sizeof(uint32_t) * header.length));
     }
   }
 
@@ -687,7 +1437,7 @@ sz_read_context_t::read_compound_array(
   return SZ_SUCCESS;
 
 sz_read_compound_array_error:
-  sz_stream_seek(error_off, SEEK_SET, stream);
+  buffered_seek(error_off);
   return response;
 }
 
@@ -709,11 +1459,15 @@ sz_read_context_t::get_compound(
 
   if (!pack.unpacked) {
     push_stack();
-    sz_stream_seek(pack.offset, SEEK_SET, stream);
+    buffered_seek(pack.offset);
 
     sz_header_t header;
     sz_response_t response;
     response = read_header(&header, SZ_COMPOUND_CHUNK, index, false);
+    if (response == SZ_SUCCESS) {
+      response = enter_scope();
+    }
+
     if (response != SZ_SUCCESS) {
       pop_stack();
       return response;
@@ -721,6 +1475,7 @@ sz_read_context_t::get_compound(
 
     pack.unpacked = true;
     reader(&pack.value, this, reader_ctx);
+    scopes.pop_back();
     pop_stack();
   }
 
@@ -744,6 +1499,33 @@ sz_read_context_t::open()
     return SZ_ERROR_INVALID_STREAM;
   }
 
+  if (buffer == NULL) {
+    buffer = (uint8_t *)sz_malloc(SZ_READ_BUFFER_SIZE, ctx_alloc);
+
+    if (buffer == NULL) {
+      error = sz_errstr_nomem;
+      return SZ_ERROR_OUT_OF_MEMORY;
+    }
+
+    buffer_capacity = SZ_READ_BUFFER_SIZE;
+  }
+
+  buffer_origin = sz_stream_tell(stream);
+  buffer_length = 0;
+  buffer_pos = 0;
+  data = buffer;
+  preloaded = false;
+  window = no_window;
+
+  // Memory-backed streams are read in place. The stream is moved to its end
+  // to keep it at buffer_origin + buffer_length, like any other buffer.
+  const uint8_t *const memory = sz_stream_memory(stream, &buffer_length);
+  if (memory) {
+    data = memory;
+    preloaded = true;
+    sz_stream_seek(off_t(buffer_length), SEEK_CUR, stream);
+  }
+
   is_open = true;
 
   push_stack();
@@ -751,13 +1533,30 @@ sz_read_context_t::open()
   sz_root_t root;
   SZ_RETURN_IF_ERROR( read_root(&root) );
 
+  if ((flags & SZ_PRELOAD) && !preloaded) {
+    SZ_RETURN_IF_ERROR( preload(root.size) );
+  }
+
   const off_t mappings_off = stream_pos + root.mappings_offset;
   const off_t compounds_off = stream_pos + root.compounds_offset;
   const off_t data_off = stream_pos + root.data_offset;
 
-  compounds.resize(root.num_compounds, default_unpacked_compound);
+  // Counts are checked against the bytes left for their tables before anything
+  // is allocated for them, so corrupt counts can't ask for gigabytes.
+  const uint64_t mapping_size =
+    format_version < 3 ? sizeof(uint32_t) : sizeof(uint64_t);
+
+  if (root.num_compounds > (root.size - root.mappings_offset) / mapping_size) {
+    pop_stack();
+    error = sz_errstr_malformed_root;
+    return SZ_INVALID_ROOT;
+  }
+
+  // assign, not resize, so compounds unpacked from a previous snowball aren't
+  // mistaken for this one's.
+  compounds.assign(root.num_compounds, default_unpacked_compound);
 
-  sz_stream_seek(mappings_off, SEEK_SET, stream);
+  buffered_seek(mappings_off);
   // Read compound offsets
   #if __cplusplus >= 201103L
   for (unpacked_compound_t &pack : compounds) {
@@ -767,110 +1566,392 @@ sz_read_context_t::open()
   for (; iter != end; ++iter) {
     unpacked_compound_t &pack = *iter;
   #endif
-    uint32_t offset = 0;
-    if (sz_read_prim(stream, &offset)) {
+    uint64_t offset = 0;
+    if (read_size(&offset)) {
       pop_stack();
       return file_error();
+    } else if (offset > root.size - root.compounds_offset) {
+      pop_stack();
+      error = sz_errstr_malformed_root;
+      return SZ_INVALID_ROOT;
     }
 
     pack.offset = compounds_off + off_t(offset);
   }
 
+  // Read the name table, which follows the mappings
+  names.clear();
+  if (root_flags & SZ_ROOT_COMPACT_HEADERS) {
+    uint32_t num_names = 0;
+
+    if (sz_read_prim(this, &num_names)) {
+      pop_stack();
+      return file_error();
+    }
+
+    const off_t names_left = stream_pos + off_t(root.size) - buffered_tell();
+
+    if (   names_left < 0
+        || num_names > uint64_t(names_left) / sizeof(uint32_t)) {
+      pop_stack();
+      error = sz_errstr_malformed_root;
+      return SZ_INVALID_ROOT;
+    }
+
+    names.resize(num_names);
+
+    for (uint32_t index = 0; index < num_names; ++index) {
+      if (sz_read_prim(this, &names[index])) {
+        pop_stack();
+        return file_error();
+      }
+    }
+  }
+
   pop_stack();
 
-  // Jump to the data (we should already be there, but in case there's)
-  sz_stream_seek(data_off, SEEK_SET, stream);
+  // Jump to the data (we should already be there, but in case there's)
+  buffered_seek(data_off);
+
+  SZ_RETURN_IF_ERROR( read_header(NULL, SZ_DATA_CHUNK, SZ_DATA_NAME, false) );
+  SZ_RETURN_IF_ERROR( enter_scope() );
+
+  return SZ_SUCCESS;
+}
+
+
+sz_response_t
+sz_read_context_t::close()
+{
+  SZ_RETURN_IF_CLOSED;
+
+  // Leave the stream where reading stopped rather than wherever the read-ahead
+  // buffer ended.
+  discard_buffer(buffered_tell());
+  scopes.clear();
+  window = no_window;
+  is_open = false;
+
+  return SZ_SUCCESS;
+}
+
+
+sz_response_t
+sz_read_context_t::reset()
+{
+  // The read-ahead buffer and tables are kept for the next snowball.
+  if (opened()) {
+    scopes.clear();
+    offsets.clear();
+    window = no_window;
+    is_open = false;
+  }
+
+  return s_sz_context::reset();
+}
+
+
+bool
+sz_read_context_t::opened() const
+{
+  return is_open;
+}
+
+
+SZ_DEF_BEGIN
+
+
+sz_response_t
+sz_read_compound(
+  void **compound,
+  sz_context_t *ctx,
+  uint32_t name,
+  sz_compound_reader_fn_t *reader,
+  void *reader_ctx
+  )
+{
+  SZ_AS_READER(ctx, return)
+    ->read_compound(
+      compound,
+      name,
+      reader,
+      reader_ctx
+      );
+}
+
+
+sz_response_t
+sz_read_compounds(
+  void ***compounds,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name,
+  sz_compound_reader_fn_t *reader,
+  void *reader_ctx,
+  sz_allocator_t *buf_alloc
+  )
+{
+  SZ_AS_READER(ctx, return)
+    ->read_compound_array(
+      compounds,
+      length,
+      name,
+      reader,
+      reader_ctx,
+      buf_alloc
+      );
+}
+
+
+sz_response_t
+sz_read_bytes(
+  void **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name,
+  sz_allocator_t *buf_alloc
+  )
+{
+  SZ_AS_READER(ctx, return)->read_bytes(out, length, name, buf_alloc);
+}
+
+
+sz_response_t
+sz_begin_array(
+  size_t *length,
+  sz_context_t *ctx,
+  sz_chunk_id_t type,
+  uint32_t name
+  )
+{
+  SZ_AS_READER(ctx, return)->begin_array(type, name, length);
+}
+
+
+sz_response_t
+sz_read_array_window(
+  void *out,
+  size_t capacity,
+  size_t *count,
+  sz_context_t *ctx
+  )
+{
+  SZ_AS_READER(ctx, return)->read_array_window(out, capacity, count);
+}
+
+
+sz_response_t
+sz_end_array(sz_context_t *ctx)
+{
+  SZ_AS_READER(ctx, return)->end_array();
+}
+
+
+sz_response_t
+sz_read_float(float *out, sz_context_t *ctx, uint32_t name)
+{
+  float result;
+  sz_response_t response;
+
+  SZ_AS_READER(ctx, response = )
+    ->read_primitive(&result, SZ_FLOAT_CHUNK, sizeof(result), name);
+  SZ_RETURN_IF_ERROR(response);
+
+  if (out) {
+    *out = result;
+  }
+
+  return SZ_SUCCESS;
+}
+
+
+sz_response_t
+sz_read_floats(
+  float **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name,
+  sz_allocator_t *buf_alloc
+  )
+{
+  SZ_AS_READER(ctx, return)
+    ->read_primitive_array(
+      (void **)out,
+      length,
+      SZ_FLOAT_CHUNK,
+      sizeof(**out),
+      name,
+      buf_alloc
+      );
+}
+
+
+sz_response_t
+sz_read_int(int32_t *out, sz_context_t *ctx, uint32_t name)
+{
+  int32_t result;
+  sz_response_t response;
+
+  SZ_AS_READER(ctx, response = )
+    ->read_primitive(&result, SZ_SINT32_CHUNK, sizeof(result), name);
+  SZ_RETURN_IF_ERROR(response);
 
-  SZ_RETURN_IF_ERROR( read_header(NULL, SZ_DATA_CHUNK, SZ_DATA_NAME, false) );
+  if (out) {
+    *out = result;
+  }
 
   return SZ_SUCCESS;
 }
 
 
 sz_response_t
-sz_read_context_t::close()
+sz_read_ints(
+  int32_t **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name,
+  sz_allocator_t *buf_alloc
+  )
 {
-  SZ_RETURN_IF_CLOSED;
-
-  is_open = false;
 
-  return SZ_SUCCESS;
+  SZ_AS_READER(ctx, return)
+    ->read_primitive_array(
+      (void **)out,
+      length,
+      SZ_SINT32_CHUNK,
+      sizeof(**out),
+      name,
+      buf_alloc
+      );
 }
 
 
-bool
-sz_read_context_t::opened() const
+sz_response_t
+sz_read_unsigned_int(uint32_t *out, sz_context_t *ctx, uint32_t name)
 {
-  return is_open;
-}
+  uint32_t result;
+  sz_response_t response;
+
+  SZ_AS_READER(ctx, response = )
+    ->read_primitive(&result, SZ_UINT32_CHUNK, sizeof(result), name);
+  SZ_RETURN_IF_ERROR(response);
 
+  if (out) {
+    *out = result;
+  }
 
-SZ_DEF_BEGIN
+  return SZ_SUCCESS;
+}
 
 
 sz_response_t
-sz_read_compound(
-  void **compound,
+sz_read_unsigned_ints(
+  uint32_t **out,
+  size_t *length,
   sz_context_t *ctx,
   uint32_t name,
-  sz_compound_reader_fn_t *reader,
-  void *reader_ctx
+  sz_allocator_t *buf_alloc
   )
 {
+
   SZ_AS_READER(ctx, return)
-    ->read_compound(
-      compound,
+    ->read_primitive_array(
+      (void **)out,
+      length,
+      SZ_UINT32_CHUNK,
+      sizeof(**out),
       name,
-      reader,
-      reader_ctx
+      buf_alloc
       );
 }
 
 
 sz_response_t
-sz_read_compounds(
-  void ***compounds,
+sz_read_double(double *out, sz_context_t *ctx, uint32_t name)
+{
+  double result;
+  sz_response_t response;
+
+  SZ_AS_READER(ctx, response = )
+    ->read_primitive(&result, SZ_DOUBLE_CHUNK, sizeof(result), name);
+  SZ_RETURN_IF_ERROR(response);
+
+  if (out) {
+    *out = result;
+  }
+
+  return SZ_SUCCESS;
+}
+
+
+sz_response_t
+sz_read_doubles(
+  double **out,
   size_t *length,
   sz_context_t *ctx,
   uint32_t name,
-  sz_compound_reader_fn_t *reader,
-  void *reader_ctx,
   sz_allocator_t *buf_alloc
   )
 {
   SZ_AS_READER(ctx, return)
-    ->read_compound_array(
-      compounds,
+    ->read_primitive_array(
+      (void **)out,
       length,
+      SZ_DOUBLE_CHUNK,
+      sizeof(**out),
       name,
-      reader,
-      reader_ctx,
       buf_alloc
       );
 }
 
 
 sz_response_t
-sz_read_bytes(
-  void **out,
+sz_read_int64(int64_t *out, sz_context_t *ctx, uint32_t name)
+{
+  int64_t result;
+  sz_response_t response;
+
+  SZ_AS_READER(ctx, response = )
+    ->read_primitive(&result, SZ_SINT64_CHUNK, sizeof(result), name);
+  SZ_RETURN_IF_ERROR(response);
+
+  if (out) {
+    *out = result;
+  }
+
+  return SZ_SUCCESS;
+}
+
+
+sz_response_t
+sz_read_int64s(
+  int64_t **out,
   size_t *length,
   sz_context_t *ctx,
   uint32_t name,
   sz_allocator_t *buf_alloc
   )
 {
-  SZ_AS_READER(ctx, return)->read_bytes(out, length, name, buf_alloc);
+  SZ_AS_READER(ctx, return)
+    ->read_primitive_array(
+      (void **)out,
+      length,
+      SZ_SINT64_CHUNK,
+      sizeof(**out),
+      name,
+      buf_alloc
+      );
 }
 
 
 sz_response_t
-sz_read_float(float *out, sz_context_t *ctx, uint32_t name)
+sz_read_uint64(uint64_t *out, sz_context_t *ctx, uint32_t name)
 {
-  float result;
+  uint64_t result;
   sz_response_t response;
 
   SZ_AS_READER(ctx, response = )
-    ->read_primitive(&result, SZ_FLOAT_CHUNK, sizeof(result), name);
+    ->read_primitive(&result, SZ_UINT64_CHUNK, sizeof(result), name);
   SZ_RETURN_IF_ERROR(response);
 
   if (out) {
@@ -882,8 +1963,8 @@ sz_read_float(float *out, sz_context_t *ctx, uint32_t name)
 
 
 sz_response_t
-sz_read_floats(
-  float **out,
+sz_read_uint64s(
+  uint64_t **out,
   size_t *length,
   sz_context_t *ctx,
   uint32_t name,
@@ -894,7 +1975,7 @@ sz_read_floats(
     ->read_primitive_array(
       (void **)out,
       length,
-      SZ_FLOAT_CHUNK,
+      SZ_UINT64_CHUNK,
       sizeof(**out),
       name,
       buf_alloc
@@ -903,13 +1984,13 @@ sz_read_floats(
 
 
 sz_response_t
-sz_read_int(int32_t *out, sz_context_t *ctx, uint32_t name)
+sz_read_int16(int16_t *out, sz_context_t *ctx, uint32_t name)
 {
-  int32_t result;
+  int16_t result;
   sz_response_t response;
 
   SZ_AS_READER(ctx, response = )
-    ->read_primitive(&result, SZ_SINT32_CHUNK, sizeof(result), name);
+    ->read_primitive(&result, SZ_SINT16_CHUNK, sizeof(result), name);
   SZ_RETURN_IF_ERROR(response);
 
   if (out) {
@@ -921,20 +2002,19 @@ sz_read_int(int32_t *out, sz_context_t *ctx, uint32_t name)
 
 
 sz_response_t
-sz_read_ints(
-  int32_t **out,
+sz_read_int16s(
+  int16_t **out,
   size_t *length,
   sz_context_t *ctx,
   uint32_t name,
   sz_allocator_t *buf_alloc
   )
 {
-
   SZ_AS_READER(ctx, return)
     ->read_primitive_array(
       (void **)out,
       length,
-      SZ_SINT32_CHUNK,
+      SZ_SINT16_CHUNK,
       sizeof(**out),
       name,
       buf_alloc
@@ -943,13 +2023,13 @@ sz_read_ints(
 
 
 sz_response_t
-sz_read_unsigned_int(uint32_t *out, sz_context_t *ctx, uint32_t name)
+sz_read_int8(int8_t *out, sz_context_t *ctx, uint32_t name)
 {
-  uint32_t result;
+  int8_t result;
   sz_response_t response;
 
   SZ_AS_READER(ctx, response = )
-    ->read_primitive(&result, SZ_UINT32_CHUNK, sizeof(result), name);
+    ->read_primitive(&result, SZ_SINT8_CHUNK, sizeof(result), name);
   SZ_RETURN_IF_ERROR(response);
 
   if (out) {
@@ -961,20 +2041,19 @@ sz_read_unsigned_int(uint32_t *out, sz_context_t *ctx, uint32_t name)
 
 
 sz_response_t
-sz_read_unsigned_ints(
-  uint32_t **out,
+sz_read_int8s(
+  int8_t **out,
   size_t *length,
   sz_context_t *ctx,
   uint32_t name,
   sz_allocator_t *buf_alloc
   )
 {
-
   SZ_AS_READER(ctx, return)
     ->read_primitive_array(
       (void **)out,
       length,
-      SZ_UINT32_CHUNK,
+      SZ_SINT8_CHUNK,
       sizeof(**out),
       name,
       buf_alloc
@@ -982,5 +2061,169 @@ sz_read_unsigned_ints(
 }
 
 
+sz_response_t
+sz_read_bytes_view(
+  const void **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name
+  )
+{
+  SZ_AS_READER(ctx, return)->read_bytes_view(out, length, name);
+}
+
+
+sz_response_t
+sz_read_floats_view(
+  const float **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name
+  )
+{
+  SZ_AS_READER(ctx, return)
+    ->read_array_view(
+      (const void **)out,
+      length,
+      SZ_FLOAT_CHUNK,
+      sizeof(**out),
+      name
+      );
+}
+
+
+sz_response_t
+sz_read_ints_view(
+  const int32_t **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name
+  )
+{
+  SZ_AS_READER(ctx, return)
+    ->read_array_view(
+      (const void **)out,
+      length,
+      SZ_SINT32_CHUNK,
+      sizeof(**out),
+      name
+      );
+}
+
+
+sz_response_t
+sz_read_unsigned_ints_view(
+  const uint32_t **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name
+  )
+{
+  SZ_AS_READER(ctx, return)
+    ->read_array_view(
+      (const void **)out,
+      length,
+      SZ_UINT32_CHUNK,
+      sizeof(**out),
+      name
+      );
+}
+
+
+sz_response_t
+sz_read_doubles_view(
+  const double **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name
+  )
+{
+  SZ_AS_READER(ctx, return)
+    ->read_array_view(
+      (const void **)out,
+      length,
+      SZ_DOUBLE_CHUNK,
+      sizeof(**out),
+      name
+      );
+}
+
+
+sz_response_t
+sz_read_int64s_view(
+  const int64_t **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name
+  )
+{
+  SZ_AS_READER(ctx, return)
+    ->read_array_view(
+      (const void **)out,
+      length,
+      SZ_SINT64_CHUNK,
+      sizeof(**out),
+      name
+      );
+}
+
+
+sz_response_t
+sz_read_uint64s_view(
+  const uint64_t **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name
+  )
+{
+  SZ_AS_READER(ctx, return)
+    ->read_array_view(
+      (const void **)out,
+      length,
+      SZ_UINT64_CHUNK,
+      sizeof(**out),
+      name
+      );
+}
+
+
+sz_response_t
+sz_read_int16s_view(
+  const int16_t **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name
+  )
+{
+  SZ_AS_READER(ctx, return)
+    ->read_array_view(
+      (const void **)out,
+      length,
+      SZ_SINT16_CHUNK,
+      sizeof(**out),
+      name
+      );
+}
+
+
+sz_response_t
+sz_read_int8s_view(
+  const int8_t **out,
+  size_t *length,
+  sz_context_t *ctx,
+  uint32_t name
+  )
+{
+  SZ_AS_READER(ctx, return)
+    ->read_array_view(
+      (const void **)out,
+      length,
+      SZ_SINT8_CHUNK,
+      sizeof(**out),
+      name
+      );
+}
+
+
 SZ_DEF_END
 
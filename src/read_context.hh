@@ -29,10 +29,15 @@
 #include "bufstream.hh"
 #include "allocator_wrapper.hh"
 
+#include <cstring>
 #include <map>
 #include <vector>
 
 
+// Size of a read context's read-ahead buffer.
+#define SZ_READ_BUFFER_SIZE (16384)
+
+
 struct SZ_HIDDEN sz_read_context_t : public s_sz_context
 {
 private:
@@ -50,7 +55,29 @@ private:
 
   static const unpacked_compound_t default_unpacked_compound;
 
+  // An array being read in windows (see sz_begin_array).
+  struct window_t {
+    bool active;
+    size_t type_size;     // Size of the array's elements, 1 for bytes
+    uint64_t remaining;   // Number of elements not yet read
+    off_t pos;            // Position of the next element
+    off_t end;            // End of the array's chunk
+  };
+
+  static const window_t no_window;
+
+  // The data chunk or compound being read.
+  struct scope_t {
+    off_t index_offset;     // Position of the name index's first entry
+    uint32_t index_length;  // Number of name index entries, 0 if none
+    off_t body_offset;      // Position of the first field
+    off_t body_end;         // End of the chunk
+  };
+
   typedef std::vector<off_t, sz_cxx_allocator_t<off_t> > offsets_t;
+  typedef std::vector<uint32_t, sz_cxx_allocator_t<uint32_t> > names_t;
+  typedef std::vector<scope_t, sz_cxx_allocator_t<scope_t> > scopes_t;
+  typedef std::vector<uint8_t, sz_cxx_allocator_t<uint8_t> > bytes_t;
   typedef std::vector<
     unpacked_compound_t,
     sz_cxx_allocator_t<unpacked_compound_t>
@@ -58,11 +85,110 @@ private:
 
   compounds_t compounds;
   offsets_t offsets;
+  window_t window;
+  // The snowball's name table, if it uses compact headers.
+  names_t names;
+  scopes_t scopes;
+  // Encoded array payloads are read into this when they aren't already in
+  // memory. Kept between arrays.
+  bytes_t encoded;
 
   // I can't track whether the context is open by whether something exists, so
   // just keep a flag I can set/unset...
   bool is_open;
 
+  // Read-ahead buffer. Reads are served from here and the buffer is refilled
+  // from the stream SZ_READ_BUFFER_SIZE bytes at a time, so small reads and
+  // short seeks don't touch the stream at all. buffer_origin is the stream
+  // offset of buffer[0], and the stream itself is always left at
+  // buffer_origin + buffer_length.
+  //
+  // Reads go through data, which is normally buffer. For memory-backed streams
+  // (see sz_stream_memory), data points at the stream's memory instead and
+  // buffer_length covers the rest of the stream, so reads and seeks are plain
+  // pointer arithmetic and never call into the stream.
+  uint8_t *buffer;
+  const uint8_t *data;
+  size_t buffer_capacity;
+  size_t buffer_length;
+  size_t buffer_pos;
+  off_t buffer_origin;
+  // Whether data holds the whole snowball (see SZ_PRELOAD), so it's never
+  // refilled and can be viewed directly.
+  bool preloaded;
+
+  size_t
+  refill_read(void *out, size_t length);
+
+  // Called right after reading the root with the root still buffered. Reads
+  // the rest of the snowball, size bytes in all, into the buffer.
+  sz_response_t
+  preload(uint64_t size);
+
+  // Format version of the snowball being read, from its root's magic number.
+  // Versions before 3 use 32-bit chunk sizes and compound offsets.
+  int format_version;
+
+  // sz_root_t::flags of the snowball being read.
+  uint32_t root_flags;
+
+  // Alignment of array and bytes payloads, from the root flags.
+  uint64_t payload_alignment;
+
+  // Whether the snowball's byte order differs from the host's, so everything
+  // read from it has to be swapped.
+  bool swap_bytes;
+
+  // Stream offset of the end of the last chunk whose header was read. Payload
+  // sizes are taken from this rather than from the header size, since that
+  // depends on the format version.
+  off_t chunk_end;
+
+  // Reads a chunk size or compound offset, which is 32 or 64 bits depending on
+  // the format version. Returns false on success, true on failure.
+  bool
+  read_size(uint64_t *out);
+
+  // Skips the padding ahead of an array or bytes payload, if any, and extends
+  // chunk_end to account for it.
+  void
+  skip_padding();
+
+  // Reads a varint one byte at a time. Returns false on success, true on
+  // failure.
+  bool
+  read_varint(uint64_t *out);
+
+  // Reads a compact chunk header (see SZ_ROOT_COMPACT_HEADERS). The header's
+  // size is set to the full size of the chunk, as with other headers.
+  sz_response_t
+  read_compact_header(sz_header_t *header);
+
+  // Reads a chunk header in whichever encoding the snowball uses and sets
+  // chunk_end. Doesn't check the header.
+  sz_response_t
+  read_any_header(sz_header_t *header);
+
+  // Reads and decodes the body of an encoded array (see sz_array_encoding_t).
+  // Otherwise the same as read_array_body.
+  sz_response_t
+  read_encoded_array_body(
+    void **buf_out,
+    const sz_array_t *chunk,
+    sz_allocator_t *alloc
+    );
+
+  // Called after reading a data or compound chunk's header. Reads the chunk's
+  // name index, if it has one, and makes the chunk the current scope.
+  sz_response_t
+  enter_scope();
+
+  // Looks up name in the current scope's name index and seeks to the first
+  // field with that name at or after from, or the first field with that name
+  // if there are none after from.
+  sz_response_t
+  seek_field(uint32_t name, off_t from);
+
 public:
 
   virtual
@@ -107,6 +233,63 @@ public:
     );
 
 
+  bool
+  swapping() const
+  {
+    return swap_bytes;
+  }
+
+  // Returns the allocator for a buffer returned by a read, given the one
+  // passed to the read op (see sz_set_buffer_allocator).
+  sz_allocator_t *
+  output_allocator(sz_allocator_t *alloc) const
+  {
+    return alloc ? alloc : buffer_alloc;
+  }
+
+
+  // Buffered stream access
+  // Reads length bytes from the stream into out, returning the number read.
+  size_t
+  buffered_read(void *out, size_t length)
+  {
+    if (length <= buffer_length - buffer_pos) {
+      memcpy(out, data + buffer_pos, length);
+      buffer_pos += length;
+      return length;
+    }
+    return refill_read(out, length);
+  }
+
+  // Returns the logical position of the context in its stream.
+  off_t
+  buffered_tell() const
+  {
+    return buffer_origin + off_t(buffer_pos);
+  }
+
+  // Seeks to an absolute offset in the stream. Seeks landing in the buffer
+  // don't touch the stream.
+  void
+  buffered_seek(off_t off)
+  {
+    if (off >= buffer_origin && off <= buffer_origin + off_t(buffer_length)) {
+      buffer_pos = size_t(off - buffer_origin);
+    } else {
+      discard_buffer(off);
+    }
+  }
+
+  // Seeks the stream to off and empties the buffer.
+  void
+  discard_buffer(off_t off);
+
+  // Returns a view of the next length bytes of the stream (see
+  // sz_stream_view), or NULL if the stream can't provide one.
+  const void *
+  buffered_view(size_t length);
+
+
   // Info stack
   void
   push_stack();
@@ -170,6 +353,35 @@ public:
     sz_allocator_t *buf_alloc
     );
 
+
+  // Views
+  sz_response_t
+  read_array_view(
+    const void **out,
+    size_t *length,
+    sz_chunk_id_t type,
+    size_t type_size,
+    uint32_t name
+    );
+
+  sz_response_t
+  read_bytes_view(
+    const void **out,
+    size_t *length,
+    uint32_t name
+    );
+
+
+  // Windowed arrays
+  sz_response_t
+  begin_array(sz_chunk_id_t type, uint32_t name, size_t *length);
+
+  sz_response_t
+  read_array_window(void *out, size_t capacity, size_t *count);
+
+  sz_response_t
+  end_array();
+
   // Reading
   sz_response_t
   begin_read();
@@ -187,6 +399,10 @@ public:
   sz_response_t
   close();
 
+  virtual
+  sz_response_t
+  reset();
+
   virtual
   bool
   opened() const;
@@ -48,6 +48,31 @@ sz_stream_write(const void *in, size_t length, sz_stream_t *stream)
 }
 
 
+size_t
+sz_stream_writev(const sz_iovec_t *iov, size_t count, sz_stream_t *stream)
+{
+  if (stream == NULL) {
+    return 0;
+  } else if (stream->writev) {
+    return stream->writev(iov, count, stream);
+  }
+
+  size_t total = 0;
+  for (size_t index = 0; index < count; ++index) {
+    const size_t length = iov[index].length;
+    const size_t written =
+      length ? stream->write(iov[index].base, length, stream) : 0;
+
+    total += written;
+    if (written != length) {
+      break;
+    }
+  }
+
+  return total;
+}
+
+
 off_t
 sz_stream_seek(off_t off, int whence, sz_stream_t *stream)
 {
@@ -66,6 +91,17 @@ sz_stream_tell(sz_stream_t *stream)
 }
 
 
+const void *
+sz_stream_view(size_t length, sz_stream_t *stream)
+{
+  if (stream && stream->view) {
+    return stream->view(length, stream);
+  } else {
+    return NULL;
+  }
+}
+
+
 int
 sz_stream_eof(sz_stream_t *stream)
 {
@@ -58,6 +58,16 @@
   } while(0)
 
 
+// Workers of a parallel write can only be written to.
+#define SZ_RETURN_IF_WORKER                                   \
+  do {                                                        \
+    if (parent) {                                             \
+      error = sz_errstr_worker_context;                       \
+      return SZ_ERROR_INVALID_OPERATION;                      \
+    }                                                         \
+  } while(0)
+
+
 #define SZ_AS_WRITER(CTX, PREFIX)                             \
   SZ_RETURN_IF_ERROR(sz_check_context((CTX), SZ_WRITER));     \
   PREFIX (static_cast<sz_write_context_t *>((CTX)))
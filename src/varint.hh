@@ -0,0 +1,96 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+#ifndef __VARINT_HH__
+#define __VARINT_HH__
+
+
+#include <snowball.h>
+
+
+// Maximum encoded length of a 64-bit varint.
+#define SZ_VARINT_MAX_LENGTH (10)
+// Maximum encoded length of a 32-bit varint.
+#define SZ_VARINT32_MAX_LENGTH (5)
+
+
+// Encodes value as a little-endian base-128 varint to out, which must have
+// room for SZ_VARINT_MAX_LENGTH bytes. Returns the number of bytes written.
+inline
+size_t
+sz_varint_encode(uint64_t value, uint8_t *out)
+{
+  size_t length = 0;
+
+  while (value >= 0x80) {
+    out[length++] = uint8_t(value | 0x80);
+    value >>= 7;
+  }
+
+  out[length++] = uint8_t(value);
+  return length;
+}
+
+
+// Encodes value as a varint padded with continuation bytes to exactly length
+// bytes, which must be enough to hold it, so it can be rewritten in place
+// later. It decodes like any other varint.
+inline
+void
+sz_varint_encode_padded(uint64_t value, uint8_t *out, size_t length)
+{
+  for (size_t index = 0; index + 1 < length; ++index) {
+    out[index] = uint8_t(value | 0x80);
+    value >>= 7;
+  }
+
+  out[length - 1] = uint8_t(value);
+}
+
+
+// Decodes a varint from the bytes in [in, end). Returns the number of bytes
+// read, or 0 if the varint is truncated or longer than SZ_VARINT_MAX_LENGTH.
+inline
+size_t
+sz_varint_decode(const uint8_t *in, const uint8_t *end, uint64_t *out)
+{
+  uint64_t value = 0;
+  size_t length = 0;
+  int shift = 0;
+
+  while (in + length < end && length < SZ_VARINT_MAX_LENGTH) {
+    const uint8_t byte = in[length++];
+    value |= uint64_t(byte & 0x7F) << shift;
+
+    if ((byte & 0x80) == 0) {
+      *out = value;
+      return length;
+    }
+
+    shift += 7;
+  }
+
+  return 0;
+}
+
+
+#endif /* end __VARINT_HH__ include guard */
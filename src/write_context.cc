@@ -24,13 +24,25 @@
 #include "error_strings.hh"
 #include "utilities.hh"
 #include "bufstream.hh"
+#include "varint.hh"
+#include "array_codec.hh"
 
+#include <algorithm>
 
-sz_write_context_t::void_comp_t sz_write_context_t::void_comp;
 
+// Source of the zero bytes written as alignment padding.
+static const uint8_t sz_zero_padding[SZ_MAX_ALIGNMENT] = { 0 };
 
-// Writes an arbitrary type val to a stream and returns false on success, or
-// true on failure. Should only be used for small-ish POD types.
+
+// Largest encoded chunk header: 16 bytes for regular headers, and for compact
+// headers a kind byte, a name of at most 5 bytes, and a size of at most 10.
+#define SZ_MAX_HEADER_SIZE (16)
+
+
+// Writes an arbitrary type val to a buffer stream and returns false on
+// success, or true on failure. Should only be used for small-ish POD types.
+// All of a writer's chunks go to in-memory buffer streams, so this writes to
+// the buffer directly rather than through the stream's write function.
 // For those wondering why false is the successful case, it's so you can just
 // do `if (write) then_error;`
 template <typename T>
@@ -38,109 +50,53 @@ SZ_HIDDEN
 bool
 sz_write_prim(sz_stream_t *stream, T val)
 {
-#if SZ_ENDIANNESS != SZ_BASE_ENDIANNESS
-  T reversed;
-  uint8_t *out = (uint8_t *)&reversed;
-  const uint8_t *in = (const uint8_t *)&val;
-  for (size_t i = 0; i < sizeof(T); ++i) {
-    out[(sizeof(T) - 1) - i] = in[i];
-  }
-  return sz_stream_write(&reversed, sizeof(reversed), stream) != sizeof(reversed);
-#else
-  return sz_stream_write(&val, sizeof(val), stream) != sizeof(val);
-#endif
-}
-
-
-#if SZ_ENDIANNESS != SZ_BASE_ENDIANNESS
-
-// Specializations for non-little-endian systems.
-
-template <>
-SZ_HIDDEN
-bool
-sz_write_prim<float>(sz_stream_t *stream, float val)
-{
-  uint32_t cv = sz_ntohl(*(const uint32_t *)&val);
-  return sz_stream_write(&cv, sizeof(cv), stream) != sizeof(cv);
-}
-
-
-template <>
-SZ_HIDDEN
-bool
-sz_write_prim<uint8_t>(sz_stream_t *stream, uint8_t val)
-{
-  return sz_stream_write(&val, sizeof(val), stream) != sizeof(val);
-}
-
-
-template <>
-SZ_HIDDEN
-bool
-sz_write_prim<int8_t>(sz_stream_t *stream, int8_t val)
-{
-  return sz_stream_write(&val, sizeof(val), stream) != sizeof(val);
-}
-
-
-template <>
-SZ_HIDDEN
-bool
-sz_write_prim<int32_t>(sz_stream_t *stream, int32_t val)
-{
-  uint32_t cv = sz_ntohl(*(const uint32_t *)&val);
-  return sz_stream_write(&cv, sizeof(cv), stream) != sizeof(cv);
+  uint8_t encoded[sizeof(T)];
+  sz_encode_prim(encoded, val);
+  return sz_buffer_stream_write(encoded, sizeof(encoded), stream) != sizeof(encoded);
 }
 
 
-template <>
-SZ_HIDDEN
-bool
-sz_write_prim<uint32_t>(sz_stream_t *stream, uint32_t val)
-{
-  val = sz_ntohl(val);
-  return sz_stream_write(&val, sizeof(val), stream) != sizeof(val);
-}
-
-
-template <>
-SZ_HIDDEN
-bool
-sz_write_prim<int16_t>(sz_stream_t *stream, int16_t val)
-{
-  uint16_t cv = sz_ntohs(*(const uint16_t *)&val);
-  return sz_stream_write(&cv, sizeof(cv), stream) != sizeof(cv);
-}
-
-
-template <>
-SZ_HIDDEN
-bool
-sz_write_prim<uint16_t>(sz_stream_t *stream, uint16_t val)
-{
-  val = sz_ntohs(val);
-  return sz_stream_write(&val, sizeof(val), stream) != sizeof(val);
-}
-
-#endif
-
-
 sz_write_context_t::sz_write_context_t(sz_allocator_t *alloc)
 : s_sz_context(alloc)
 , bufstream(NULL)
 , active(NULL)
+, headstream(NULL)
 , streams(stream_stack_alloc_t(alloc))
+, compound_stack(sz_cxx_allocator_t<uint32_t>(alloc))
 , compound_streams(stream_stack_alloc_t(alloc))
-, compound_indices(void_comp, compound_map_alloc_t(alloc))
+, compound_indices(alloc)
+, spare_streams(stream_stack_alloc_t(alloc))
+, compound_offsets(sz_cxx_allocator_t<uint64_t>(alloc))
+, compounds_size(0)
+, names(sz_cxx_allocator_t<uint32_t>(alloc))
+, name_indices(sz_cxx_allocator_t<name_entry_t>(alloc))
+, compound_refs(sz_cxx_allocator_t<uint32_t>(alloc))
+, encoded(sz_cxx_allocator_t<uint8_t>(alloc))
+, field_indices(sz_cxx_allocator_t<field_index_t>(alloc))
+, field_index_count(0)
+, spare_field_indices(sz_cxx_allocator_t<field_index_t>(alloc))
+, flush_iov(sz_cxx_allocator_t<sz_iovec_t>(alloc))
+, head_offsets(sz_cxx_allocator_t<uint64_t>(alloc))
+, chunk_offsets(sz_cxx_allocator_t<uint64_t>(alloc))
+, parent(NULL)
+, workers(workers_alloc_t(alloc))
+, tasks(sz_cxx_allocator_t<parallel_task_t>(alloc))
+, next_task(0)
+, task_writer(NULL)
+, task_writer_ctx(NULL)
+, local_compounds(sz_cxx_allocator_t<void *>(alloc))
+, final_indices(sz_cxx_allocator_t<uint32_t>(alloc))
+, ref_patches(sz_cxx_allocator_t<ref_patch_t>(alloc))
+, name_patches(sz_cxx_allocator_t<name_patch_t>(alloc))
 {
-  /* nop */
+  pthread_mutex_init(&shared_lock, NULL);
 }
 
 
 sz_write_context_t::~sz_write_context_t()
 {
   cleanup();
+  pthread_mutex_destroy(&shared_lock);
 }
 
 
@@ -154,7 +110,7 @@ sz_write_context_t::mode() const
 sz_response_t
 sz_write_context_t::open()
 {
-  if (active || bufstream) {
+  if (opened()) {
     error = sz_errstr_already_open;
     return SZ_ERROR_CONTEXT_OPEN;
   } else if (stream == NULL) {
@@ -162,7 +118,51 @@ sz_write_context_t::open()
     return SZ_ERROR_INVALID_STREAM;
   }
 
-  active = bufstream = sz_buffer_stream(SZ_WRITER, ctx_alloc);
+  // Buffers kept from a previous snowball are reused.
+  if (bufstream == NULL) {
+    bufstream = sz_buffer_stream(SZ_WRITER, ctx_alloc);
+  }
+
+  if (headstream == NULL) {
+    headstream = sz_buffer_stream(SZ_WRITER, ctx_alloc);
+  }
+
+  if (bufstream == NULL || headstream == NULL) {
+    cleanup();
+    error = sz_errstr_nomem;
+    return SZ_ERROR_OUT_OF_MEMORY;
+  }
+
+  active = bufstream;
+  compounds_size = 0;
+
+  if (indexing()) {
+    add_field_index();
+  }
+
+  if (streaming()) {
+    // Reserve space for the root, which is written once everything else is.
+    // Left zeroed until then so a partial snowball can't pass for a whole one.
+    const sz_root_t placeholder = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    sz_response_t response = SZ_SUCCESS;
+
+    stream_pos = sz_stream_tell(stream);
+    response = write_root(placeholder, headstream);
+
+    if (response == SZ_SUCCESS) {
+      size_t root_size = 0;
+      const void *root_data = sz_buffer_stream_data(headstream, &root_size);
+      if (sz_stream_write(root_data, root_size, stream) != root_size) {
+        response = file_error();
+      }
+    }
+
+    if (response != SZ_SUCCESS) {
+      recycle();
+      return response;
+    }
+  }
+
   return SZ_SUCCESS;
 }
 
@@ -170,106 +170,326 @@ sz_write_context_t::open()
 sz_response_t
 sz_write_context_t::flush()
 {
-  typedef std::vector<
-    sz_bufstring_t,
-    sz_cxx_allocator_t<sz_bufstring_t>
-    > compound_buffers_t;
-
   sz_root_t root = {
     SZ_MAGIC,
+    root_flags(),
     0,
     uint32_t(compound_streams.size()),
-    uint32_t(sizeof(root)),
-    ~0U,
-    ~0U
+    0,
+    uint64_t(sizeof(root)),
+    ~uint64_t(0),
+    ~uint64_t(0)
   };
 
-  const sz_bufstring_t main_buf = sz_buffer_stream_data(bufstream);
-  const size_t data_size = main_buf.size();
+  sz_response_t response = SZ_SUCCESS;
+  size_t data_size = 0;
+  const void *main_buf = sz_buffer_stream_data(bufstream, &data_size);
+
+  const uint64_t mappings_size =
+    root.num_compounds * uint64_t(sizeof(uint64_t));
+
+  // The chunk headers, root, mappings, and name table are encoded into their
+  // own buffer, then written along with the compound and data buffers as one
+  // vectored write. Chunk headers are encoded first, since their sizes aren't
+  // fixed and the root's offsets depend on them. head_offsets holds where each
+  // header starts in that buffer, plus where the last one ends.
+  sz_stream_t *heads = headstream;
+  iovecs_t &iov = flush_iov;
+  size_t heads_size = 0;
+  size_t total_size = 0;
+  const uint8_t *heads_data = NULL;
+  uint64_t relative_offset = 0;
+
+  if (streaming()) {
+    return flush_streaming();
+  }
 
-  uint32_t compounds_size = 0;
-  const uint32_t mappings_size =
-    root.num_compounds * uint32_t(sizeof(uint32_t));
+  sz_buffer_stream_reset(heads);
+  iov.clear();
+  head_offsets.clear();
+  chunk_offsets.clear();
+  head_offsets.reserve(root.num_compounds + 2);
+  head_offsets.push_back(0);
 
-  // Grab all compound buffers and their combined size
-  compound_buffers_t compound_buffers(
-    (sz_cxx_allocator_t<sz_bufstring_t>(ctx_alloc))
-    );
+  // Encode compound headers
+  for (uint32_t index = 0; index < root.num_compounds; ++index) {
+    size_t cmp_size = 0;
+    sz_buffer_stream_data(compound_streams[index], &cmp_size);
 
-  #if __cplusplus >= 201103L
-  for (sz_stream_t *cmp_stream : compound_streams) {
-  #else
-  stream_stack_t::iterator iter = compound_streams.begin();
-  const stream_stack_t::iterator end = compound_streams.end();
-  for (; iter != end; ++iter) {
-    sz_stream_t *cmp_stream = *iter;
-  #endif
-    compound_buffers.push_back(sz_buffer_stream_data(cmp_stream));
-    compounds_size += compound_buffers.back().size() + sizeof(sz_header_t);
+    const sz_header_t compound_head = {
+      SZ_COMPOUND_CHUNK,
+      index + 1,
+      uint64_t(sizeof(compound_head) + cmp_size) + field_index_size(index + 1)
+    };
+
+    SZ_JUMP_IF_ERROR(
+      write_header(compound_head, heads),
+      response,
+      sz_flush_done
+      );
+    SZ_JUMP_IF_ERROR(
+      write_field_index(index + 1, heads),
+      response,
+      sz_flush_done
+      );
+
+    sz_buffer_stream_data(heads, &heads_size);
+    head_offsets.push_back(heads_size);
   }
 
-  root.compounds_offset = root.mappings_offset + mappings_size;
-  root.data_offset = root.compounds_offset + compounds_size;
-  root.size = root.data_offset + data_size;
+  {
+    const sz_header_t data_head = {
+      SZ_DATA_CHUNK,
+      SZ_DATA_NAME,
+      uint64_t(sizeof(data_head) + data_size) + field_index_size(0)
+    };
+    SZ_JUMP_IF_ERROR( write_header(data_head, heads), response, sz_flush_done );
+    SZ_JUMP_IF_ERROR( write_field_index(0, heads), response, sz_flush_done );
 
-  // Write the file root
-  SZ_RETURN_IF_ERROR( write_root(root) );
+    sz_buffer_stream_data(heads, &heads_size);
+    head_offsets.push_back(heads_size);
+  }
 
-  // Write the mappings table
-  // Offset relative to the beginning of the compounds table
-  uint32_t relative_offset = 0;
-  #if __cplusplus >= 201103L
-  for (const sz_bufstring_t &buf : compound_buffers) {
-  #else
-  compound_buffers_t::iterator cmpbuf_iter = compound_buffers.begin();
-  compound_buffers_t::iterator cmpbuf_end = compound_buffers.end();
-  for (; cmpbuf_iter != cmpbuf_end; ++cmpbuf_iter) {
-    const sz_bufstring_t &buf = *cmpbuf_iter;
-  #endif
-    if (sz_write_prim(stream, relative_offset)) {
-      return file_error();
+  root.compounds_offset = root.mappings_offset + mappings_size + names_size();
+
+  // Lay out the compound and data chunks, padding ahead of each one so its
+  // body is aligned.
+  chunk_offsets.reserve(root.num_compounds + 1);
+  for (uint32_t index = 0; index <= root.num_compounds; ++index) {
+    const uint64_t head_size = head_offsets[index + 1] - head_offsets[index];
+    size_t body_size = data_size;
+
+    if (index < root.num_compounds) {
+      sz_buffer_stream_data(compound_streams[index], &body_size);
     }
-    relative_offset += uint32_t(sizeof(sz_header_t) + buf.size());
+
+    relative_offset += sz_padding(
+      root.compounds_offset + relative_offset + head_size,
+      alignment
+      );
+    chunk_offsets.push_back(relative_offset);
+    relative_offset += head_size + body_size;
   }
 
-  // Write compounds
-  uint32_t compound_index = 0;
-  #if __cplusplus >= 201103L
-  for (const sz_bufstring_t &buf : compound_buffers) {
-  #else
-  cmpbuf_iter = compound_buffers.begin();
-  cmpbuf_end = compound_buffers.end();
-  for (; cmpbuf_iter != cmpbuf_end; ++cmpbuf_iter) {
-    const sz_bufstring_t &buf = *cmpbuf_iter;
-  #endif
-    const size_t write_size = buf.size();
-    sz_header_t compound_head = {
-      SZ_COMPOUND_CHUNK,
-      compound_index + 1,
-      uint32_t(sizeof(compound_head) + write_size)
+  root.data_offset = root.compounds_offset + chunk_offsets.back();
+  root.size = root.compounds_offset + relative_offset;
+
+  // Encode the file root
+  SZ_JUMP_IF_ERROR( write_root(root, heads), response, sz_flush_done );
+
+  // Encode the mappings table
+  for (uint32_t index = 0; index < root.num_compounds; ++index) {
+    if (sz_write_prim(heads, chunk_offsets[index])) {
+      response = file_error();
+      goto sz_flush_done;
+    }
+  }
+
+  // Encode the name table
+  SZ_JUMP_IF_ERROR( write_names(heads), response, sz_flush_done );
+
+  // Gather everything in file order: root, mappings, and names, each
+  // compound's padding, header (and name index), and body, then the data
+  // chunk's padding, header, and main data.
+  heads_data = (const uint8_t *)sz_buffer_stream_data(heads, &heads_size);
+  iov.reserve(3 * compound_streams.size() + 4);
+  relative_offset = 0;
+
+  {
+    const size_t root_start = size_t(head_offsets.back());
+    const sz_iovec_t root_vec = {
+      heads_data + root_start,
+      heads_size - root_start
     };
+    iov.push_back(root_vec);
+  }
 
-    SZ_RETURN_IF_ERROR( write_header(compound_head, stream) );
+  for (uint32_t index = 0; index <= root.num_compounds; ++index) {
+    const bool is_data = index == root.num_compounds;
+    size_t body_size = 0;
+    const void *body =
+      is_data
+      ? main_buf
+      : sz_buffer_stream_data(compound_streams[index], &body_size);
 
-    if (sz_stream_write(buf.data(), write_size, stream) != write_size) {
-      return file_error();
+    if (is_data) {
+      body_size = data_size;
+    }
+
+    const sz_iovec_t pad_vec = {
+      sz_zero_padding,
+      size_t(chunk_offsets[index] - relative_offset)
+    };
+    const sz_iovec_t head_vec = {
+      heads_data + head_offsets[index],
+      size_t(head_offsets[index + 1] - head_offsets[index])
+    };
+    const sz_iovec_t body_vec = { body, body_size };
+
+    if (pad_vec.length) {
+      iov.push_back(pad_vec);
+    }
+    iov.push_back(head_vec);
+    if (body_size) {
+      iov.push_back(body_vec);
     }
-    ++compound_index;
+
+    relative_offset = chunk_offsets[index] + head_vec.length + body_size;
+  }
+
+  total_size = size_t(root.size);
+  if (sz_stream_writev(&iov[0], iov.size(), stream) != total_size) {
+    response = file_error();
   }
 
-  sz_header_t data_head = {
+sz_flush_done:
+  return response;
+}
+
+
+sz_response_t
+sz_write_context_t::emit_compound(uint32_t index)
+{
+  sz_stream_t *cmp_stream = compound_streams[index - 1];
+  size_t body_size = 0;
+  size_t head_size = 0;
+  const void *body = sz_buffer_stream_data(cmp_stream, &body_size);
+  const sz_header_t compound_head = {
+    SZ_COMPOUND_CHUNK,
+    index,
+    uint64_t(sizeof(compound_head) + body_size) + field_index_size(index)
+  };
+
+  sz_buffer_stream_reset(headstream);
+  SZ_RETURN_IF_ERROR( write_header(compound_head, headstream) );
+  SZ_RETURN_IF_ERROR( write_field_index(index, headstream) );
+
+  const void *head = sz_buffer_stream_data(headstream, &head_size);
+  // Compounds are written right after the root and each other, so pad ahead
+  // of this one to align its body.
+  const size_t pad_size = size_t(sz_padding(
+    sizeof(sz_root_t) + compounds_size + head_size,
+    alignment
+    ));
+  const sz_iovec_t iov[3] = {
+    { sz_zero_padding, pad_size },
+    { head, head_size },
+    { body, body_size }
+  };
+
+  if (sz_stream_writev(iov, 3, stream) != pad_size + head_size + body_size) {
+    return file_error();
+  }
+
+  compound_offsets[index - 1] = compounds_size + pad_size;
+  compounds_size += uint64_t(pad_size + head_size + body_size);
+
+  // The compound's done, so its buffer can go to the next one.
+  sz_buffer_stream_reset(cmp_stream);
+  spare_streams.push_back(cmp_stream);
+  compound_streams[index - 1] = NULL;
+
+  // Its field index is done too, so its storage can go to the next one, which
+  // keeps the memory held by field indices bounded by the compounds in flight.
+  if (indexing()) {
+    spare_field_indices.push_back(
+      field_index_t(sz_cxx_allocator_t<field_t>(ctx_alloc))
+      );
+    spare_field_indices.back().swap(field_indices[index]);
+    spare_field_indices.back().clear();
+  }
+
+  return SZ_SUCCESS;
+}
+
+
+sz_response_t
+sz_write_context_t::flush_streaming()
+{
+  // Streamed snowballs are laid out as root, compounds (in the order they were
+  // completed), data, then mappings and names. Readers only go by the root's
+  // offsets, so the order doesn't matter to them.
+  size_t data_size = 0;
+  size_t data_head_size = 0;
+  size_t heads_size = 0;
+  const void *main_buf = sz_buffer_stream_data(bufstream, &data_size);
+  const uint32_t num_compounds = uint32_t(compound_offsets.size());
+  const uint64_t root_size = uint64_t(sizeof(sz_root_t));
+  sz_root_t root = {
+    SZ_MAGIC,
+    root_flags(),
+    0,
+    num_compounds,
+    0,
+    0,
+    root_size,
+    root_size + compounds_size
+  };
+
+  const sz_header_t data_head = {
     SZ_DATA_CHUNK,
     SZ_DATA_NAME,
-    uint32_t(sizeof(data_head) + data_size)
+    uint64_t(sizeof(data_head) + data_size) + field_index_size(0)
   };
-  SZ_RETURN_IF_ERROR( write_header(data_head, stream) );
 
-  // Write the main data
-  if (   data_size
-      && sz_stream_write(main_buf.data(), data_size, stream) != data_size) {
+  sz_buffer_stream_reset(headstream);
+  SZ_RETURN_IF_ERROR( write_header(data_head, headstream) );
+  SZ_RETURN_IF_ERROR( write_field_index(0, headstream) );
+  sz_buffer_stream_data(headstream, &data_head_size);
+
+  for (uint32_t index = 0; index < num_compounds; ++index) {
+    if (sz_write_prim(headstream, compound_offsets[index])) {
+      return file_error();
+    }
+  }
+
+  SZ_RETURN_IF_ERROR( write_names(headstream) );
+
+  const uint8_t *heads_data =
+    (const uint8_t *)sz_buffer_stream_data(headstream, &heads_size);
+  const size_t pad_size = size_t(sz_padding(
+    root.data_offset + data_head_size,
+    alignment
+    ));
+  const sz_iovec_t iov[4] = {
+    { sz_zero_padding, pad_size },
+    { heads_data, data_head_size },
+    { main_buf, data_size },
+    { heads_data + data_head_size, heads_size - data_head_size }
+  };
+
+  root.data_offset += pad_size;
+  root.mappings_offset = root.data_offset + uint64_t(data_head_size + data_size);
+  root.size = root.data_offset + uint64_t(heads_size + data_size);
+
+  if (sz_stream_writev(iov, 4, stream) != pad_size + heads_size + data_size) {
+    return file_error();
+  }
+
+  // Go back and fill in the root.
+  const off_t end_pos = stream_pos + off_t(root.size);
+  size_t root_encoded_size = 0;
+
+  sz_buffer_stream_reset(headstream);
+  SZ_RETURN_IF_ERROR( write_root(root, headstream) );
+
+  const void *root_data =
+    sz_buffer_stream_data(headstream, &root_encoded_size);
+
+  if (sz_stream_seek(stream_pos, SEEK_SET, stream) != stream_pos) {
+    error = sz_errstr_cannot_seek;
+    return SZ_ERROR_INVALID_STREAM;
+  }
+
+  if (sz_stream_write(root_data, root_encoded_size, stream) != root_encoded_size) {
     return file_error();
   }
 
+  if (sz_stream_seek(end_pos, SEEK_SET, stream) != end_pos) {
+    error = sz_errstr_cannot_seek;
+    return SZ_ERROR_INVALID_STREAM;
+  }
+
   return SZ_SUCCESS;
 }
 
@@ -277,16 +497,70 @@ sz_write_context_t::flush()
 sz_response_t
 sz_write_context_t::close()
 {
+  SZ_RETURN_IF_WORKER;
   SZ_RETURN_IF_CLOSED;
 
   SZ_RETURN_IF_ERROR( flush() );
 
-  cleanup();
+  recycle();
 
   return SZ_SUCCESS;
 }
 
 
+sz_response_t
+sz_write_context_t::reset()
+{
+  SZ_RETURN_IF_WORKER;
+
+  // Anything written so far is dropped without being flushed.
+  recycle();
+  return s_sz_context::reset();
+}
+
+
+void
+sz_write_context_t::recycle()
+{
+  // Only the contents of the buffers and tables are dropped -- their memory is
+  // kept for the next snowball.
+  if (bufstream) {
+    sz_buffer_stream_reset(bufstream);
+  }
+
+  if (headstream) {
+    sz_buffer_stream_reset(headstream);
+  }
+
+  active = NULL;
+
+  #if __cplusplus >= 201103L
+  for (sz_stream_t *cmp_stream : compound_streams) {
+  #else
+  stream_stack_t::iterator iter = compound_streams.begin();
+  const stream_stack_t::iterator end = compound_streams.end();
+  for (; iter != end; ++iter) {
+    sz_stream_t *cmp_stream = *iter;
+  #endif
+    // Streamed compounds' buffers are already spares.
+    if (cmp_stream) {
+      sz_buffer_stream_reset(cmp_stream);
+      spare_streams.push_back(cmp_stream);
+    }
+  }
+
+  compound_indices.clear();
+  compound_streams.clear();
+  compound_offsets.clear();
+  names.clear();
+  name_indices.clear();
+  field_index_count = 0;
+  compound_stack.clear();
+  compound_refs.clear();
+  streams.clear();
+}
+
+
 void
 sz_write_context_t::cleanup()
 {
@@ -295,6 +569,11 @@ sz_write_context_t::cleanup()
   }
   active = bufstream = NULL;
 
+  if (headstream) {
+    sz_stream_close(headstream);
+  }
+  headstream = NULL;
+
   #if __cplusplus >= 201103L
   for (sz_stream_t *cmp_stream : compound_streams) {
   #else
@@ -306,9 +585,63 @@ sz_write_context_t::cleanup()
     sz_stream_close(cmp_stream);
   }
 
+  #if __cplusplus >= 201103L
+  for (sz_stream_t *spare_stream : spare_streams) {
+  #else
+  iter = spare_streams.begin();
+  const stream_stack_t::iterator spare_end = spare_streams.end();
+  for (; iter != spare_end; ++iter) {
+    sz_stream_t *spare_stream = *iter;
+  #endif
+    sz_stream_close(spare_stream);
+  }
+
   compound_indices.clear();
   compound_streams.clear();
+  spare_streams.clear();
+  compound_offsets.clear();
+  names.clear();
+  name_indices.clear();
+  field_indices.clear();
+  field_index_count = 0;
+  spare_field_indices.clear();
+  compound_stack.clear();
+  compound_refs.clear();
   streams.clear();
+
+  #if __cplusplus >= 201103L
+  for (sz_write_context_t *worker : workers) {
+  #else
+  workers_t::iterator worker_iter = workers.begin();
+  const workers_t::iterator workers_end = workers.end();
+  for (; worker_iter != workers_end; ++worker_iter) {
+    sz_write_context_t *worker = *worker_iter;
+  #endif
+    worker->~sz_write_context_t();
+    sz_free(worker, ctx_alloc);
+  }
+
+  workers.clear();
+}
+
+
+void
+sz_write_context_t::add_field_index()
+{
+  if (field_index_count < field_indices.size()) {
+    field_indices[field_index_count].clear();
+  } else {
+    field_indices.push_back(field_index_t(sz_cxx_allocator_t<field_t>(ctx_alloc)));
+  }
+
+  // Indices emptied by streaming take storage from those of emitted compounds.
+  field_index_t &fields = field_indices[field_index_count];
+  if (fields.capacity() == 0 && !spare_field_indices.empty()) {
+    fields.swap(spare_field_indices.back());
+    spare_field_indices.pop_back();
+  }
+
+  ++field_index_count;
 }
 
 
@@ -316,6 +649,7 @@ void
 sz_write_context_t::push_stack()
 {
   streams.push_back(active);
+  compound_stack.push_back(uint32_t(compound_streams.size()));
   active = compound_streams.back();
 }
 
@@ -325,18 +659,183 @@ sz_write_context_t::pop_stack()
 {
   active = streams.back();
   streams.pop_back();
+  compound_stack.pop_back();
+}
+
+
+sz_response_t
+sz_write_context_t::write_root(const sz_root_t &root, sz_stream_t *stream_)
+{
+  // The magic number and flags are always little endian, so readers can tell
+  // the byte order of everything after them from the flags.
+  uint8_t head[2 * sizeof(uint32_t)];
+  sz_encode_le32(head, root.magic);
+  sz_encode_le32(head + sizeof(uint32_t), root.flags);
+
+  if (   sz_buffer_stream_write(head, sizeof(head), stream_) != sizeof(head)
+      || sz_write_prim(stream_, root.size)
+      || sz_write_prim(stream_, root.num_compounds)
+      || sz_write_prim(stream_, root.reserved)
+      || sz_write_prim(stream_, root.mappings_offset)
+      || sz_write_prim(stream_, root.compounds_offset)
+      || sz_write_prim(stream_, root.data_offset)) {
+    return file_error();
+  }
+
+  return SZ_SUCCESS;
+}
+
+
+uint32_t
+sz_write_context_t::root_flags() const
+{
+  uint32_t alignment_log2 = 0;
+  while ((1U << alignment_log2) < alignment) {
+    ++alignment_log2;
+  }
+
+  return
+    (compact() ? uint32_t(SZ_ROOT_COMPACT_HEADERS) : 0)
+    | (indexing() ? uint32_t(SZ_ROOT_NAME_INDEX) : 0)
+    | (sz_host_big_endian() ? uint32_t(SZ_ROOT_BIG_ENDIAN) : 0)
+    | (alignment_log2 << SZ_ROOT_ALIGNMENT_SHIFT);
+}
+
+
+uint32_t
+sz_write_context_t::intern_name(uint32_t name)
+{
+  // Indices are never less than 0, so this finds name's entry if it has one.
+  const name_map_t::iterator found = std::lower_bound(
+    name_indices.begin(),
+    name_indices.end(),
+    name_entry_t(name, 0)
+    );
+
+  if (found != name_indices.end() && found->first == name) {
+    return found->second;
+  }
+
+  const uint32_t index = uint32_t(names.size());
+
+  names.push_back(name);
+  name_indices.insert(found, name_entry_t(name, index));
+
+  return index;
+}
+
+
+uint64_t
+sz_write_context_t::names_size() const
+{
+  if (!compact()) {
+    return 0;
+  }
+
+  return uint64_t(sizeof(uint32_t)) * (names.size() + 1);
+}
+
+
+sz_response_t
+sz_write_context_t::write_names(sz_stream_t *stream_)
+{
+  if (!compact()) {
+    return SZ_SUCCESS;
+  }
+
+  if (sz_write_prim(stream_, uint32_t(names.size()))) {
+    return file_error();
+  }
+
+  #if __cplusplus >= 201103L
+  for (const uint32_t name : names) {
+  #else
+  names_t::const_iterator iter = names.begin();
+  const names_t::const_iterator end = names.end();
+  for (; iter != end; ++iter) {
+    const uint32_t name = *iter;
+  #endif
+    if (sz_write_prim(stream_, name)) {
+      return file_error();
+    }
+  }
+
+  return SZ_SUCCESS;
+}
+
+
+size_t
+sz_write_context_t::encode_header(const sz_header_t &header, uint8_t *out)
+{
+  size_t length = 0;
+
+  if (compact()) {
+    // Kind byte, name, then payload size -- see SZ_ROOT_COMPACT_HEADERS.
+    const bool plain_name =
+      header.kind == SZ_COMPOUND_CHUNK || header.kind == SZ_DATA_CHUNK;
+
+    out[length++] = uint8_t(header.kind);
+    if (plain_name) {
+      length += sz_varint_encode(header.name, out + length);
+    } else if (parent) {
+      length += encode_worker_name(header.name, length, out + length);
+    } else {
+      length += sz_varint_encode(intern_name(header.name), out + length);
+    }
+    length += sz_varint_encode(header.size - sizeof(sz_header_t), out + length);
+  } else {
+    length += sz_encode_prim(out + length, header.kind);
+    length += sz_encode_prim(out + length, header.name);
+    length += sz_encode_prim(out + length, header.size);
+  }
+
+  return length;
+}
+
+
+size_t
+sz_write_context_t::encode_array_header(const sz_array_t &header, uint8_t *out)
+{
+  size_t length = encode_header(header.base, out);
+  length += sz_encode_prim(out + length, header.length);
+  length += sz_encode_prim(out + length, header.type);
+  return length;
+}
+
+
+void
+sz_write_context_t::index_field(uint32_t name)
+{
+  if (indexing()) {
+    size_t offset = 0;
+    sz_buffer_stream_data(active, &offset);
+    field_indices[compound_stack.empty() ? 0 : compound_stack.back()].push_back(
+      field_t(name, uint64_t(offset))
+      );
+  }
 }
 
 
 sz_response_t
-sz_write_context_t::write_root(const sz_root_t &root)
+sz_write_context_t::write_chunk(
+  const uint8_t *prefix,
+  size_t prefix_length,
+  const void *payload,
+  size_t payload_length
+  )
 {
-  if (   sz_write_prim(stream, root.magic)
-      || sz_write_prim(stream, root.size)
-      || sz_write_prim(stream, root.num_compounds)
-      || sz_write_prim(stream, root.mappings_offset)
-      || sz_write_prim(stream, root.compounds_offset)
-      || sz_write_prim(stream, root.data_offset)) {
+  size_t offset = 0;
+  sz_buffer_stream_data(active, &offset);
+
+  const size_t pad_size = size_t(sz_padding(offset + prefix_length, alignment));
+  const size_t total_length = prefix_length + pad_size + payload_length;
+  const sz_iovec_t iov[3] = {
+    { prefix, prefix_length },
+    { sz_zero_padding, pad_size },
+    { payload, payload_length }
+  };
+
+  if (sz_buffer_stream_writev(iov, 3, active) != total_length) {
     return file_error();
   }
 
@@ -344,9 +843,55 @@ sz_write_context_t::write_root(const sz_root_t &root)
 }
 
 
+uint64_t
+sz_write_context_t::field_index_size(uint32_t compound) const
+{
+  if (!indexing()) {
+    return 0;
+  }
+
+  return
+    sizeof(uint32_t)
+    + uint64_t(SZ_NAME_INDEX_ENTRY_SIZE) * field_indices[compound].size();
+}
+
+
+sz_response_t
+sz_write_context_t::write_field_index(uint32_t compound, sz_stream_t *stream_)
+{
+  if (!indexing()) {
+    return SZ_SUCCESS;
+  }
+
+  field_index_t &fields = field_indices[compound];
+  std::sort(fields.begin(), fields.end());
+
+  if (sz_write_prim(stream_, uint32_t(fields.size()))) {
+    return file_error();
+  }
+
+  #if __cplusplus >= 201103L
+  for (const field_t &field : fields) {
+  #else
+  field_index_t::const_iterator iter = fields.begin();
+  const field_index_t::const_iterator end = fields.end();
+  for (; iter != end; ++iter) {
+    const field_t &field = *iter;
+  #endif
+    if (   sz_write_prim(stream_, field.first)
+        || sz_write_prim(stream_, field.second)) {
+      return file_error();
+    }
+  }
+
+  return SZ_SUCCESS;
+}
+
+
 sz_response_t
 sz_write_context_t::write_header(const sz_header_t &header)
 {
+  index_field(header.name);
   return write_header(header, active);
 }
 
@@ -354,9 +899,10 @@ sz_write_context_t::write_header(const sz_header_t &header)
 sz_response_t
 sz_write_context_t::write_header(const sz_header_t &header, sz_stream_t *stream_)
 {
-  if (   sz_write_prim(stream_, header.kind)
-      || sz_write_prim(stream_, header.name)
-      || sz_write_prim(stream_, header.size)) {
+  uint8_t encoded[SZ_MAX_HEADER_SIZE];
+  const size_t length = encode_header(header, encoded);
+
+  if (sz_buffer_stream_write(encoded, length, stream_) != length) {
     return file_error();
   }
 
@@ -377,24 +923,27 @@ sz_write_context_t::write_primitive(
   sz_header_t header = {
     type,
     name,
-    uint32_t(sizeof(sz_header_t) + type_size)
+    uint64_t(sizeof(sz_header_t) + type_size)
   };
 
-  SZ_RETURN_IF_ERROR( write_header(header) );
-
-  bool r = false;
+  // The header and value are encoded together and written at once.
+  uint8_t chunk[SZ_MAX_HEADER_SIZE + sizeof(uint64_t)];
+  size_t length = encode_header(header, chunk);
 
   switch (type_size) {
-    case 1: r = sz_write_prim(active, *(const uint8_t *)input); break;
-    case 2: r = sz_write_prim(active, *(const uint16_t *)input); break;
-    case 4: r = sz_write_prim(active, *(const uint32_t *)input); break;
+    case 1: length += sz_encode_prim(chunk + length, *(const uint8_t *)input); break;
+    case 2: length += sz_encode_prim(chunk + length, *(const uint16_t *)input); break;
+    case 4: length += sz_encode_prim(chunk + length, *(const uint32_t *)input); break;
+    case 8: length += sz_encode_prim(chunk + length, *(const uint64_t *)input); break;
 
     default:
       error = sz_errstr_wrong_kind;
       return SZ_ERROR_INVALID_OPERATION;
   }
 
-  if (r) {
+  index_field(name);
+
+  if (sz_buffer_stream_write(chunk, length, active) != length) {
     return file_error();
   }
 
@@ -402,6 +951,34 @@ sz_write_context_t::write_primitive(
 }
 
 
+sz_response_t
+sz_write_context_t::write_bytes(
+  const void *input,
+  size_t length,
+  uint32_t name
+  )
+{
+  SZ_RETURN_IF_CLOSED;
+
+  // Like arrays, null or empty byte sequences are written as a null chunk.
+  if (input == NULL || length == 0) {
+    return write_null_pointer(name);
+  }
+
+  sz_header_t header = {
+    SZ_BYTES_CHUNK,
+    name,
+    uint64_t(sizeof(header) + length)
+  };
+
+  uint8_t prefix[SZ_MAX_HEADER_SIZE];
+  const size_t prefix_length = encode_header(header, prefix);
+
+  index_field(name);
+  return write_chunk(prefix, prefix_length, input, length);
+}
+
+
 sz_response_t
 sz_write_context_t::write_primitive_array(
   const void *input,
@@ -418,7 +995,7 @@ sz_write_context_t::write_primitive_array(
     {
       SZ_ARRAY_CHUNK,
       name,
-      uint32_t(sizeof(header) + data_size)
+      uint64_t(sizeof(header) + data_size)
     },
     uint32_t(length),
     type
@@ -427,49 +1004,75 @@ sz_write_context_t::write_primitive_array(
   // null or zero-length arrays are written as a null chunk.
   if (input == NULL || !(length * type_size)) {
     return write_null_pointer(name);
+  } else if (length > SZ_MAX_ARRAY_LENGTH) {
+    error = sz_errstr_array_too_long;
+    return SZ_ERROR_INVALID_OPERATION;
   }
 
-  SZ_RETURN_IF_ERROR( write_header(header.base) );
+  uint8_t prefix[SZ_MAX_HEADER_SIZE + 2 * sizeof(uint32_t)];
+  const size_t prefix_length = encode_array_header(header, prefix);
 
-  if (   sz_write_prim(active, header.length)
-      || sz_write_prim(active, header.type)) {
-    return file_error();
-  }
+  index_field(name);
 
-#if SZ_ENDIANNESS != SZ_BASE_ENDIANNESS
-
-  bool r = false;
-  // If the host endianness is not the base endianness, swap all the bytes.
-  switch (type) {
-  case SZ_UINT32_CHUNK:
-  case SZ_SINT32_CHUNK:
-  case SZ_FLOAT_CHUNK:
-  case SZ_COMPOUND_REF_CHUNK: {
-    const uint32_t *data = (const uint32_t *)input;
-    const uint32_t *const data_end = data + length;
-    for (; data != data_end; ++data) {
-      if (sz_write_prim(active, *data)) {
-        return file_error();
-      }
-    }
-  } break;
+  return write_chunk(prefix, prefix_length, input, data_size);
+}
 
-  // TODO: SZ_DOUBLE_CHUNK support
 
-  default:
+sz_response_t
+sz_write_context_t::write_encoded_array(
+  const void *input,
+  sz_chunk_id_t type,
+  size_t type_size,
+  size_t length,
+  sz_array_encoding_t encoding,
+  uint32_t name
+  )
+{
+  SZ_RETURN_IF_CLOSED;
+
+  if (encoding == SZ_ENCODING_NONE) {
+    return write_primitive_array(input, type, type_size, length, name);
+  }
+
+  if (!sz_array_encoding_applies(encoding, type)) {
+    error = sz_errstr_bad_encoding;
+    return SZ_ERROR_INVALID_OPERATION;
+  } else if (input == NULL || length == 0) {
+    return write_null_pointer(name);
+  } else if (length > SZ_MAX_ARRAY_LENGTH) {
+    error = sz_errstr_array_too_long;
     return SZ_ERROR_INVALID_OPERATION;
   }
 
-#else
+  const size_t bound = sz_array_encoded_bound(encoding, type, length);
 
-  // If the host endianness is the base endianness, just write it like normal.
-  if (sz_stream_write(input, data_size, active) != data_size) {
-    return file_error();
+  if (encoded.size() < bound) {
+    encoded.resize(bound);
   }
 
-#endif
+  const size_t encoded_size =
+    sz_array_encode(encoding, type, input, length, &encoded[0]);
 
-  return SZ_SUCCESS;
+  if (encoded_size >= length * type_size) {
+    return write_primitive_array(input, type, type_size, length, name);
+  }
+
+  sz_array_t header = {
+    {
+      SZ_ARRAY_CHUNK,
+      name,
+      uint64_t(sizeof(header) + encoded_size)
+    },
+    uint32_t(length),
+    uint32_t(type) | (uint32_t(encoding) << SZ_ARRAY_ENCODING_SHIFT)
+  };
+
+  uint8_t prefix[SZ_MAX_HEADER_SIZE + 2 * sizeof(uint32_t)];
+  const size_t prefix_length = encode_array_header(header, prefix);
+
+  index_field(name);
+
+  return write_chunk(prefix, prefix_length, &encoded[0], encoded_size);
 }
 
 
@@ -485,43 +1088,115 @@ sz_write_context_t::write_null_pointer(uint32_t name)
 }
 
 
+sz_response_t
+sz_write_context_t::reserve_compounds(size_t count)
+{
+  if (!compound_indices.reserve(count)) {
+    error = sz_errstr_nomem;
+    return SZ_ERROR_OUT_OF_MEMORY;
+  }
+
+  compound_streams.reserve(count);
+
+  if (streaming()) {
+    compound_offsets.reserve(count);
+  }
+
+  if (indexing()) {
+    field_indices.reserve(count + 1);
+  }
+
+  return SZ_SUCCESS;
+}
+
+
 uint32_t
 sz_write_context_t::new_compound(void *compound)
 {
   uint32_t index;
-  sz_stream_t *bstream = sz_buffer_stream(SZ_WRITER, ctx_alloc);
+  sz_stream_t *bstream = NULL;
+
+  if (spare_streams.empty()) {
+    bstream = parent ? take_parent_stream() : NULL;
+
+    if (bstream == NULL) {
+      bstream = sz_buffer_stream(SZ_WRITER, ctx_alloc);
+    }
+
+    if (bstream == NULL) {
+      return 0;
+    }
+  } else {
+    bstream = spare_streams.back();
+    spare_streams.pop_back();
+  }
+
+  index = uint32_t(compound_streams.size() + 1);
+
+  if (!compound_indices.insert(compound, index)) {
+    spare_streams.push_back(bstream);
+    return 0;
+  }
+
   compound_streams.push_back(bstream);
-  index = compound_streams.size();
-  compound_indices.insert(compound_map_t::value_type(compound, index));
+
+  if (parent) {
+    local_compounds.push_back(compound);
+  }
+
+  if (streaming()) {
+    compound_offsets.push_back(0);
+  }
+
+  if (indexing()) {
+    add_field_index();
+  }
+
   return index;
 }
 
 
-uint32_t
+sz_response_t
 sz_write_context_t::store_compound(
   void *compound,
   sz_compound_writer_fn_t *writer,
-  void *writer_ctx
+  void *writer_ctx,
+  uint32_t *index
   )
 {
-  uint32_t index;
-
   if (!compound) {
-    return 0;
+    *index = 0;
+    return SZ_SUCCESS;
   }
 
-  const compound_map_t::iterator found = compound_indices.find(compound);
-  if (found != compound_indices.end()) {
-    return found->second;
+  // Workers look for compounds their parent has already given an index before
+  // their own.
+  const uint32_t *found = parent ? parent->compound_indices.find(compound) : NULL;
+
+  if (found == NULL) {
+    found = compound_indices.find(compound);
+  }
+
+  if (found) {
+    *index = *found;
+    return SZ_SUCCESS;
   }
 
-  index = new_compound(compound);
+  *index = new_compound(compound);
+  if (*index == 0) {
+    error = sz_errstr_nomem;
+    return SZ_ERROR_OUT_OF_MEMORY;
+  }
 
   push_stack();
   writer(compound, this, writer_ctx);
   pop_stack();
 
-  return index;
+  if (streaming()) {
+    return emit_compound(*index);
+  }
+
+  return SZ_SUCCESS;
 }
 
 
@@ -537,9 +1212,17 @@ sz_write_context_t::write_compound(
     return write_null_pointer(name);
   }
 
-  const uint32_t index = store_compound(compound, writer, writer_ctx);
+  uint32_t index = 0;
+  SZ_RETURN_IF_ERROR( store_compound(compound, writer, writer_ctx, &index) );
+  SZ_RETURN_IF_ERROR(
+    write_primitive(&index, SZ_COMPOUND_REF_CHUNK, sizeof(index), name)
+    );
+
+  if (parent) {
+    add_ref_patch(compound, sizeof(index));
+  }
 
-  return write_primitive(&index, SZ_COMPOUND_REF_CHUNK, sizeof(index), name);
+  return SZ_SUCCESS;
 }
 
 
@@ -554,46 +1237,80 @@ sz_write_context_t::write_compound_array(
 {
   if (compounds == NULL) {
     return write_null_pointer(name);
+  } else if (length > SZ_MAX_ARRAY_LENGTH) {
+    error = sz_errstr_array_too_long;
+    return SZ_ERROR_INVALID_OPERATION;
   }
 
+  sz_response_t response = SZ_SUCCESS;
   sz_array_t header = {
     {
       SZ_ARRAY_CHUNK,
       name,
-      uint32_t(sizeof(header) + sizeof(uint32_t) * length)
+      uint64_t(sizeof(header) + sizeof(uint32_t) * length)
     },
     uint32_t(length),
     SZ_COMPOUND_REF_CHUNK
   };
 
-  SZ_RETURN_IF_ERROR( write_header(header.base) );
+  // Store every compound first so the refs can be written with the header in
+  // one go. Arrays of compounds written by the compounds' writers push their
+  // refs on top of these and pop them before returning.
+  const size_t refs_base = compound_refs.size();
+  compound_refs.resize(refs_base + length);
 
-  if (   sz_write_prim(active, header.length)
-      || sz_write_prim(active, header.type)) {
-    return file_error();
+  for (uint32_t index = 0; index < length; ++index) {
+    uint32_t ref = 0;
+    SZ_JUMP_IF_ERROR(
+      store_compound(compounds[index], writer, writer_ctx, &ref),
+      response,
+      sz_write_compound_array_done
+      );
+    sz_encode_prim((uint8_t *)&compound_refs[refs_base + index], ref);
   }
 
-  for (uint32_t index = 0; index < length; ++index) {
-    const uint32_t ref = store_compound(compounds[index], writer, writer_ctx);
-    if (sz_write_prim(active, ref)) {
-      return file_error();
+  {
+    uint8_t prefix[SZ_MAX_HEADER_SIZE + 2 * sizeof(uint32_t)];
+    const size_t prefix_length = encode_array_header(header, prefix);
+
+    index_field(name);
+    response = write_chunk(
+      prefix,
+      prefix_length,
+      length ? &compound_refs[refs_base] : NULL,
+      sizeof(uint32_t) * length
+      );
+  }
+
+  if (parent && response == SZ_SUCCESS) {
+    for (uint32_t index = 0; index < length; ++index) {
+      add_ref_patch(compounds[index], sizeof(uint32_t) * (length - index));
     }
   }
 
-  return SZ_SUCCESS;
+sz_write_compound_array_done:
+  compound_refs.resize(refs_base);
+  return response;
 }
 
 
 bool
 sz_write_context_t::opened() const
 {
-  return bufstream || active;
+  return active != NULL;
 }
 
 
 SZ_DEF_BEGIN
 
 
+sz_response_t
+sz_reserve_compounds(sz_context_t *ctx, size_t count)
+{
+  SZ_AS_WRITER(ctx, return)->reserve_compounds(count);
+}
+
+
 sz_response_t
 sz_write_compound(
   void *compound,
@@ -635,12 +1352,7 @@ sz_write_bytes(
   uint32_t name
   )
 {
-  SZ_AS_WRITER(ctx, return)->write_primitive(
-    values,
-    SZ_BYTES_CHUNK,
-    length,
-    name
-    );
+  SZ_AS_WRITER(ctx, return)->write_bytes(values, length, name);
 }
 
 
@@ -734,5 +1446,275 @@ sz_write_unsigned_ints(
 }
 
 
+sz_response_t
+sz_write_double(double value, sz_context_t *ctx, uint32_t name)
+{
+  SZ_AS_WRITER(ctx, return)->write_primitive(
+    &value,
+    SZ_DOUBLE_CHUNK,
+    sizeof(value),
+    name
+    );
+}
+
+
+sz_response_t
+sz_write_doubles(
+  double *values,
+  size_t length,
+  sz_context_t *ctx,
+  uint32_t name
+  )
+{
+  SZ_AS_WRITER(ctx, return)->write_primitive_array(
+    values,
+    SZ_DOUBLE_CHUNK,
+    sizeof(*values),
+    length,
+    name
+    );
+}
+
+
+sz_response_t
+sz_write_int64(int64_t value, sz_context_t *ctx, uint32_t name)
+{
+  SZ_AS_WRITER(ctx, return)->write_primitive(
+    &value,
+    SZ_SINT64_CHUNK,
+    sizeof(value),
+    name
+    );
+}
+
+
+sz_response_t
+sz_write_int64s(
+  int64_t *values,
+  size_t length,
+  sz_context_t *ctx,
+  uint32_t name
+  )
+{
+  SZ_AS_WRITER(ctx, return)->write_primitive_array(
+    values,
+    SZ_SINT64_CHUNK,
+    sizeof(*values),
+    length,
+    name
+    );
+}
+
+
+sz_response_t
+sz_write_uint64(uint64_t value, sz_context_t *ctx, uint32_t name)
+{
+  SZ_AS_WRITER(ctx, return)->write_primitive(
+    &value,
+    SZ_UINT64_CHUNK,
+    sizeof(value),
+    name
+    );
+}
+
+
+sz_response_t
+sz_write_uint64s(
+  uint64_t *values,
+  size_t length,
+  sz_context_t *ctx,
+  uint32_t name
+  )
+{
+  SZ_AS_WRITER(ctx, return)->write_primitive_array(
+    values,
+    SZ_UINT64_CHUNK,
+    sizeof(*values),
+    length,
+    name
+    );
+}
+
+
+sz_response_t
+sz_write_int16(int16_t value, sz_context_t *ctx, uint32_t name)
+{
+  SZ_AS_WRITER(ctx, return)->write_primitive(
+    &value,
+    SZ_SINT16_CHUNK,
+    sizeof(value),
+    name
+    );
+}
+
+
+sz_response_t
+sz_write_int16s(
+  int16_t *values,
+  size_t length,
+  sz_context_t *ctx,
+  uint32_t name
+  )
+{
+  SZ_AS_WRITER(ctx, return)->write_primitive_array(
+    values,
+    SZ_SINT16_CHUNK,
+    sizeof(*values),
+    length,
+    name
+    );
+}
+
+
+sz_response_t
+sz_write_int8(int8_t value, sz_context_t *ctx, uint32_t name)
+{
+  SZ_AS_WRITER(ctx, return)->write_primitive(
+    &value,
+    SZ_SINT8_CHUNK,
+    sizeof(value),
+    name
+    );
+}
+
+
+sz_response_t
+sz_write_int8s(
+  int8_t *values,
+  size_t length,
+  sz_context_t *ctx,
+  uint32_t name
+  )
+{
+  SZ_AS_WRITER(ctx, return)->write_primitive_array(
+    values,
+    SZ_SINT8_CHUNK,
+    sizeof(*values),
+    length,
+    name
+    );
+}
+
+
+sz_response_t
+sz_write_encoded_floats(
+  float *values,
+  size_t length,
+  sz_array_encoding_t encoding,
+  sz_context_t *ctx,
+  uint32_t name
+  )
+{
+  SZ_AS_WRITER(ctx, return)->write_encoded_array(
+    values,
+    SZ_FLOAT_CHUNK,
+    sizeof(*values),
+    length,
+    encoding,
+    name
+    );
+}
+
+
+sz_response_t
+sz_write_encoded_doubles(
+  double *values,
+  size_t length,
+  sz_array_encoding_t encoding,
+  sz_context_t *ctx,
+  uint32_t name
+  )
+{
+  SZ_AS_WRITER(ctx, return)->write_encoded_array(
+    values,
+    SZ_DOUBLE_CHUNK,
+    sizeof(*values),
+    length,
+    encoding,
+    name
+    );
+}
+
+
+sz_response_t
+sz_write_encoded_ints(
+  int32_t *values,
+  size_t length,
+  sz_array_encoding_t encoding,
+  sz_context_t *ctx,
+  uint32_t name
+  )
+{
+  SZ_AS_WRITER(ctx, return)->write_encoded_array(
+    values,
+    SZ_SINT32_CHUNK,
+    sizeof(*values),
+    length,
+    encoding,
+    name
+    );
+}
+
+
+sz_response_t
+sz_write_encoded_unsigned_ints(
+  uint32_t *values,
+  size_t length,
+  sz_array_encoding_t encoding,
+  sz_context_t *ctx,
+  uint32_t name
+  )
+{
+  SZ_AS_WRITER(ctx, return)->write_encoded_array(
+    values,
+    SZ_UINT32_CHUNK,
+    sizeof(*values),
+    length,
+    encoding,
+    name
+    );
+}
+
+
+sz_response_t
+sz_write_encoded_int64s(
+  int64_t *values,
+  size_t length,
+  sz_array_encoding_t encoding,
+  sz_context_t *ctx,
+  uint32_t name
+  )
+{
+  SZ_AS_WRITER(ctx, return)->write_encoded_array(
+    values,
+    SZ_SINT64_CHUNK,
+    sizeof(*values),
+    length,
+    encoding,
+    name
+    );
+}
+
+
+sz_response_t
+sz_write_encoded_uint64s(
+  uint64_t *values,
+  size_t length,
+  sz_array_encoding_t encoding,
+  sz_context_t *ctx,
+  uint32_t name
+  )
+{
+  SZ_AS_WRITER(ctx, return)->write_encoded_array(
+    values,
+    SZ_UINT64_CHUNK,
+    sizeof(*values),
+    length,
+    encoding,
+    name
+    );
+}
+
+
 SZ_DEF_END
 
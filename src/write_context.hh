@@ -27,30 +27,297 @@
 #include "context.hh"
 #include "chunk.hh"
 #include "allocator_wrapper.hh"
+#include "pointer_map.hh"
 
-#include <map>
+#include <cstring>
 #include <vector>
 
+#include <pthread.h>
+
+
+// Encodes an arbitrary type val to out in the host's byte order and returns
+// the number of bytes written, sizeof(T). Should only be used for small-ish
+// POD types.
+template <typename T>
+SZ_HIDDEN
+size_t
+sz_encode_prim(uint8_t *out, T val)
+{
+  memcpy(out, &val, sizeof(val));
+  return sizeof(val);
+}
+
+
 struct SZ_HIDDEN sz_write_context_t : public s_sz_context
 {
 private:
-  typedef std::less<void *> void_comp_t;
   typedef sz_cxx_allocator_t<sz_stream_t *> stream_stack_alloc_t;
-  typedef sz_cxx_allocator_t<std::pair<void *, uint32_t> > compound_map_alloc_t;
   typedef std::vector<sz_stream_t *, stream_stack_alloc_t> stream_stack_t;
-  typedef std::map<void *, uint32_t, void_comp_t, compound_map_alloc_t> compound_map_t;
-
-  static void_comp_t void_comp;
+  typedef std::vector<uint64_t, sz_cxx_allocator_t<uint64_t> > offsets_t;
+  typedef std::vector<sz_iovec_t, sz_cxx_allocator_t<sz_iovec_t> > iovecs_t;
+  // Name and name table index pairs, sorted by name. Snowballs rarely use more
+  // than a few dozen names, so a vector does fine and keeps its memory when
+  // cleared.
+  typedef std::pair<uint32_t, uint32_t> name_entry_t;
+  typedef std::vector<name_entry_t, sz_cxx_allocator_t<name_entry_t> > name_map_t;
+  typedef std::vector<uint32_t, sz_cxx_allocator_t<uint32_t> > names_t;
+  typedef std::vector<uint32_t, sz_cxx_allocator_t<uint32_t> > index_stack_t;
+  typedef std::vector<uint8_t, sz_cxx_allocator_t<uint8_t> > bytes_t;
+  // A field's name and offset from the start of its compound's body.
+  typedef std::pair<uint32_t, uint64_t> field_t;
+  typedef std::vector<field_t, sz_cxx_allocator_t<field_t> > field_index_t;
+  typedef std::vector<
+    field_index_t,
+    sz_cxx_allocator_t<field_index_t>
+    > field_indices_t;
+
+  // A compound written by a worker for sz_write_compounds_parallel(). Its
+  // index is assigned before any are written, and the ranges of the worker's
+  // local compounds, ref patches, and name patches it created are recorded
+  // once it's written, along with the error it failed with, if any.
+  struct parallel_task_t {
+    void *compound;
+    uint32_t index;
+    sz_stream_t *stream;
+    sz_write_context_t *worker;
+    size_t locals_begin;
+    size_t locals_end;
+    size_t patches_begin;
+    size_t patches_end;
+    size_t name_patches_begin;
+    size_t name_patches_end;
+    const char *error;
+  };
+
+  // Workers only: a ref to a compound local to the worker, rewritten to the
+  // compound's index once it has one. offset is where the ref is in stream.
+  struct ref_patch_t {
+    sz_stream_t *stream;
+    size_t offset;
+    uint32_t local;
+  };
+
+  // Workers only: a compact header's name that wasn't in the parent's name
+  // table yet, padded to a fixed width at offset in stream and rewritten to
+  // the name's index once the parent has it.
+  struct name_patch_t {
+    sz_stream_t *stream;
+    size_t offset;
+    uint32_t name;
+  };
+
+  typedef std::vector<
+    parallel_task_t,
+    sz_cxx_allocator_t<parallel_task_t>
+    > parallel_tasks_t;
+  typedef std::vector<ref_patch_t, sz_cxx_allocator_t<ref_patch_t> > ref_patches_t;
+  typedef std::vector<
+    name_patch_t,
+    sz_cxx_allocator_t<name_patch_t>
+    > name_patches_t;
+  typedef std::vector<void *, sz_cxx_allocator_t<void *> > compound_ptrs_t;
+  typedef sz_cxx_allocator_t<sz_write_context_t *> workers_alloc_t;
+  typedef std::vector<sz_write_context_t *, workers_alloc_t> workers_t;
 
   sz_stream_t *bufstream;
   sz_stream_t *active;
+  // Scratch buffer the root and chunk headers are encoded into before they're
+  // written to the stream.
+  sz_stream_t *headstream;
   stream_stack_t streams;
+  // Indices of the compounds being written, parallel to streams -- 0 is the
+  // main data.
+  index_stack_t compound_stack;
   stream_stack_t compound_streams;
-  compound_map_t compound_indices;
+  sz_pointer_map_t compound_indices;
+
+  // Streaming writes only: buffers of compounds already written to the stream,
+  // kept for reuse by later compounds, and the offsets of written compounds
+  // relative to the start of the compounds table.
+  stream_stack_t spare_streams;
+  offsets_t compound_offsets;
+  uint64_t compounds_size;
+
+  // Compact headers only: the name table, in order of first use, and the index
+  // of each name in it.
+  names_t names;
+  name_map_t name_indices;
+
+  // Refs of the compound arrays being written, innermost last.
+  index_stack_t compound_refs;
+
+  // Scratch space encoded arrays are built in, kept between arrays.
+  bytes_t encoded;
+
+  // Name index only: the fields written to the main data ([0]) and to each
+  // compound ([index]). Only the first field_index_count are in use -- the
+  // rest are kept from previous snowballs for reuse.
+  field_indices_t field_indices;
+  size_t field_index_count;
+  // Streaming only: empty field indices whose storage is kept from emitted
+  // compounds for the next compounds to use.
+  field_indices_t spare_field_indices;
+
+  // Scratch space for flush(), kept so reused contexts don't reallocate it:
+  // the vectors written, where each chunk header starts in headstream, and
+  // where each chunk goes relative to the compounds table.
+  iovecs_t flush_iov;
+  offsets_t head_offsets;
+  offsets_t chunk_offsets;
+
+  // Parallel writes only. Workers are contexts that write compounds for their
+  // parent on other threads, kept along with their buffers for later calls.
+  // shared_lock guards the parent's spare streams and next_task.
+  sz_write_context_t *parent;
+  pthread_mutex_t shared_lock;
+  workers_t workers;
+  parallel_tasks_t tasks;
+  size_t next_task;
+  sz_compound_writer_fn_t *task_writer;
+  void *task_writer_ctx;
+
+  // Workers only: compounds written by the worker, parallel to its
+  // compound_streams, their final indices once merged, the refs to them, and
+  // the names the parent's name table didn't have. A worker's compound indices
+  // and new names are local to it until merged.
+  compound_ptrs_t local_compounds;
+  index_stack_t final_indices;
+  ref_patches_t ref_patches;
+  name_patches_t name_patches;
+
+
+  // Releases all buffers.
+  void
+  cleanup();
 
+  // Drops the snowball being written, if any, but keeps all buffers for reuse.
+  void
+  recycle();
 
+  // Adds an empty name index for the main data or a new compound, reusing one
+  // kept from a previous snowball if possible.
   void
-  cleanup();
+  add_field_index();
+
+  // Workers only: takes a spare buffer stream from the parent, if it has one.
+  sz_stream_t *
+  take_parent_stream();
+
+  // Workers only: if compound is local to the worker, records that a ref to it
+  // ends from_end bytes before the end of the active stream.
+  void
+  add_ref_patch(void *compound, size_t from_end);
+
+  // Workers only: encodes name's index in the parent's name table to out,
+  // which is offset bytes into a header about to be written to the end of the
+  // active stream. Names the parent doesn't have yet are left to the merge to
+  // add, so the table's order doesn't depend on which thread used them first.
+  size_t
+  encode_worker_name(uint32_t name, size_t offset, uint8_t *out);
+
+  // Gets a worker ready to write compounds for this context, creating it if
+  // there aren't that many yet. Returns NULL if out of memory.
+  sz_write_context_t *
+  start_worker(size_t worker_index);
+
+  // Workers only: forgets the worker's local compounds, whose buffers belong
+  // to the parent by now.
+  void
+  finish_worker();
+
+  // Workers only: writes tasks until there are none left.
+  void
+  run_tasks();
+
+  // Workers only: writes a task's compound, along with any compounds it refers
+  // to that haven't been written yet, to the worker's buffers.
+  void
+  write_task(parallel_task_t &task);
+
+  // Gives the compounds a worker wrote for a task their final indices, fixes
+  // up refs to them, and adopts their buffers.
+  sz_response_t
+  merge_task(const parallel_task_t &task);
+
+  static void *
+  worker_main(void *worker);
+
+  bool
+  streaming() const
+  {
+    return (flags & SZ_STREAMING_WRITES) != 0;
+  }
+
+  bool
+  compact() const
+  {
+    return (flags & SZ_COMPACT_HEADERS) != 0;
+  }
+
+  // Returns the sz_root_t::flags bits for the snowball being written.
+  uint32_t
+  root_flags() const;
+
+  // Returns the name table index of name, adding it to the table if needed.
+  uint32_t
+  intern_name(uint32_t name);
+
+  // Returns the encoded size of the name table, or 0 if there isn't one.
+  uint64_t
+  names_size() const;
+
+  // Encodes the name table, if there is one, to the given stream.
+  sz_response_t
+  write_names(sz_stream_t *stream_);
+
+  bool
+  indexing() const
+  {
+    return (flags & SZ_NAME_INDEX) != 0;
+  }
+
+  // Encodes a chunk header to out, which must have room for
+  // SZ_MAX_HEADER_SIZE bytes, and returns its encoded size.
+  size_t
+  encode_header(const sz_header_t &header, uint8_t *out);
+
+  // Encodes an array header along with its length and type.
+  size_t
+  encode_array_header(const sz_array_t &header, uint8_t *out);
+
+  // Adds a field with the given name, starting at the end of the active
+  // stream, to the active compound's name index if there is one.
+  void
+  index_field(uint32_t name);
+
+  // Writes a chunk to the active stream in one write: its already-encoded
+  // header (prefix), padding to align the payload, and the payload.
+  sz_response_t
+  write_chunk(
+    const uint8_t *prefix,
+    size_t prefix_length,
+    const void *payload,
+    size_t payload_length
+    );
+
+  // Returns the encoded size of a compound's name index, or 0 if there isn't
+  // one. Compound 0 is the main data.
+  uint64_t
+  field_index_size(uint32_t compound) const;
+
+  // Encodes a compound's name index, if there is one, to the given stream.
+  sz_response_t
+  write_field_index(uint32_t compound, sz_stream_t *stream_);
+
+  // Streaming writes only: writes the compound with the given index to the
+  // stream and releases its buffer.
+  sz_response_t
+  emit_compound(uint32_t index);
+
+  // Streaming writes only: writes the main data and mappings, then goes back
+  // and writes the root.
+  sz_response_t
+  flush_streaming();
 
 
 public:
@@ -67,7 +334,7 @@ public:
 
   // Roots
   sz_response_t
-  write_root(const sz_root_t &root);
+  write_root(const sz_root_t &root, sz_stream_t *stream_);
 
 
   // Headers
@@ -80,14 +347,18 @@ public:
 
 
   // Compounds
+  sz_response_t
+  reserve_compounds(size_t count);
+
   uint32_t
   new_compound(void *compound);
 
-  uint32_t
+  sz_response_t
   store_compound(
     void *compound,
     sz_compound_writer_fn_t *writer,
-    void *writer_ctx
+    void *writer_ctx,
+    uint32_t *index
     );
 
   sz_response_t
@@ -107,6 +378,16 @@ public:
     uint32_t name
     );
 
+  sz_response_t
+  write_compound_array_parallel(
+    void **compounds,
+    size_t length,
+    sz_compound_writer_fn_t *writer,
+    void *writer_ctx,
+    uint32_t name,
+    size_t num_threads
+    );
+
 
   // Info stack
   void
@@ -130,6 +411,13 @@ public:
     uint32_t name
     );
 
+  sz_response_t
+  write_bytes(
+    const void *input,
+    size_t length,
+    uint32_t name
+    );
+
   sz_response_t
   write_primitive_array(
     const void *input,
@@ -139,6 +427,18 @@ public:
     uint32_t name
     );
 
+  // Writes an array with the given encoding, or as-is if encoding it
+  // wouldn't save anything.
+  sz_response_t
+  write_encoded_array(
+    const void *input,
+    sz_chunk_id_t type,
+    size_t type_size,
+    size_t length,
+    sz_array_encoding_t encoding,
+    uint32_t name
+    );
+
 
   // Open / flush / close ops
   virtual
@@ -152,6 +452,10 @@ public:
   sz_response_t
   close();
 
+  virtual
+  sz_response_t
+  reset();
+
   virtual
   bool
   opened() const;
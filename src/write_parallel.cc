@@ -0,0 +1,511 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+#include "write_context.hh"
+#include "error_strings.hh"
+#include "utilities.hh"
+#include "bufstream.hh"
+#include "varint.hh"
+
+#include <algorithm>
+#include <unistd.h>
+
+
+// Writing compounds in parallel
+//
+// Every compound in the array that doesn't have an index yet is given one up
+// front, in array order, and becomes a task. Workers then take tasks in order
+// and write each task's compound to its buffer, along with any compounds it
+// refers to that don't have an index yet. Workers don't share those, so each
+// gives them indices local to itself and records where refs to them were
+// written. Once every task is written, the tasks are merged in order: each
+// worker-local compound is either adopted by the parent and given the next
+// index or, if an earlier task already wrote it, dropped, and the refs to it
+// are rewritten. Indices are assigned in the same order however many threads
+// there are and however the tasks were divided among them, so the output
+// doesn't depend on either.
+//
+// Compact headers' names work the same way. The parent's name table doesn't
+// change while workers run, so they look names up in it directly; names it
+// doesn't have yet are written as padded, fixed-width placeholders and given
+// their indices as the tasks are merged.
+
+
+// Returns the response a worker's error stands for. Compound writers don't
+// return responses, so the error is all a failed task leaves behind.
+static
+sz_response_t
+sz_worker_response(const char *error)
+{
+  if (error == sz_errstr_nomem) {
+    return SZ_ERROR_OUT_OF_MEMORY;
+  } else if (error == sz_errstr_cannot_write) {
+    return SZ_ERROR_CANNOT_WRITE;
+  } else if (error == sz_errstr_eof) {
+    return SZ_ERROR_EOF;
+  }
+
+  return SZ_ERROR_INVALID_OPERATION;
+}
+
+
+sz_stream_t *
+sz_write_context_t::take_parent_stream()
+{
+  sz_stream_t *spare = NULL;
+
+  pthread_mutex_lock(&parent->shared_lock);
+  if (!parent->spare_streams.empty()) {
+    spare = parent->spare_streams.back();
+    parent->spare_streams.pop_back();
+  }
+  pthread_mutex_unlock(&parent->shared_lock);
+
+  return spare;
+}
+
+
+void
+sz_write_context_t::add_ref_patch(void *compound, size_t from_end)
+{
+  if (compound == NULL || parent->compound_indices.find(compound)) {
+    return;
+  }
+
+  const uint32_t *const local = compound_indices.find(compound);
+  if (local == NULL) {
+    return;
+  }
+
+  size_t active_size = 0;
+  sz_buffer_stream_data(active, &active_size);
+
+  const ref_patch_t patch = { active, active_size - from_end, *local };
+  ref_patches.push_back(patch);
+}
+
+
+size_t
+sz_write_context_t::encode_worker_name(
+  uint32_t name,
+  size_t offset,
+  uint8_t *out
+  )
+{
+  const name_map_t &known = parent->name_indices;
+  const name_map_t::const_iterator found = std::lower_bound(
+    known.begin(),
+    known.end(),
+    name_entry_t(name, 0)
+    );
+
+  if (found != known.end() && found->first == name) {
+    return sz_varint_encode(found->second, out);
+  }
+
+  size_t active_size = 0;
+  sz_buffer_stream_data(active, &active_size);
+
+  const name_patch_t patch = { active, active_size + offset, name };
+  name_patches.push_back(patch);
+
+  sz_varint_encode_padded(0, out, SZ_VARINT32_MAX_LENGTH);
+  return SZ_VARINT32_MAX_LENGTH;
+}
+
+
+sz_write_context_t *
+sz_write_context_t::start_worker(size_t worker_index)
+{
+  if (worker_index == workers.size()) {
+    void *memory = sz_malloc(sizeof(sz_write_context_t), ctx_alloc);
+    if (memory == NULL) {
+      return NULL;
+    }
+
+    sz_write_context_t *const worker = new (memory) sz_write_context_t(ctx_alloc);
+    worker->parent = this;
+    workers.push_back(worker);
+  }
+
+  sz_write_context_t *const worker = workers[worker_index];
+
+  // Compounds are handed to the parent once written, so workers never stream.
+  worker->flags = flags & ~uint32_t(SZ_STREAMING_WRITES);
+  worker->alignment = alignment;
+  worker->error = sz_errstr_no_error;
+  worker->finish_worker();
+
+  // Name index 0 belongs to the main data, which workers don't write to.
+  if (worker->indexing()) {
+    worker->add_field_index();
+  }
+
+  return worker;
+}
+
+
+void
+sz_write_context_t::finish_worker()
+{
+  active = NULL;
+  compound_streams.clear();
+  compound_indices.clear();
+  local_compounds.clear();
+  final_indices.clear();
+  ref_patches.clear();
+  name_patches.clear();
+  field_index_count = 0;
+  compound_stack.clear();
+  compound_refs.clear();
+  streams.clear();
+}
+
+
+void
+sz_write_context_t::run_tasks()
+{
+  for (;;) {
+    pthread_mutex_lock(&parent->shared_lock);
+    const size_t task_index = parent->next_task++;
+    pthread_mutex_unlock(&parent->shared_lock);
+
+    if (task_index >= parent->tasks.size()) {
+      break;
+    }
+
+    write_task(parent->tasks[task_index]);
+  }
+}
+
+
+void
+sz_write_context_t::write_task(parallel_task_t &task)
+{
+  task.worker = this;
+  task.locals_begin = compound_streams.size();
+  task.patches_begin = ref_patches.size();
+  task.name_patches_begin = name_patches.size();
+
+  // The task's compound is the worker's next local compound, but it's written
+  // straight to the buffer the parent set aside for it.
+  compound_streams.push_back(task.stream);
+  local_compounds.push_back(task.compound);
+
+  if (indexing()) {
+    add_field_index();
+  }
+
+  // Errors are kept per task so the parent can report the first in order.
+  error = sz_errstr_no_error;
+
+  push_stack();
+  parent->task_writer(task.compound, this, parent->task_writer_ctx);
+  pop_stack();
+
+  task.error = error;
+
+  task.locals_end = compound_streams.size();
+  task.patches_end = ref_patches.size();
+  task.name_patches_end = name_patches.size();
+}
+
+
+void *
+sz_write_context_t::worker_main(void *worker)
+{
+  static_cast<sz_write_context_t *>(worker)->run_tasks();
+  return NULL;
+}
+
+
+sz_response_t
+sz_write_context_t::merge_task(const parallel_task_t &task)
+{
+  sz_write_context_t *const worker = task.worker;
+  index_stack_t &indices = worker->final_indices;
+
+  indices.resize(worker->compound_streams.size());
+
+  for (size_t local = task.locals_begin; local < task.locals_end; ++local) {
+    void *const compound = worker->local_compounds[local];
+    const uint32_t *const found = compound_indices.find(compound);
+    uint32_t index = task.index;
+    bool adopted = local == task.locals_begin;
+
+    if (!adopted && found) {
+      // Written by an earlier task, so this copy is dropped below.
+      index = *found;
+    } else if (!adopted) {
+      index = uint32_t(compound_streams.size() + 1);
+
+      if (!compound_indices.insert(compound, index)) {
+        error = sz_errstr_nomem;
+        return SZ_ERROR_OUT_OF_MEMORY;
+      }
+
+      compound_streams.push_back(worker->compound_streams[local]);
+
+      if (streaming()) {
+        compound_offsets.push_back(0);
+      }
+
+      if (indexing()) {
+        add_field_index();
+      }
+
+      adopted = true;
+    }
+
+    if (adopted) {
+      // The buffer is the parent's now.
+      worker->compound_streams[local] = NULL;
+
+      if (indexing()) {
+        field_indices[index].swap(worker->field_indices[local + 1]);
+      }
+    }
+
+    indices[local] = index;
+  }
+
+  for (size_t patch = task.patches_begin; patch < task.patches_end; ++patch) {
+    const ref_patch_t &ref = worker->ref_patches[patch];
+    uint8_t *const data = (uint8_t *)sz_buffer_stream_data(ref.stream, NULL);
+    sz_encode_prim(data + ref.offset, indices[ref.local - 1]);
+  }
+
+  const size_t names_end = task.name_patches_end;
+  for (size_t patch = task.name_patches_begin; patch < names_end; ++patch) {
+    const name_patch_t &ref = worker->name_patches[patch];
+    size_t size = 0;
+    uint8_t *const data = (uint8_t *)sz_buffer_stream_data(ref.stream, &size);
+
+    // A header whose chunk failed to write has nothing to patch.
+    if (ref.offset + SZ_VARINT32_MAX_LENGTH <= size) {
+      sz_varint_encode_padded(
+        intern_name(ref.name),
+        data + ref.offset,
+        SZ_VARINT32_MAX_LENGTH
+        );
+    }
+  }
+
+  for (size_t local = task.locals_begin; local < task.locals_end; ++local) {
+    sz_stream_t *const dropped = worker->compound_streams[local];
+
+    if (dropped) {
+      sz_buffer_stream_reset(dropped);
+      spare_streams.push_back(dropped);
+      worker->compound_streams[local] = NULL;
+    } else if (streaming()) {
+      SZ_RETURN_IF_ERROR( emit_compound(indices[local]) );
+    }
+  }
+
+  return SZ_SUCCESS;
+}
+
+
+sz_response_t
+sz_write_context_t::write_compound_array_parallel(
+  void **compounds,
+  size_t length,
+  sz_compound_writer_fn_t *writer,
+  void *writer_ctx,
+  uint32_t name,
+  size_t num_threads
+  )
+{
+  SZ_RETURN_IF_CLOSED;
+
+  // Writers called by workers write their compound arrays serially.
+  if (compounds == NULL || parent) {
+    return write_compound_array(compounds, length, writer, writer_ctx, name);
+  } else if (length > SZ_MAX_ARRAY_LENGTH) {
+    error = sz_errstr_array_too_long;
+    return SZ_ERROR_INVALID_OPERATION;
+  }
+
+  typedef std::vector<pthread_t, sz_cxx_allocator_t<pthread_t> > threads_t;
+
+  sz_response_t response = SZ_SUCCESS;
+  threads_t threads((sz_cxx_allocator_t<pthread_t>(ctx_alloc)));
+  size_t num_workers = 0;
+
+  // Give every new compound its index and its buffer up front.
+  tasks.clear();
+  for (size_t index = 0; index < length; ++index) {
+    void *const compound = compounds[index];
+
+    if (compound == NULL || compound_indices.find(compound)) {
+      continue;
+    }
+
+    const uint32_t compound_index = new_compound(compound);
+    if (compound_index == 0) {
+      error = sz_errstr_nomem;
+      return SZ_ERROR_OUT_OF_MEMORY;
+    }
+
+    const parallel_task_t task = {
+      compound,
+      compound_index,
+      compound_streams.back(),
+      NULL,
+      0, 0, 0, 0, 0, 0,
+      sz_errstr_no_error
+    };
+
+    tasks.push_back(task);
+  }
+
+  if (num_threads == 0) {
+    const long online = sysconf(_SC_NPROCESSORS_ONLN);
+    num_threads = online > 0 ? size_t(online) : 1;
+  }
+
+  if (num_threads > tasks.size()) {
+    num_threads = tasks.size();
+  }
+
+  for (; num_workers < num_threads; ++num_workers) {
+    if (start_worker(num_workers) == NULL) {
+      break;
+    }
+  }
+
+  if (num_workers == 0 && !tasks.empty()) {
+    error = sz_errstr_nomem;
+    return SZ_ERROR_OUT_OF_MEMORY;
+  }
+
+  // This thread works too, as the first worker. If a thread can't be started,
+  // the workers that did start pick up its share.
+  next_task = 0;
+  task_writer = writer;
+  task_writer_ctx = writer_ctx;
+  threads.reserve(num_workers);
+
+  for (size_t worker_index = 1; worker_index < num_workers; ++worker_index) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, worker_main, workers[worker_index])) {
+      break;
+    }
+    threads.push_back(thread);
+  }
+
+  if (num_workers) {
+    workers[0]->run_tasks();
+  }
+
+  #if __cplusplus >= 201103L
+  for (pthread_t thread : threads) {
+  #else
+  threads_t::iterator iter = threads.begin();
+  const threads_t::iterator end = threads.end();
+  for (; iter != end; ++iter) {
+    pthread_t thread = *iter;
+  #endif
+    pthread_join(thread, NULL);
+  }
+
+  // A writer that failed fails the whole array, as if the compounds had been
+  // written in order and the first failure stopped it.
+  for (size_t task = 0; task < tasks.size(); ++task) {
+    if (tasks[task].error != sz_errstr_no_error) {
+      error = tasks[task].error;
+      response = sz_worker_response(error);
+      goto sz_write_compound_array_parallel_done;
+    }
+  }
+
+  for (size_t task = 0; task < tasks.size(); ++task) {
+    SZ_JUMP_IF_ERROR(
+      merge_task(tasks[task]),
+      response,
+      sz_write_compound_array_parallel_done
+      );
+  }
+
+  // Every compound has an index now, so this only writes the refs.
+  response = write_compound_array(compounds, length, writer, writer_ctx, name);
+
+sz_write_compound_array_parallel_done:
+  // Tasks' own buffers always belong to the parent, merged or not.
+  for (size_t task = 0; task < tasks.size(); ++task) {
+    tasks[task].worker->compound_streams[tasks[task].locals_begin] = NULL;
+  }
+
+  for (size_t worker_index = 0; worker_index < num_workers; ++worker_index) {
+    sz_write_context_t *const worker = workers[worker_index];
+
+    // Buffers the parent didn't take after a failed merge are spares now.
+    #if __cplusplus >= 201103L
+    for (sz_stream_t *local_stream : worker->compound_streams) {
+    #else
+    stream_stack_t::iterator local_iter = worker->compound_streams.begin();
+    const stream_stack_t::iterator local_end = worker->compound_streams.end();
+    for (; local_iter != local_end; ++local_iter) {
+      sz_stream_t *local_stream = *local_iter;
+    #endif
+      if (local_stream && response != SZ_SUCCESS) {
+        sz_buffer_stream_reset(local_stream);
+        worker->spare_streams.push_back(local_stream);
+      }
+    }
+
+    worker->finish_worker();
+  }
+
+  tasks.clear();
+
+  return response;
+}
+
+
+SZ_DEF_BEGIN
+
+
+sz_response_t
+sz_write_compounds_parallel(
+  void **compounds,
+  size_t length,
+  sz_context_t *ctx,
+  uint32_t name,
+  sz_compound_writer_fn_t *writer,
+  void *writer_ctx,
+  size_t num_threads
+  )
+{
+  SZ_AS_WRITER(ctx, return)->write_compound_array_parallel(
+    compounds,
+    length,
+    writer,
+    writer_ctx,
+    name,
+    num_threads
+    );
+}
+
+
+SZ_DEF_END
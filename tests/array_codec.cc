@@ -0,0 +1,327 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+#include "tests.hh"
+#include "array_codec.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+
+// Lengths around the codecs' block sizes: 128 values for packed deltas and
+// 16 KB (4096 floats, 2048 doubles) for the shuffles, as well as the 16 values
+// SIMD loops take at a time.
+static const size_t codec_lengths[] = {
+  1, 3, 15, 16, 17, 127, 128, 129, 255, 256, 257,
+  2047, 2048, 2049, 4095, 4096, 4097, 8192, 10000
+};
+
+
+struct codec_case_t
+{
+  sz_array_encoding_t encoding;
+  sz_chunk_id_t type;
+  size_t type_size;
+  const char *name;
+};
+
+
+static const codec_case_t codec_cases[] = {
+  { SZ_ENCODING_VARINT, SZ_UINT32_CHUNK, 4, "varint uint32" },
+  { SZ_ENCODING_VARINT, SZ_SINT32_CHUNK, 4, "varint sint32" },
+  { SZ_ENCODING_PACKED_DELTAS, SZ_UINT32_CHUNK, 4, "packed uint32" },
+  { SZ_ENCODING_PACKED_DELTAS, SZ_SINT32_CHUNK, 4, "packed sint32" },
+  { SZ_ENCODING_PACKED_DELTAS, SZ_UINT64_CHUNK, 8, "packed uint64" },
+  { SZ_ENCODING_PACKED_DELTAS, SZ_SINT64_CHUNK, 8, "packed sint64" },
+  { SZ_ENCODING_SHUFFLE, SZ_FLOAT_CHUNK, 4, "shuffle float" },
+  { SZ_ENCODING_SHUFFLE, SZ_DOUBLE_CHUNK, 8, "shuffle double" },
+  { SZ_ENCODING_XOR_SHUFFLE, SZ_FLOAT_CHUNK, 4, "xor shuffle float" },
+  { SZ_ENCODING_XOR_SHUFFLE, SZ_DOUBLE_CHUNK, 8, "xor shuffle double" },
+  { SZ_ENCODING_HALF, SZ_FLOAT_CHUNK, 4, "half" },
+  { SZ_ENCODING_BFLOAT16, SZ_FLOAT_CHUNK, 4, "bfloat16" },
+  { SZ_ENCODING_QUANTIZED16, SZ_FLOAT_CHUNK, 4, "quantized16" }
+};
+
+
+static
+bool
+codec_lossy(sz_array_encoding_t encoding)
+{
+  return
+    encoding == SZ_ENCODING_HALF ||
+    encoding == SZ_ENCODING_BFLOAT16 ||
+    encoding == SZ_ENCODING_QUANTIZED16;
+}
+
+
+static
+uint32_t
+codec_random(uint32_t *state)
+{
+  *state = *state * 1664525U + 1013904223U;
+  return *state >> 8;
+}
+
+
+// Fills values with data the encodings do something with: slowly changing
+// series with noise, runs of repeats, and the odd outlier.
+static
+void
+codec_fill(const codec_case_t &codec, size_t count, sz_test_bytes_t *values)
+{
+  uint32_t state = uint32_t(count) * 2654435761U;
+
+  values->assign(count * codec.type_size, 0);
+
+  for (size_t index = 0; index < count; ++index) {
+    const uint32_t noise = codec_random(&state);
+    const bool outlier = noise % 97 == 0;
+    const double wave = std::sin(double(index) * 0.01) * 1000.0;
+    uint8_t *const out = &(*values)[index * codec.type_size];
+
+    switch (codec.type) {
+    case SZ_UINT32_CHUNK:
+    case SZ_SINT32_CHUNK: {
+      int32_t value = int32_t(wave) + int32_t(noise % 16);
+      if (outlier) {
+        value = int32_t(noise << 8);
+      }
+      memcpy(out, &value, sizeof(value));
+      break;
+    }
+
+    case SZ_UINT64_CHUNK:
+    case SZ_SINT64_CHUNK: {
+      int64_t value = int64_t(index) * 1000 + int64_t(noise % 256);
+      if (outlier) {
+        value = -(int64_t(noise) << 24);
+      }
+      memcpy(out, &value, sizeof(value));
+      break;
+    }
+
+    case SZ_FLOAT_CHUNK: {
+      float value = float(wave) + float(noise % 4) * 0.25f;
+      if (index % 64 >= 48) {
+        value = 1.5f;
+      } else if (outlier) {
+        value = -float(noise);
+      }
+      memcpy(out, &value, sizeof(value));
+      break;
+    }
+
+    default: {
+      double value = wave + double(noise % 4) * 0.125;
+      if (index % 64 >= 48) {
+        value = 1.5;
+      } else if (outlier) {
+        value = -double(noise);
+      }
+      memcpy(out, &value, sizeof(value));
+      break;
+    }
+    }
+  }
+}
+
+
+static
+size_t
+codec_encode(
+  const codec_case_t &codec,
+  const sz_test_bytes_t &values,
+  size_t count,
+  sz_test_bytes_t *encoded
+  )
+{
+  encoded->assign(sz_array_encoded_bound(codec.encoding, codec.type, count), 0);
+  const size_t size = sz_array_encode(
+    codec.encoding,
+    codec.type,
+    &values[0],
+    count,
+    &(*encoded)[0]
+    );
+  encoded->resize(size);
+  return size;
+}
+
+
+static
+bool
+codec_decode(
+  const codec_case_t &codec,
+  const sz_test_bytes_t &encoded,
+  size_t length,
+  size_t count,
+  sz_test_bytes_t *values
+  )
+{
+  values->assign(count * codec.type_size, 0xCD);
+  return sz_array_decode(
+    codec.encoding,
+    codec.type,
+    encoded.empty() ? NULL : &encoded[0],
+    length,
+    &(*values)[0],
+    count
+    );
+}
+
+
+// Whether the decoded floats are within the encoding's error of the input.
+static
+bool
+codec_close(
+  const codec_case_t &codec,
+  const sz_test_bytes_t &values,
+  const sz_test_bytes_t &decoded,
+  size_t count
+  )
+{
+  const float *const in = (const float *)&values[0];
+  const float *const out = (const float *)&decoded[0];
+  float minimum = in[0];
+  float maximum = in[0];
+
+  for (size_t index = 1; index < count; ++index) {
+    minimum = std::min(minimum, in[index]);
+    maximum = std::max(maximum, in[index]);
+  }
+
+  for (size_t index = 0; index < count; ++index) {
+    const double error = std::fabs(double(out[index]) - double(in[index]));
+    double allowed = 0.0;
+
+    switch (codec.encoding) {
+    case SZ_ENCODING_HALF:
+      allowed = std::fabs(in[index]) / 1024.0 + 1e-4;
+      break;
+    case SZ_ENCODING_BFLOAT16:
+      allowed = std::fabs(in[index]) / 128.0;
+      break;
+    default:
+      allowed = (double(maximum) - double(minimum)) / 65535.0;
+      break;
+    }
+
+    // Half floats overflow to infinity past 65504.
+    if (   codec.encoding == SZ_ENCODING_HALF
+        && std::fabs(in[index]) > 65504.0f) {
+      continue;
+    }
+
+    if (error > allowed) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+// Every encoding round-trips at and around its block sizes, and its SIMD paths
+// encode and decode exactly what its scalar paths do.
+SZ_TEST(array_codec_round_trip)
+{
+  const size_t case_count = sizeof(codec_cases) / sizeof(codec_cases[0]);
+  const size_t length_count = sizeof(codec_lengths) / sizeof(codec_lengths[0]);
+  sz_test_bytes_t values;
+  sz_test_bytes_t simd_encoded;
+  sz_test_bytes_t scalar_encoded;
+  sz_test_bytes_t simd_decoded;
+  sz_test_bytes_t scalar_decoded;
+
+  for (size_t index = 0; index < case_count; ++index) {
+    const codec_case_t &codec = codec_cases[index];
+
+    for (size_t length = 0; length < length_count; ++length) {
+      const size_t count = codec_lengths[length];
+      const int failures_before = *sz_test_failures;
+
+      codec_fill(codec, count, &values);
+
+      sz_array_codec_use_simd(true);
+      const size_t size = codec_encode(codec, values, count, &simd_encoded);
+      SZ_EXPECT(!codec_decode(codec, simd_encoded, size, count, &simd_decoded));
+
+      sz_array_codec_use_simd(false);
+      codec_encode(codec, values, count, &scalar_encoded);
+      SZ_EXPECT(scalar_encoded == simd_encoded);
+      SZ_EXPECT(
+        !codec_decode(codec, simd_encoded, size, count, &scalar_decoded)
+        );
+      SZ_EXPECT(scalar_decoded == simd_decoded);
+
+      if (codec_lossy(codec.encoding)) {
+        SZ_EXPECT(codec_close(codec, values, simd_decoded, count));
+      } else {
+        SZ_EXPECT(simd_decoded == values);
+      }
+
+      if (*sz_test_failures != failures_before) {
+        fprintf(stderr, "  in %s, %zu values\n", codec.name, count);
+      }
+    }
+  }
+
+  sz_array_codec_use_simd(true);
+}
+
+
+// Truncated data is rejected rather than read past, with or without SIMD.
+SZ_TEST(array_codec_truncated)
+{
+  const size_t case_count = sizeof(codec_cases) / sizeof(codec_cases[0]);
+  static const size_t count = 4097;
+  sz_test_bytes_t values;
+  sz_test_bytes_t encoded;
+  sz_test_bytes_t decoded;
+
+  for (int simd = 0; simd < 2; ++simd) {
+    sz_array_codec_use_simd(simd != 0);
+
+    for (size_t index = 0; index < case_count; ++index) {
+      const codec_case_t &codec = codec_cases[index];
+
+      codec_fill(codec, count, &values);
+      const size_t size = codec_encode(codec, values, count, &encoded);
+
+      // Decoding into a copy of exactly the truncated length lets the
+      // sanitizers see any read past its end.
+      const size_t lengths[] = { 0, 1, size / 2, size - 1 };
+      for (size_t cut = 0; cut < sizeof(lengths) / sizeof(lengths[0]); ++cut) {
+        sz_test_bytes_t truncated(
+          encoded.begin(),
+          encoded.begin() + lengths[cut]
+          );
+        SZ_EXPECT(
+          codec_decode(codec, truncated, lengths[cut], count, &decoded)
+          );
+      }
+    }
+  }
+
+  sz_array_codec_use_simd(true);
+}
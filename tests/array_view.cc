@@ -0,0 +1,272 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+#include "tests.hh"
+
+#include <cstdlib>
+#include <cstring>
+
+
+static const size_t sz_view_floats = 10;
+
+
+// Writes an array of sz_view_floats floats named 'flts' to bytes and returns
+// the offset of its length field.
+static
+size_t
+write_floats(sz_test_bytes_t *bytes)
+{
+  float values[sz_view_floats];
+  sz_context_t *ctx = sz_new_context(SZ_WRITER, NULL);
+  sz_stream_t *stream = sz_test_memstream(bytes);
+
+  for (size_t index = 0; index < sz_view_floats; ++index) {
+    values[index] = 1.0f + float(index);
+  }
+
+  sz_set_stream(ctx, stream);
+  sz_open(ctx);
+  sz_write_floats(values, sz_view_floats, ctx, 'flts');
+  sz_close(ctx);
+  sz_destroy_context(ctx);
+  sz_stream_close(stream);
+
+  // The length and element type directly precede the unaligned payload.
+  for (size_t off = 0; off + sizeof(values) <= bytes->size(); ++off) {
+    if (memcmp(&(*bytes)[off], values, sizeof(values)) == 0) {
+      return off - 2 * sizeof(uint32_t);
+    }
+  }
+
+  return 0;
+}
+
+
+SZ_TEST(array_view)
+{
+  sz_test_bytes_t bytes;
+  write_floats(&bytes);
+
+  sz_context_t *ctx = sz_new_context(SZ_READER, NULL);
+  sz_stream_t *stream = sz_stream_memopen(&bytes[0], bytes.size(), NULL);
+  const float *view = NULL;
+  size_t length = 0;
+
+  sz_set_stream(ctx, stream);
+  SZ_EXPECT(sz_open(ctx) == SZ_SUCCESS);
+  SZ_EXPECT(sz_read_floats_view(&view, &length, ctx, 'flts') == SZ_SUCCESS);
+  SZ_EXPECT(length == sz_view_floats);
+  SZ_EXPECT(view != NULL && view[sz_view_floats - 1] == 10.0f);
+
+  sz_destroy_context(ctx);
+  sz_stream_close(stream);
+}
+
+
+// An array claiming more elements than its payload holds must be rejected by
+// every way of reading it.
+SZ_TEST(array_corrupt_length)
+{
+  sz_test_bytes_t bytes;
+  const size_t length_off = write_floats(&bytes);
+  const uint32_t corrupt_length = 200;
+
+  SZ_EXPECT(length_off != 0);
+  memcpy(&bytes[length_off], &corrupt_length, sizeof(corrupt_length));
+
+  sz_context_t *ctx = sz_new_context(SZ_READER, NULL);
+  sz_stream_t *stream = sz_stream_memopen(&bytes[0], bytes.size(), NULL);
+  const float *view = NULL;
+  float *copy = NULL;
+  size_t length = 0;
+
+  sz_set_stream(ctx, stream);
+  SZ_EXPECT(sz_open(ctx) == SZ_SUCCESS);
+  SZ_EXPECT(sz_read_floats_view(&view, &length, ctx, 'flts') != SZ_SUCCESS);
+  SZ_EXPECT(view == NULL && length == 0);
+  SZ_EXPECT(sz_read_floats(&copy, &length, ctx, 'flts', NULL) != SZ_SUCCESS);
+  SZ_EXPECT(copy == NULL);
+  SZ_EXPECT(sz_begin_array(&length, ctx, SZ_FLOAT_CHUNK, 'flts') != SZ_SUCCESS);
+
+  free(copy);
+  sz_destroy_context(ctx);
+  sz_stream_close(stream);
+}
+
+
+struct root_part_t
+{
+  int32_t value;
+};
+
+
+static
+void
+write_part(void *compound, sz_context_t *ctx, void *writer_ctx)
+{
+  (void)writer_ctx;
+  sz_write_int(((root_part_t *)compound)->value, ctx, 'valu');
+}
+
+
+// Writes a snowball holding a compound and a float to bytes, with the given
+// context flags.
+static
+void
+write_compound(sz_test_bytes_t *bytes, uint32_t flags)
+{
+  root_part_t part = { 7 };
+  sz_context_t *ctx = sz_new_context(SZ_WRITER, NULL);
+  sz_stream_t *stream = sz_test_memstream(bytes);
+
+  sz_set_flags(ctx, flags);
+  sz_set_stream(ctx, stream);
+  sz_open(ctx);
+  sz_write_compound(&part, ctx, 'part', write_part, NULL);
+  sz_write_float(1.5f, ctx, 'flot');
+  sz_close(ctx);
+  sz_destroy_context(ctx);
+  sz_stream_close(stream);
+}
+
+
+// Byte offsets of the root's fields.
+enum {
+  ROOT_FLAGS_OFFSET = 4,
+  ROOT_SIZE_OFFSET = 8,
+  ROOT_COMPOUNDS_COUNT_OFFSET = 16,
+  ROOT_MAPPINGS_OFFSET = 24,
+  ROOT_DATA_OFFSET = 40
+};
+
+
+static
+uint64_t
+load_u64(const sz_test_bytes_t &bytes, size_t offset)
+{
+  uint64_t value = 0;
+  memcpy(&value, &bytes[offset], sizeof(value));
+  return value;
+}
+
+
+static
+void
+store_u64(sz_test_bytes_t *bytes, size_t offset, uint64_t value)
+{
+  memcpy(&(*bytes)[offset], &value, sizeof(value));
+}
+
+
+static
+sz_response_t
+open_bytes(const sz_test_bytes_t &bytes)
+{
+  sz_context_t *ctx = sz_new_context(SZ_READER, NULL);
+  sz_stream_t *stream = sz_stream_memopen(&bytes[0], bytes.size(), NULL);
+
+  sz_set_stream(ctx, stream);
+  const sz_response_t response = sz_open(ctx);
+
+  sz_destroy_context(ctx);
+  sz_stream_close(stream);
+  return response;
+}
+
+
+// Root offsets and compound offsets past the end of the snowball are rejected
+// before they're added to the stream position.
+SZ_TEST(root_corrupt_offsets)
+{
+  sz_test_bytes_t bytes;
+  write_compound(&bytes, 0);
+  SZ_EXPECT(open_bytes(bytes) == SZ_SUCCESS);
+
+  const uint64_t size = load_u64(bytes, ROOT_SIZE_OFFSET);
+  const size_t mapping = size_t(load_u64(bytes, ROOT_MAPPINGS_OFFSET));
+  sz_test_bytes_t corrupt;
+
+  corrupt = bytes;
+  store_u64(&corrupt, ROOT_SIZE_OFFSET, ~uint64_t(0));
+  SZ_EXPECT(open_bytes(corrupt) == SZ_INVALID_ROOT);
+
+  corrupt = bytes;
+  store_u64(&corrupt, ROOT_DATA_OFFSET, size + 1);
+  SZ_EXPECT(open_bytes(corrupt) == SZ_INVALID_ROOT);
+
+  corrupt = bytes;
+  store_u64(&corrupt, mapping, uint64_t(9194292157618317844ULL));
+  SZ_EXPECT(open_bytes(corrupt) == SZ_INVALID_ROOT);
+}
+
+
+// A name table count larger than what's left of the snowball is rejected
+// before the table is allocated, truncated file or not.
+SZ_TEST(root_corrupt_name_table)
+{
+  sz_test_bytes_t bytes;
+  write_compound(&bytes, SZ_COMPACT_HEADERS);
+  SZ_EXPECT(open_bytes(bytes) == SZ_SUCCESS);
+
+  uint32_t num_compounds = 0;
+  memcpy(&num_compounds, &bytes[ROOT_COMPOUNDS_COUNT_OFFSET], sizeof(uint32_t));
+
+  const size_t count_off =
+    size_t(load_u64(bytes, ROOT_MAPPINGS_OFFSET))
+    + num_compounds * sizeof(uint64_t);
+  const uint32_t huge_count = 0x4C800000U;
+  uint32_t count = 0;
+  sz_test_bytes_t corrupt;
+
+  memcpy(&count, &bytes[count_off], sizeof(count));
+  SZ_EXPECT(count > 0);
+
+  corrupt.assign(bytes.begin(), bytes.begin() + count_off + sizeof(uint32_t));
+  memcpy(&corrupt[count_off], &huge_count, sizeof(huge_count));
+  SZ_EXPECT(open_bytes(corrupt) == SZ_INVALID_ROOT);
+
+  corrupt = bytes;
+  memcpy(&corrupt[count_off], &huge_count, sizeof(huge_count));
+  SZ_EXPECT(open_bytes(corrupt) == SZ_INVALID_ROOT);
+
+  // A table that fits the root's size but not the truncated file fails to
+  // read instead.
+  corrupt.assign(bytes.begin(), bytes.begin() + count_off + sizeof(uint32_t));
+  SZ_EXPECT(open_bytes(corrupt) != SZ_SUCCESS);
+}
+
+
+// Alignments past SZ_MAX_ALIGNMENT, up to shifts a uint64_t can't hold, are
+// rejected rather than used.
+SZ_TEST(root_corrupt_alignment)
+{
+  sz_test_bytes_t bytes;
+  write_compound(&bytes, 0);
+  sz_test_bytes_t corrupt = bytes;
+
+  // The flags are always little endian; the alignment exponent is byte 1.
+  corrupt[ROOT_FLAGS_OFFSET + 1] = 12;
+  SZ_EXPECT(open_bytes(corrupt) == SZ_SUCCESS);
+  corrupt[ROOT_FLAGS_OFFSET + 1] = 13;
+  SZ_EXPECT(open_bytes(corrupt) == SZ_INVALID_ROOT);
+  corrupt[ROOT_FLAGS_OFFSET + 1] = 200;
+  SZ_EXPECT(open_bytes(corrupt) == SZ_INVALID_ROOT);
+}
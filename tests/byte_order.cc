@@ -0,0 +1,77 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+#include "fixture.hh"
+
+
+// big_endian.sz is the fixture as a big-endian host would write it. It was
+// written on a little-endian host and had every field after the root's magic
+// number and flags byte-swapped, along with each array element and scalar.
+
+
+SZ_TEST(byte_order_little_endian)
+{
+  sz_test_bytes_t bytes;
+  sz_context_t *ctx = sz_new_context(SZ_WRITER, NULL);
+  sz_stream_t *stream = sz_test_memstream(&bytes);
+
+  sz_set_stream(ctx, stream);
+  SZ_EXPECT(sz_open(ctx) == SZ_SUCCESS);
+  sz_test_write_fixture(ctx);
+  SZ_EXPECT(sz_close(ctx) == SZ_SUCCESS);
+  sz_destroy_context(ctx);
+  sz_stream_close(stream);
+
+  sz_test_read_fixture(sz_test_memstream(&bytes), 0, sz_test_failures);
+}
+
+
+// A big-endian snowball reads back the same as a little-endian one, whether
+// it's read through the read-ahead buffer, preloaded, or in place in memory.
+SZ_TEST(byte_order_big_endian)
+{
+  const std::string path = sz_test_fixture("big_endian.sz");
+  sz_test_bytes_t bytes;
+
+  SZ_EXPECT(sz_test_load_fixture("big_endian.sz", &bytes));
+  if (bytes.size() < 8) {
+    return;
+  }
+
+  // The root flags are little endian and SZ_ROOT_BIG_ENDIAN is bit 2.
+  SZ_EXPECT((bytes[4] & 0x04) != 0);
+
+  sz_test_read_fixture(
+    sz_stream_fopen(path.c_str(), SZ_READER, NULL),
+    0,
+    sz_test_failures
+    );
+  sz_test_read_fixture(
+    sz_stream_fopen(path.c_str(), SZ_READER, NULL),
+    SZ_PRELOAD,
+    sz_test_failures
+    );
+  sz_test_read_fixture(
+    sz_stream_memopen(&bytes[0], bytes.size(), NULL),
+    0,
+    sz_test_failures
+    );
+}
@@ -0,0 +1,107 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+#include "tests.hh"
+#include "byteswap.hh"
+
+#include <cstdio>
+
+
+// Kernel combinations sz_byteswap() is run with, the portable loops first.
+struct byteswap_config_t
+{
+  bool avx2;
+  bool ssse3;
+  const char *name;
+};
+
+
+static const byteswap_config_t byteswap_configs[] = {
+  { false, false, "scalar" },
+  { false, true, "ssse3" },
+  { true, false, "avx2" },
+  { true, true, "avx2 + ssse3" }
+};
+
+
+// Every kernel swaps exactly what the portable loops do, whether it fills
+// whole vectors or leaves a tail for the next, in place or not.
+SZ_TEST(byteswap_simd_matches_scalar)
+{
+  static const size_t type_sizes[] = { 2, 4, 8 };
+  const size_t size_count = sizeof(type_sizes) / sizeof(type_sizes[0]);
+  const size_t config_count =
+    sizeof(byteswap_configs) / sizeof(byteswap_configs[0]);
+  uint32_t state = 12345;
+  sz_test_bytes_t input;
+  sz_test_bytes_t expected;
+  sz_test_bytes_t output;
+
+  for (size_t size = 0; size < size_count; ++size) {
+    const size_t type_size = type_sizes[size];
+
+    for (size_t count = 0; count < 300; count += (count < 80 ? 1 : 37)) {
+      input.resize(count * type_size + 1);
+      for (size_t index = 0; index < input.size(); ++index) {
+        state = state * 1664525U + 1013904223U;
+        input[index] = uint8_t(state >> 24);
+      }
+
+      // Reference: each element's bytes reversed, one at a time.
+      expected = input;
+      for (size_t element = 0; element < count; ++element) {
+        for (size_t byte = 0; byte < type_size; ++byte) {
+          expected[element * type_size + byte] =
+            input[element * type_size + type_size - 1 - byte];
+        }
+      }
+
+      for (size_t config = 0; config < config_count; ++config) {
+        const byteswap_config_t &kernels = byteswap_configs[config];
+        const int failures_before = *sz_test_failures;
+
+        sz_byteswap_use_simd(kernels.avx2, kernels.ssse3);
+
+        // The last byte is past the elements and must be left alone.
+        output.assign(input.size(), 0xA5);
+        output.back() = input.back();
+        sz_byteswap(&output[0], &input[0], count, type_size);
+        SZ_EXPECT(output == expected);
+
+        output = input;
+        sz_byteswap(&output[0], &output[0], count, type_size);
+        SZ_EXPECT(output == expected);
+
+        if (*sz_test_failures != failures_before) {
+          fprintf(
+            stderr,
+            "  with %s, %zu elements of %zu bytes\n",
+            kernels.name,
+            count,
+            type_size
+            );
+        }
+      }
+    }
+  }
+
+  sz_byteswap_use_simd(true, true);
+}
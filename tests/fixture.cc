@@ -0,0 +1,284 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+#include "fixture.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+static const size_t fixture_floats = 40;
+static const size_t fixture_ints = 40;
+static const size_t fixture_window = 16;
+static const size_t fixture_nodes = 4;
+static const char fixture_bytes[] = "snowball!";
+
+
+struct fixture_node_t
+{
+  int32_t value;
+  float weight;
+  fixture_node_t *next;
+};
+
+
+// Nodes read back so far -- compounds are read at most once each.
+struct fixture_pool_t
+{
+  fixture_node_t nodes[fixture_nodes];
+  size_t count;
+};
+
+
+static
+float
+fixture_float(size_t index)
+{
+  return float(index) * 0.5f - 7.25f;
+}
+
+
+static
+int32_t
+fixture_int(size_t index)
+{
+  const int32_t square = int32_t(index * index * 37);
+  return index % 2 ? -square : square;
+}
+
+
+static
+void
+write_node(void *compound, sz_context_t *ctx, void *writer_ctx)
+{
+  const fixture_node_t *node = (const fixture_node_t *)compound;
+  (void)writer_ctx;
+  sz_write_int(node->value, ctx, 'valu');
+  sz_write_float(node->weight, ctx, 'wght');
+  sz_write_compound(node->next, ctx, 'next', write_node, NULL);
+}
+
+
+static
+void
+read_node(void **compound, sz_context_t *ctx, void *reader_ctx)
+{
+  fixture_pool_t *const pool = (fixture_pool_t *)reader_ctx;
+  void *next = NULL;
+
+  if (pool->count == fixture_nodes) {
+    return;
+  }
+
+  fixture_node_t *const node = &pool->nodes[pool->count++];
+  // Set before reading next, in case next refers back to this node.
+  *compound = node;
+  sz_read_int(&node->value, ctx, 'valu');
+  sz_read_float(&node->weight, ctx, 'wght');
+  sz_read_compound(&next, ctx, 'next', read_node, pool);
+  node->next = (fixture_node_t *)next;
+}
+
+
+void
+sz_test_write_fixture(sz_context_t *ctx)
+{
+  float floats[fixture_floats];
+  int32_t ints[fixture_ints];
+  uint32_t uints[] = { 0, 1, 0x80000000U, 0xFFFFFFFFU, 0x01020304U };
+  fixture_node_t nodes[fixture_nodes] = {
+    { 10, 1.5f, &nodes[1] },
+    { 20, -2.0f, &nodes[2] },
+    { 30, 0.125f, NULL },
+    { 40, 1e20f, &nodes[1] }
+  };
+  void *array[] = { &nodes[3], &nodes[2] };
+
+  for (size_t index = 0; index < fixture_floats; ++index) {
+    floats[index] = fixture_float(index);
+  }
+
+  for (size_t index = 0; index < fixture_ints; ++index) {
+    ints[index] = fixture_int(index);
+  }
+
+  sz_write_int(-123456, ctx, 'int ');
+  sz_write_unsigned_int(0xDEADBEEFU, ctx, 'uint');
+  sz_write_float(3.25f, ctx, 'flt ');
+  sz_write_floats(floats, fixture_floats, ctx, 'flts');
+  sz_write_ints(ints, fixture_ints, ctx, 'ints');
+  sz_write_unsigned_ints(uints, sizeof(uints) / sizeof(uints[0]), ctx, 'unts');
+  sz_write_bytes(fixture_bytes, sizeof(fixture_bytes), ctx, 'byts');
+  sz_write_compound(&nodes[0], ctx, 'head', write_node, NULL);
+  sz_write_compounds(array, 2, ctx, 'nods', write_node, NULL);
+}
+
+
+void
+sz_test_check_fixture(sz_context_t *ctx, int *sz_test_failures)
+{
+  int32_t int_value = 0;
+  uint32_t uint_value = 0;
+  float float_value = 0.0f;
+  float *floats = NULL;
+  uint32_t *uints = NULL;
+  void *bytes = NULL;
+  void *head = NULL;
+  void **array = NULL;
+  size_t length = 0;
+  fixture_pool_t pool;
+
+  pool.count = 0;
+
+  SZ_EXPECT(sz_read_int(&int_value, ctx, 'int ') == SZ_SUCCESS);
+  SZ_EXPECT(int_value == -123456);
+  SZ_EXPECT(sz_read_unsigned_int(&uint_value, ctx, 'uint') == SZ_SUCCESS);
+  SZ_EXPECT(uint_value == 0xDEADBEEFU);
+  SZ_EXPECT(sz_read_float(&float_value, ctx, 'flt ') == SZ_SUCCESS);
+  SZ_EXPECT(float_value == 3.25f);
+
+  SZ_EXPECT(sz_read_floats(&floats, &length, ctx, 'flts', NULL) == SZ_SUCCESS);
+  SZ_EXPECT(length == fixture_floats && floats != NULL);
+  for (size_t index = 0; floats && index < length; ++index) {
+    SZ_EXPECT(floats[index] == fixture_float(index));
+  }
+  free(floats);
+
+  // Read in windows that don't divide the array evenly.
+  SZ_EXPECT(
+    sz_begin_array(&length, ctx, SZ_SINT32_CHUNK, 'ints') == SZ_SUCCESS
+    );
+  SZ_EXPECT(length == fixture_ints);
+  {
+    int32_t window[fixture_window];
+    size_t read = 0;
+    size_t count = 0;
+
+    do {
+      SZ_EXPECT(
+        sz_read_array_window(window, fixture_window, &count, ctx) == SZ_SUCCESS
+        );
+      for (size_t index = 0; index < count; ++index) {
+        SZ_EXPECT(window[index] == fixture_int(read + index));
+      }
+      read += count;
+    } while (count == fixture_window);
+
+    SZ_EXPECT(read == fixture_ints);
+  }
+  SZ_EXPECT(sz_end_array(ctx) == SZ_SUCCESS);
+
+  SZ_EXPECT(
+    sz_read_unsigned_ints(&uints, &length, ctx, 'unts', NULL) == SZ_SUCCESS
+    );
+  SZ_EXPECT(length == 5 && uints != NULL);
+  if (uints && length == 5) {
+    SZ_EXPECT(uints[0] == 0 && uints[1] == 1);
+    SZ_EXPECT(uints[2] == 0x80000000U && uints[3] == 0xFFFFFFFFU);
+    SZ_EXPECT(uints[4] == 0x01020304U);
+  }
+  free(uints);
+
+  SZ_EXPECT(sz_read_bytes(&bytes, &length, ctx, 'byts', NULL) == SZ_SUCCESS);
+  SZ_EXPECT(length == sizeof(fixture_bytes));
+  SZ_EXPECT(bytes && memcmp(bytes, fixture_bytes, length) == 0);
+  free(bytes);
+
+  SZ_EXPECT(
+    sz_read_compound(&head, ctx, 'head', read_node, &pool) == SZ_SUCCESS
+    );
+  SZ_EXPECT(sz_read_compounds(
+    &array,
+    &length,
+    ctx,
+    'nods',
+    read_node,
+    &pool,
+    NULL
+    ) == SZ_SUCCESS);
+  SZ_EXPECT(length == 2 && array != NULL && pool.count == fixture_nodes);
+
+  const fixture_node_t *const first = (const fixture_node_t *)head;
+  if (first && first->next && first->next->next && array && length == 2) {
+    const fixture_node_t *const second = first->next;
+    const fixture_node_t *const third = second->next;
+    const fixture_node_t *const fourth = (const fixture_node_t *)array[0];
+
+    SZ_EXPECT(first->value == 10 && first->weight == 1.5f);
+    SZ_EXPECT(second->value == 20 && second->weight == -2.0f);
+    SZ_EXPECT(third->value == 30 && third->weight == 0.125f);
+    SZ_EXPECT(third->next == NULL);
+    SZ_EXPECT(fourth->value == 40 && fourth->weight == 1e20f);
+    // Refs to a compound read back as the same object.
+    SZ_EXPECT(fourth->next == second);
+    SZ_EXPECT(array[1] == third);
+  } else {
+    SZ_EXPECT(!"compounds read back");
+  }
+  free(array);
+}
+
+
+void
+sz_test_read_fixture(
+  sz_stream_t *stream,
+  uint32_t flags,
+  int *sz_test_failures
+  )
+{
+  SZ_EXPECT(stream != NULL);
+  if (stream == NULL) {
+    return;
+  }
+
+  sz_context_t *ctx = sz_new_context(SZ_READER, NULL);
+
+  sz_set_flags(ctx, flags);
+  sz_set_stream(ctx, stream);
+  SZ_EXPECT(sz_open(ctx) == SZ_SUCCESS);
+  sz_test_check_fixture(ctx, sz_test_failures);
+  SZ_EXPECT(sz_close(ctx) == SZ_SUCCESS);
+
+  sz_destroy_context(ctx);
+  sz_stream_close(stream);
+}
+
+
+bool
+sz_test_load_fixture(const char *name, sz_test_bytes_t *bytes)
+{
+  FILE *const file = fopen(sz_test_fixture(name).c_str(), "rb");
+  uint8_t block[4096];
+  size_t length = 0;
+
+  if (file == NULL) {
+    return false;
+  }
+
+  bytes->clear();
+  while ((length = fread(block, 1, sizeof(block), file)) != 0) {
+    bytes->insert(bytes->end(), block, block + length);
+  }
+
+  fclose(file);
+  return true;
+}
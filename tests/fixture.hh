@@ -0,0 +1,59 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+#ifndef __SZ_SNOWBALL__FIXTURE_HH__
+#define __SZ_SNOWBALL__FIXTURE_HH__
+
+
+#include "tests.hh"
+
+
+// The snowball checked in under tests/fixtures in each format and byte order:
+// scalars, arrays (one read in windows), bytes, and compounds that refer to
+// each other. It only uses functions libsnowball 1.x had, so the same writer
+// made the SZ02 fixture.
+
+// Writes the fixture's contents to an open writer context.
+void
+sz_test_write_fixture(sz_context_t *ctx);
+
+// Reads the fixture's contents from an open reader context, counting anything
+// that isn't as written by sz_test_write_fixture() as a failure.
+void
+sz_test_check_fixture(sz_context_t *ctx, int *sz_test_failures);
+
+// Opens a reader on stream with the given flags, checks the fixture read from
+// it, and closes both. stream may be NULL, which counts as a failure.
+void
+sz_test_read_fixture(
+  sz_stream_t *stream,
+  uint32_t flags,
+  int *sz_test_failures
+  );
+
+// Reads the whole of the named file under tests/fixtures into bytes. Returns
+// false if it can't be opened.
+bool
+sz_test_load_fixture(const char *name, sz_test_bytes_t *bytes);
+
+
+#endif /* end __SZ_SNOWBALL__FIXTURE_HH__ include guard */
@@ -0,0 +1,191 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+#include "tests.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+
+static sz_test_t *sz_tests = NULL;
+static sz_test_t **sz_tests_tail = &sz_tests;
+
+
+sz_test_t::sz_test_t(const char *name_, function_t function_)
+: name(name_)
+, function(function_)
+, next(NULL)
+{
+  *sz_tests_tail = this;
+  sz_tests_tail = &next;
+}
+
+
+void
+sz_test_fail(const char *file, int line, const char *expression)
+{
+  fprintf(stderr, "%s:%d: expected %s\n", file, line, expression);
+}
+
+
+struct sz_test_memstream_t
+{
+  sz_stream_t base;
+  sz_test_bytes_t *bytes;
+  size_t pos;
+};
+
+
+static
+size_t
+sz_test_memstream_read(void *out, size_t length, sz_stream_t *stream)
+{
+  sz_test_memstream_t *mem = (sz_test_memstream_t *)stream;
+  const size_t available = mem->bytes->size() - mem->pos;
+
+  if (length > available) {
+    length = available;
+  }
+
+  if (length) {
+    memcpy(out, &(*mem->bytes)[mem->pos], length);
+    mem->pos += length;
+  }
+
+  return length;
+}
+
+
+static
+size_t
+sz_test_memstream_write(const void *in, size_t length, sz_stream_t *stream)
+{
+  sz_test_memstream_t *mem = (sz_test_memstream_t *)stream;
+
+  if (mem->pos + length > mem->bytes->size()) {
+    mem->bytes->resize(mem->pos + length);
+  }
+
+  if (length) {
+    memcpy(&(*mem->bytes)[mem->pos], in, length);
+    mem->pos += length;
+  }
+
+  return length;
+}
+
+
+static
+off_t
+sz_test_memstream_seek(off_t off, int whence, sz_stream_t *stream)
+{
+  sz_test_memstream_t *mem = (sz_test_memstream_t *)stream;
+  off_t pos = off;
+
+  switch (whence) {
+  case SEEK_CUR: pos += off_t(mem->pos); break;
+  case SEEK_END: pos += off_t(mem->bytes->size()); break;
+  default: break;
+  }
+
+  if (pos >= 0) {
+    mem->pos = size_t(pos);
+  }
+
+  return off_t(mem->pos);
+}
+
+
+static
+int
+sz_test_memstream_eof(sz_stream_t *stream)
+{
+  sz_test_memstream_t *mem = (sz_test_memstream_t *)stream;
+  return mem->pos >= mem->bytes->size();
+}
+
+
+static
+void
+sz_test_memstream_close(sz_stream_t *stream)
+{
+  free(stream);
+}
+
+
+sz_stream_t *
+sz_test_memstream(sz_test_bytes_t *bytes)
+{
+  // Zeroed so that the optional ops are NULL.
+  sz_test_memstream_t *mem =
+    (sz_test_memstream_t *)calloc(1, sizeof(sz_test_memstream_t));
+
+  mem->base.read = sz_test_memstream_read;
+  mem->base.write = sz_test_memstream_write;
+  mem->base.seek = sz_test_memstream_seek;
+  mem->base.eof = sz_test_memstream_eof;
+  mem->base.close = sz_test_memstream_close;
+  mem->bytes = bytes;
+
+  return &mem->base;
+}
+
+
+std::string
+sz_test_fixture(const char *name)
+{
+  const char *const dir = getenv("SZ_TEST_FIXTURES");
+  return std::string(dir ? dir : "tests/fixtures") + "/" + name;
+}
+
+
+int
+main(int argc, const char **argv)
+{
+  int failed = 0;
+
+  for (sz_test_t *test = sz_tests; test; test = test->next) {
+    int failures = 0;
+
+    // Any arguments name the tests to run.
+    if (argc > 1) {
+      bool selected = false;
+
+      for (int arg = 1; arg < argc; ++arg) {
+        selected = selected || strcmp(argv[arg], test->name) == 0;
+      }
+
+      if (!selected) {
+        continue;
+      }
+    }
+
+    test->function(&failures);
+    printf("%s %s\n", failures ? "FAIL" : "ok  ", test->name);
+
+    if (failures) {
+      ++failed;
+    }
+  }
+
+  return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,132 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+#include "tests.hh"
+
+#include <cstdlib>
+
+
+struct counting_allocator_t
+{
+  sz_allocator_t base;
+  size_t mallocs;
+};
+
+
+static
+void *
+counting_malloc(size_t size, sz_allocator_t *alloc)
+{
+  ++((counting_allocator_t *)alloc)->mallocs;
+  return malloc(size);
+}
+
+
+static
+void
+counting_free(void *ptr, sz_allocator_t *alloc)
+{
+  (void)alloc;
+  free(ptr);
+}
+
+
+struct item_t
+{
+  int32_t id;
+  float weight;
+  uint32_t flags;
+};
+
+
+static
+void
+write_item(void *compound, sz_context_t *ctx, void *writer_ctx)
+{
+  const item_t *item = (const item_t *)compound;
+  (void)writer_ctx;
+  sz_write_int(item->id, ctx, 'id  ');
+  sz_write_float(item->weight, ctx, 'wght');
+  sz_write_unsigned_int(item->flags, ctx, 'flgs');
+}
+
+
+// Once a context has written a snowball, writing another of the same shape
+// after resetting it shouldn't allocate, whatever its flags.
+SZ_TEST(reset_context_reuses_memory)
+{
+  static const size_t item_count = 2000;
+  static const uint32_t flag_sets[] = {
+    0,
+    SZ_STREAMING_WRITES,
+    SZ_NAME_INDEX,
+    SZ_COMPACT_HEADERS,
+    SZ_STREAMING_WRITES | SZ_NAME_INDEX,
+    SZ_STREAMING_WRITES | SZ_NAME_INDEX | SZ_COMPACT_HEADERS
+  };
+
+  std::vector<item_t> items(item_count);
+  std::vector<void *> pointers(item_count);
+
+  for (size_t index = 0; index < item_count; ++index) {
+    items[index].id = int32_t(index);
+    items[index].weight = float(index) * 0.5f;
+    items[index].flags = uint32_t(index) * 7U;
+    pointers[index] = &items[index];
+  }
+
+  sz_test_bytes_t bytes;
+
+  for (size_t set = 0; set < sizeof(flag_sets) / sizeof(flag_sets[0]); ++set) {
+    counting_allocator_t alloc = { { counting_malloc, counting_free }, 0 };
+    sz_context_t *ctx = sz_new_context(SZ_WRITER, &alloc.base);
+    size_t last_round = 0;
+
+    SZ_EXPECT(sz_set_flags(ctx, flag_sets[set]) == SZ_SUCCESS);
+
+    for (int round = 0; round < 3; ++round) {
+      // The stream's own memory isn't the context's, so isn't counted.
+      sz_stream_t *stream = sz_test_memstream(&bytes);
+      const size_t before = alloc.mallocs;
+
+      bytes.clear();
+      sz_set_stream(ctx, stream);
+      SZ_EXPECT(sz_open(ctx) == SZ_SUCCESS);
+      SZ_EXPECT(sz_write_compounds(
+        &pointers[0],
+        item_count,
+        ctx,
+        'itms',
+        write_item,
+        NULL
+        ) == SZ_SUCCESS);
+      SZ_EXPECT(sz_close(ctx) == SZ_SUCCESS);
+      SZ_EXPECT(sz_reset_context(ctx) == SZ_SUCCESS);
+
+      last_round = alloc.mallocs - before;
+      sz_stream_close(stream);
+    }
+
+    SZ_EXPECT(last_round == 0);
+
+    sz_destroy_context(ctx);
+  }
+}
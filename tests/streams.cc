@@ -0,0 +1,125 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+#include "fixture.hh"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+
+
+static const uint32_t stream_alignment = 64;
+static const size_t stream_view_floats = 100;
+
+
+// Writes the fixture followed by a float array for viewing to fd.
+static
+void
+write_fd(int fd, int *sz_test_failures)
+{
+  float values[stream_view_floats];
+  sz_context_t *ctx = sz_new_context(SZ_WRITER, NULL);
+  sz_stream_t *stream = sz_stream_fdopen(fd, SZ_WRITER, NULL);
+
+  for (size_t index = 0; index < stream_view_floats; ++index) {
+    values[index] = float(index) * 0.25f;
+  }
+
+  SZ_EXPECT(stream != NULL);
+  SZ_EXPECT(sz_set_alignment(ctx, stream_alignment) == SZ_SUCCESS);
+  sz_set_stream(ctx, stream);
+  SZ_EXPECT(sz_open(ctx) == SZ_SUCCESS);
+  sz_test_write_fixture(ctx);
+  SZ_EXPECT(
+    sz_write_floats(values, stream_view_floats, ctx, 'view') == SZ_SUCCESS
+    );
+  SZ_EXPECT(sz_close(ctx) == SZ_SUCCESS);
+
+  sz_destroy_context(ctx);
+  sz_stream_close(stream);
+}
+
+
+// Reads the fixture and views the float array after it, which the alignment
+// places on a stream_alignment boundary of the mapping.
+static
+void
+read_mapped(const char *path, uint32_t flags, int *sz_test_failures)
+{
+  sz_context_t *ctx = sz_new_context(SZ_READER, NULL);
+  sz_stream_t *stream = sz_stream_mmap(path, NULL);
+  const float *view = NULL;
+  size_t length = 0;
+
+  SZ_EXPECT(stream != NULL);
+  if (stream == NULL) {
+    sz_destroy_context(ctx);
+    return;
+  }
+
+  sz_set_flags(ctx, flags);
+  sz_set_stream(ctx, stream);
+  SZ_EXPECT(sz_open(ctx) == SZ_SUCCESS);
+  sz_test_check_fixture(ctx, sz_test_failures);
+  SZ_EXPECT(sz_read_floats_view(&view, &length, ctx, 'view') == SZ_SUCCESS);
+  SZ_EXPECT(length == stream_view_floats && view != NULL);
+  SZ_EXPECT(uintptr_t(view) % stream_alignment == 0);
+  for (size_t index = 0; view && index < length; ++index) {
+    SZ_EXPECT(view[index] == float(index) * 0.25f);
+  }
+  SZ_EXPECT(sz_close(ctx) == SZ_SUCCESS);
+
+  sz_destroy_context(ctx);
+  sz_stream_close(stream);
+}
+
+
+// A snowball written with alignment through a descriptor reads back through a
+// mapping, in place and with SZ_PRELOAD, and through the descriptor again.
+SZ_TEST(stream_fd_mmap_round_trip)
+{
+  char path[] = "/tmp/sz_test_XXXXXX";
+  const int fd = mkstemp(path);
+
+  SZ_EXPECT(fd >= 0);
+  if (fd < 0) {
+    return;
+  }
+
+  write_fd(fd, sz_test_failures);
+
+  read_mapped(path, 0, sz_test_failures);
+  read_mapped(path, SZ_PRELOAD, sz_test_failures);
+  sz_test_read_fixture(
+    sz_stream_fdopen(fd, SZ_READER, NULL),
+    0,
+    sz_test_failures
+    );
+  sz_test_read_fixture(
+    sz_stream_fdopen(fd, SZ_READER, NULL),
+    SZ_PRELOAD,
+    sz_test_failures
+    );
+
+  close(fd);
+  unlink(path);
+}
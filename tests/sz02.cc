@@ -0,0 +1,58 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+#include "fixture.hh"
+
+#include <cstring>
+
+
+// sz02.sz is the fixture as written by libsnowball 1.x, in the SZ02 format
+// with 32-bit sizes and offsets throughout. 1.x's sz_write_bytes wrote no
+// payload, so its 'byts' chunk was written directly in the layout that 1.x's
+// sz_read_bytes expects.
+SZ_TEST(sz02_fixture)
+{
+  const std::string path = sz_test_fixture("sz02.sz");
+  sz_test_bytes_t bytes;
+
+  SZ_EXPECT(sz_test_load_fixture("sz02.sz", &bytes));
+  if (bytes.size() < 4) {
+    return;
+  }
+
+  SZ_EXPECT(memcmp(&bytes[0], "SZ02", 4) == 0);
+
+  sz_test_read_fixture(
+    sz_stream_fopen(path.c_str(), SZ_READER, NULL),
+    0,
+    sz_test_failures
+    );
+  sz_test_read_fixture(
+    sz_stream_fopen(path.c_str(), SZ_READER, NULL),
+    SZ_PRELOAD,
+    sz_test_failures
+    );
+  sz_test_read_fixture(
+    sz_stream_memopen(&bytes[0], bytes.size(), NULL),
+    0,
+    sz_test_failures
+    );
+}
@@ -0,0 +1,84 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+
+#ifndef __SZ_SNOWBALL__TESTS_HH__
+#define __SZ_SNOWBALL__TESTS_HH__
+
+
+#include <snowball.h>
+
+#include <string>
+#include <vector>
+
+
+typedef std::vector<uint8_t> sz_test_bytes_t;
+
+
+// A test case. Cases register themselves on construction and are run in
+// registration order by main.
+struct sz_test_t
+{
+  typedef void (*function_t)(int *failures);
+
+  const char *name;
+  function_t function;
+  sz_test_t *next;
+
+  sz_test_t(const char *name, function_t function);
+};
+
+
+// Defines a test case named NAME. SZ_EXPECT may be used in its body.
+#define SZ_TEST(NAME)                                                        \
+  static void sz_test_##NAME(int *sz_test_failures);                         \
+  static sz_test_t sz_test_case_##NAME(#NAME, sz_test_##NAME);               \
+  static void sz_test_##NAME(int *sz_test_failures)
+
+
+// Counts a failure and reports where it happened if COND is false.
+#define SZ_EXPECT(COND)                                                      \
+  do {                                                                       \
+    if (!(COND)) {                                                           \
+      sz_test_fail(__FILE__, __LINE__, #COND);                               \
+      ++*sz_test_failures;                                                   \
+    }                                                                        \
+  } while (0)
+
+
+void
+sz_test_fail(const char *file, int line, const char *expression);
+
+
+// Returns a stream that writes to and reads from bytes, which must outlive
+// it. Closing the stream leaves bytes as written.
+sz_stream_t *
+sz_test_memstream(sz_test_bytes_t *bytes);
+
+
+// Returns the path of a file checked in under tests/fixtures. The directory is
+// taken from the SZ_TEST_FIXTURES environment variable if it's set, otherwise
+// it's relative to the working directory, as when run from the repository.
+std::string
+sz_test_fixture(const char *name);
+
+
+#endif /* end __SZ_SNOWBALL__TESTS_HH__ include guard */
@@ -0,0 +1,321 @@
+/*
+  Copyright (c) 2014 Noel R. Cower
+
+  Permission is hereby granted, free of charge, to any person obtaining
+  a copy of this software and associated documentation files (the "Software"),
+  to deal in the Software without restriction, including without limitation
+  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+  and/or sell copies of the Software, and to permit persons to whom
+  the Software is furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included
+  in all copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+  THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USEOR OTHER DEALINGS
+  IN THE SOFTWARE.
+*/
+#include "tests.hh"
+
+#include <cstdlib>
+#include <cstring>
+
+
+static const size_t item_count = 3000;
+static const size_t part_count = 40;
+
+
+struct parallel_part_t
+{
+  uint32_t id;
+};
+
+
+struct parallel_item_t
+{
+  int32_t id;
+  int32_t value;
+  parallel_part_t *part;
+};
+
+
+// Field names vary from one compound to the next so that with compact headers,
+// threads come across new names in different orders.
+static
+uint32_t
+item_value_name(int32_t id)
+{
+  return 'v000' + uint32_t(id % 37);
+}
+
+
+static
+uint32_t
+part_value_name(uint32_t id)
+{
+  return 'p000' + id;
+}
+
+
+static
+void
+write_part(void *compound, sz_context_t *ctx, void *writer_ctx)
+{
+  const parallel_part_t *part = (const parallel_part_t *)compound;
+  (void)writer_ctx;
+  sz_write_unsigned_int(part->id, ctx, 'id  ');
+  sz_write_unsigned_int(part->id * 5, ctx, part_value_name(part->id));
+}
+
+
+static
+void
+write_item(void *compound, sz_context_t *ctx, void *writer_ctx)
+{
+  const parallel_item_t *item = (const parallel_item_t *)compound;
+  (void)writer_ctx;
+  sz_write_int(item->id, ctx, 'id  ');
+  sz_write_int(item->value, ctx, item_value_name(item->id));
+  sz_write_compound(item->part, ctx, 'part', write_part, NULL);
+}
+
+
+static
+void
+read_part(void **compound, sz_context_t *ctx, void *reader_ctx)
+{
+  parallel_part_t *const parts = (parallel_part_t *)reader_ctx;
+  uint32_t id = 0;
+  uint32_t value = 0;
+
+  if (   sz_read_unsigned_int(&id, ctx, 'id  ') == SZ_SUCCESS
+      && id < part_count
+      && sz_read_unsigned_int(&value, ctx, part_value_name(id)) == SZ_SUCCESS
+      && value == id * 5) {
+    parts[id].id = id;
+    *compound = &parts[id];
+  }
+}
+
+
+struct parallel_read_t
+{
+  parallel_item_t *items;
+  parallel_part_t *parts;
+};
+
+
+static
+void
+read_item(void **compound, sz_context_t *ctx, void *reader_ctx)
+{
+  const parallel_read_t *const read = (const parallel_read_t *)reader_ctx;
+  int32_t id = -1;
+
+  if (   sz_read_int(&id, ctx, 'id  ') != SZ_SUCCESS
+      || id < 0
+      || size_t(id) >= item_count) {
+    return;
+  }
+
+  parallel_item_t *const item = &read->items[id];
+  void *part = NULL;
+
+  item->id = id;
+  sz_read_int(&item->value, ctx, item_value_name(id));
+  sz_read_compound(&part, ctx, 'part', read_part, read->parts);
+  item->part = (parallel_part_t *)part;
+  *compound = item;
+}
+
+
+static
+void
+write_items(
+  sz_test_bytes_t *bytes,
+  std::vector<void *> &pointers,
+  uint32_t flags,
+  size_t num_threads
+  )
+{
+  sz_context_t *ctx = sz_new_context(SZ_WRITER, NULL);
+  sz_stream_t *stream = sz_test_memstream(bytes);
+
+  bytes->clear();
+  sz_set_flags(ctx, flags);
+  sz_set_stream(ctx, stream);
+  sz_open(ctx);
+  // In the name table before the workers start.
+  sz_write_int(1, ctx, item_value_name(0));
+  sz_write_compounds_parallel(
+    &pointers[0],
+    pointers.size(),
+    ctx,
+    'itms',
+    write_item,
+    NULL,
+    num_threads
+    );
+  sz_close(ctx);
+  sz_destroy_context(ctx);
+  sz_stream_close(stream);
+}
+
+
+// Parallel writes produce the same bytes however many threads write them and
+// however the threads interleave, and read back like any other snowball.
+SZ_TEST(write_parallel_deterministic)
+{
+  static const uint32_t flag_sets[] = {
+    0,
+    SZ_COMPACT_HEADERS,
+    SZ_STREAMING_WRITES | SZ_NAME_INDEX | SZ_COMPACT_HEADERS
+  };
+  static const size_t thread_counts[] = { 2, 3, 8 };
+
+  std::vector<parallel_part_t> parts(part_count);
+  std::vector<parallel_item_t> items(item_count);
+  std::vector<void *> pointers(item_count);
+
+  for (size_t index = 0; index < part_count; ++index) {
+    parts[index].id = uint32_t(index);
+  }
+
+  for (size_t index = 0; index < item_count; ++index) {
+    items[index].id = int32_t(index);
+    items[index].value = int32_t(index) * 3;
+    items[index].part = &parts[(index * 7) % part_count];
+    pointers[index] = &items[index];
+  }
+
+  for (size_t set = 0; set < sizeof(flag_sets) / sizeof(flag_sets[0]); ++set) {
+    sz_test_bytes_t expected;
+    sz_test_bytes_t bytes;
+
+    write_items(&expected, pointers, flag_sets[set], 1);
+    SZ_EXPECT(!expected.empty());
+
+    for (int round = 0; round < 4; ++round) {
+      for (size_t count = 0; count < 3; ++count) {
+        write_items(&bytes, pointers, flag_sets[set], thread_counts[count]);
+        SZ_EXPECT(bytes == expected);
+      }
+    }
+
+    std::vector<parallel_part_t> read_parts(part_count);
+    std::vector<parallel_item_t> read_items(item_count);
+    parallel_read_t read = { &read_items[0], &read_parts[0] };
+    sz_context_t *ctx = sz_new_context(SZ_READER, NULL);
+    sz_stream_t *stream = sz_test_memstream(&expected);
+    void **compounds = NULL;
+    size_t length = 0;
+    int32_t first = 0;
+
+    sz_set_stream(ctx, stream);
+    SZ_EXPECT(sz_open(ctx) == SZ_SUCCESS);
+    SZ_EXPECT(sz_read_int(&first, ctx, item_value_name(0)) == SZ_SUCCESS);
+    SZ_EXPECT(sz_read_compounds(
+      &compounds,
+      &length,
+      ctx,
+      'itms',
+      read_item,
+      &read,
+      NULL
+      ) == SZ_SUCCESS);
+    SZ_EXPECT(length == item_count);
+
+    for (size_t index = 0; index < length; ++index) {
+      const parallel_item_t *const item =
+        (const parallel_item_t *)compounds[index];
+      SZ_EXPECT(item == &read_items[index]);
+      SZ_EXPECT(item != NULL && item->value == int32_t(index) * 3);
+      SZ_EXPECT(
+        item != NULL
+        && item->part == &read_parts[(index * 7) % part_count]
+        );
+    }
+
+    sz_destroy_context(ctx);
+    sz_stream_close(stream);
+    free(compounds);
+  }
+}
+
+
+// Fails to write any item whose id is a multiple of 1000 by writing an array
+// longer than a snowball can hold.
+static
+void
+write_failing_item(void *compound, sz_context_t *ctx, void *writer_ctx)
+{
+  const parallel_item_t *item = (const parallel_item_t *)compound;
+  (void)writer_ctx;
+  sz_write_int(item->id, ctx, 'id  ');
+
+  if (item->id % 1000 == 999) {
+    int32_t value = item->id;
+    sz_write_ints(&value, size_t(0x100000000ULL), ctx, 'long');
+  }
+}
+
+
+// A writer that fails on a worker fails the parallel write with the same
+// error a serial write leaves on the context.
+SZ_TEST(write_parallel_writer_error)
+{
+  std::vector<parallel_item_t> items(item_count);
+  std::vector<void *> pointers(item_count);
+
+  for (size_t index = 0; index < item_count; ++index) {
+    items[index].id = int32_t(index);
+    items[index].value = 0;
+    items[index].part = NULL;
+    pointers[index] = &items[index];
+  }
+
+  sz_test_bytes_t bytes;
+  sz_context_t *ctx = sz_new_context(SZ_WRITER, NULL);
+  sz_stream_t *stream = sz_test_memstream(&bytes);
+
+  sz_set_stream(ctx, stream);
+  SZ_EXPECT(sz_open(ctx) == SZ_SUCCESS);
+  sz_write_compounds(
+    &pointers[0],
+    item_count,
+    ctx,
+    'itms',
+    write_failing_item,
+    NULL
+    );
+  const char *const serial_error = sz_get_error(ctx);
+  SZ_EXPECT(strcmp(serial_error, "No error.") != 0);
+  sz_destroy_context(ctx);
+  sz_stream_close(stream);
+
+  for (size_t num_threads = 1; num_threads <= 8; num_threads *= 2) {
+    ctx = sz_new_context(SZ_WRITER, NULL);
+    stream = sz_test_memstream(&bytes);
+    bytes.clear();
+
+    sz_set_stream(ctx, stream);
+    SZ_EXPECT(sz_open(ctx) == SZ_SUCCESS);
+    SZ_EXPECT(sz_write_compounds_parallel(
+      &pointers[0],
+      item_count,
+      ctx,
+      'itms',
+      write_failing_item,
+      NULL,
+      num_threads
+      ) == SZ_ERROR_INVALID_OPERATION);
+    SZ_EXPECT(strcmp(sz_get_error(ctx), serial_error) == 0);
+
+    sz_destroy_context(ctx);
+    sz_stream_close(stream);
+  }
+}